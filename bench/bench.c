@@ -0,0 +1,43 @@
+#include "bench.h"
+#include <stdio.h>
+#include "pico/stdlib.h"
+
+void bench_run(bench_result_t *r, const char *name, bench_fn fn, void *ctx, uint32_t iters){
+    r->name = name;
+    r->iters = iters;
+    r->total_us = 0;
+    r->min_us = UINT32_MAX;
+    r->max_us = 0;
+    r->transactions = 0;
+    r->bytes = 0;
+
+    for (uint32_t i = 0; i < iters; i++) {
+        uint32_t start = time_us_32();
+        fn(ctx);
+        uint32_t took = time_us_32() - start;
+
+        r->total_us += took;
+        if (took < r->min_us) r->min_us = took;
+        if (took > r->max_us) r->max_us = took;
+    }
+}
+
+void bench_print_header(void){
+    printf("\n%-16s %6s %8s %8s %8s %6s %6s %8s %8s\n", "bench", "iters", "avg_us", "min_us", "max_us", "tx", "bytes", "wire_us", "other_us");
+}
+
+void bench_print(const bench_result_t *r, const i2c_bus_t *bus){
+    if (r->iters == 0) return;
+    unsigned long avg = (unsigned long)(r->total_us / r->iters);
+    printf("%-16s %6lu %8lu %8lu %8lu", r->name, (unsigned long)r->iters, avg, (unsigned long)r->min_us, (unsigned long)r->max_us);
+
+    if (!bus || r->transactions == 0) {
+        printf(" %6s %6s %8s %8s\n", "-", "-", "-", "-");
+        return;
+    }
+    //per iteration
+    uint32_t tx = r->transactions / r->iters;
+    uint32_t bytes = r->bytes / r->iters;
+    uint32_t wire = i2c_bus_wire_us(bus, r->transactions, r->bytes) / r->iters;
+    printf(" %6lu %6lu %8lu %8ld\n", (unsigned long)tx, (unsigned long)bytes, (unsigned long)wire, (long)avg - (long)wire);
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <stdint.h>
+#include "i2c_bus.h"
+
+/*
+  On-target micro benchmarks, built with GREENEYE_BENCH.
+  - Times a function over a number of iterations on the hardware timer
+  - When the bus traffic of the run is known, the report splits wall time into modelled
+    wire time (i2c_bus_wire_us) and everything else: cpu, driver overhead, clock stretching
+*/
+
+typedef void (*bench_fn)(void *ctx);
+
+typedef struct {
+    const char *name;
+    uint32_t iters;
+    uint64_t total_us;
+    uint32_t min_us;
+    uint32_t max_us;
+
+    //bus traffic over the whole run; fill in after bench_run if known, leave 0 for cpu-only cases
+    uint32_t transactions;
+    uint32_t bytes;
+} bench_result_t;
+
+//calls fn iters times, timing each call
+void bench_run(bench_result_t *r, const char *name, bench_fn fn, void *ctx, uint32_t iters);
+
+void bench_print_header(void);
+
+//one line: per-iteration average/min/max and, with traffic, wire vs other time; bus may be NULL
+void bench_print(const bench_result_t *r, const i2c_bus_t *bus);
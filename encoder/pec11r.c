@@ -1,7 +1,10 @@
 #include "pec11r.h"
 #include "hardware/gpio.h"
+#include "hardware/irq.h"
 #include "pico/stdlib.h"
 
+#define SW_DEBOUNCE_US 20000 //20 ms debounce
+
 void pec11r_init(pec11r_t *dev, uint32_t gpio_a, uint32_t gpio_b, uint32_t gpio_sw){
     dev->gpio_a = gpio_a;
     dev->gpio_b = gpio_b;
@@ -34,6 +37,13 @@ void pec11r_init(pec11r_t *dev, uint32_t gpio_a, uint32_t gpio_b, uint32_t gpio_
 
     dev->edge_accum = 0;
     dev->edge_per_detent = 4;
+
+    dev->irq_mode = false;
+    dev->position = 0;
+    dev->evt_head = 0;
+    dev->evt_tail = 0;
+    dev->evt_dropped = 0;
+    dev->sw_recheck = false;
 }
 
 //read and return raw ab value
@@ -54,7 +64,7 @@ bool pec11r_sw_pressed(pec11r_t *dev) {
     bool sw_curr = gpio_get(dev->gpio_sw);
 
     if (dev->sw_prev != sw_curr){ //if state changed
-        if(now - dev->last_sw_change_us >= 20000){ //20 ms debounce
+        if(now - dev->last_sw_change_us >= SW_DEBOUNCE_US){
             dev->sw_prev = sw_curr;
             dev->last_sw_change_us = now;
             if (sw_curr == 0){ //if falling edge from not-presssed -> pressed
@@ -92,9 +102,8 @@ static const int8_t enc_dir_lut[16] ={
 ----------------------------------
 */
 
-//returns 1, 0, -1 for direction (CW, no change, CCW)
-int pec11r_update(pec11r_t *dev){
-    uint8_t curr = pec11r_read_ab(dev);
+//helper; direction of the move from the last ab value to curr
+static int pec11r_step(pec11r_t *dev, uint8_t curr){
     uint8_t index = (uint8_t)((dev->ab_prev<<2) | curr);
 
     int8_t step = enc_dir_lut[index];
@@ -103,8 +112,8 @@ int pec11r_update(pec11r_t *dev){
     return (int)step;
 }
 
-int pec11r_detent_poll(pec11r_t *dev){ //return change only after full detent
-    int step = pec11r_update(dev);
+//helper; adds an edge and returns +1/-1 once a full detent has accumulated
+static int pec11r_accumulate(pec11r_t *dev, int step){
     if(step == 0){ return 0; }
 
     dev->edge_accum += step;
@@ -118,4 +127,139 @@ int pec11r_detent_poll(pec11r_t *dev){ //return change only after full detent
         return -1;
     }
     return 0;
-}
\ No newline at end of file
+}
+
+//returns 1, 0, -1 for direction (CW, no change, CCW)
+int pec11r_update(pec11r_t *dev){
+    return pec11r_step(dev, pec11r_read_ab(dev));
+}
+
+int pec11r_detent_poll(pec11r_t *dev){ //return change only after full detent
+    return pec11r_accumulate(dev, pec11r_update(dev));
+}
+
+//------------- BACKGROUND (IRQ) DECODING -------------
+
+static pec11r_t *irq_devs[PEC11R_MAX_IRQ_DEVS];
+
+//helper; single producer (irq) ring, so head only moves here and tail only in pec11r_event_pop
+static void pec11r_push_event(pec11r_t *dev, pec11r_event_t evt){
+    uint8_t head = dev->evt_head;
+    uint8_t next = (uint8_t)((head + 1) & (PEC11R_EVT_QUEUE - 1));
+    if(next == dev->evt_tail){ //full; keep the older events
+        dev->evt_dropped++;
+        return;
+    }
+    dev->events[head] = (uint8_t)evt;
+    __compiler_memory_barrier(); //slot is written before the reader can see it
+    dev->evt_head = next;
+}
+
+static int64_t pec11r_sw_recheck(alarm_id_t id, void *user_data);
+
+//helper; switch level seen at now. changes inside the debounce window after an accepted change are bounce,
+//but the edge that settles the switch may be one of them (a quick tap's release), so the level is read
+//again once the window closes
+static void pec11r_sw_sample(pec11r_t *dev, bool sw_curr, uint32_t now){
+    if(sw_curr == dev->sw_prev){ return; }
+
+    uint32_t since = now - dev->last_sw_change_us;
+    if(since < SW_DEBOUNCE_US){
+        if(!dev->sw_recheck){
+            dev->sw_recheck = true;
+            if(add_alarm_in_us(SW_DEBOUNCE_US - since, pec11r_sw_recheck, dev, true) < 0){
+                dev->sw_recheck = false; //no alarm available; the next edge gets looked at as before
+            }
+        }
+        return;
+    }
+
+    dev->sw_prev = sw_curr;
+    dev->last_sw_change_us = now;
+    if(sw_curr == 0 && !dev->sw_held){ //falling edge: pressed
+        dev->sw_held = true;
+        pec11r_push_event(dev, PEC11R_EVT_PRESS);
+    } else if(sw_curr == 1){
+        dev->sw_held = false;
+    }
+}
+
+//alarm callback; debounce window is over, whatever level the switch sits at now is real
+static int64_t pec11r_sw_recheck(alarm_id_t id, void *user_data){
+    pec11r_t *dev = (pec11r_t *)user_data;
+    dev->sw_recheck = false;
+    pec11r_sw_sample(dev, gpio_get(dev->gpio_sw), time_us_32());
+    return 0; //one shot
+}
+
+//shared handler for every pin of every registered encoder; runs on each A/B/switch edge
+static void pec11r_gpio_irq_handler(void){
+    uint32_t pins = gpio_get_all(); //one snapshot so A and B are read at the same instant
+    uint32_t now = time_us_32();
+
+    for(int i = 0; i < PEC11R_MAX_IRQ_DEVS; i++){
+        pec11r_t *dev = irq_devs[i];
+        if(!dev){ continue; }
+
+        uint32_t ev_a = gpio_get_irq_event_mask(dev->gpio_a);
+        uint32_t ev_b = gpio_get_irq_event_mask(dev->gpio_b);
+        if(ev_a){ gpio_acknowledge_irq(dev->gpio_a, ev_a); }
+        if(ev_b){ gpio_acknowledge_irq(dev->gpio_b, ev_b); }
+
+        if(ev_a || ev_b){
+            uint8_t curr = (uint8_t)((((pins >> dev->gpio_a) & 1u) << 1) | ((pins >> dev->gpio_b) & 1u));
+            int detent = pec11r_accumulate(dev, pec11r_step(dev, curr)); //same lut and detent logic as polling
+            if(detent != 0){
+                dev->position += detent;
+                pec11r_push_event(dev, (detent > 0) ? PEC11R_EVT_CW : PEC11R_EVT_CCW);
+            }
+        }
+
+        if(dev->gpio_sw == UINT32_MAX){ continue; }
+        uint32_t ev_sw = gpio_get_irq_event_mask(dev->gpio_sw);
+        if(!ev_sw){ continue; }
+        gpio_acknowledge_irq(dev->gpio_sw, ev_sw);
+
+        pec11r_sw_sample(dev, (pins >> dev->gpio_sw) & 1u, now);
+    }
+}
+
+bool pec11r_irq_enable(pec11r_t *dev){
+    int slot = -1;
+    for(int i = 0; i < PEC11R_MAX_IRQ_DEVS; i++){
+        if(irq_devs[i] == dev){ return true; } //already enabled
+        if(!irq_devs[i] && slot < 0){ slot = i; }
+    }
+    if(slot < 0){ return false; }
+
+    dev->ab_prev = pec11r_read_ab(dev); //start from where the shaft is now
+    dev->edge_accum = 0;
+    dev->irq_mode = true;
+    irq_devs[slot] = dev;
+
+    uint32_t mask = (1u << dev->gpio_a) | (1u << dev->gpio_b);
+    if(dev->gpio_sw != UINT32_MAX){ mask |= 1u << dev->gpio_sw; }
+    gpio_add_raw_irq_handler_masked(mask, pec11r_gpio_irq_handler);
+
+    const uint32_t edges = GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL;
+    gpio_set_irq_enabled(dev->gpio_a, edges, true);
+    gpio_set_irq_enabled(dev->gpio_b, edges, true);
+    if(dev->gpio_sw != UINT32_MAX){ gpio_set_irq_enabled(dev->gpio_sw, edges, true); }
+    irq_set_enabled(IO_IRQ_BANK0, true);
+    return true;
+}
+
+int32_t pec11r_position(const pec11r_t *dev){
+    return dev->position; //single word; read is atomic
+}
+
+bool pec11r_event_pop(pec11r_t *dev, pec11r_event_t *evt){
+    uint8_t tail = dev->evt_tail;
+    if(tail == dev->evt_head){ return false; }
+    __compiler_memory_barrier(); //slot is read only after head says it's filled
+
+    *evt = (pec11r_event_t)dev->events[tail];
+    __compiler_memory_barrier(); //and before the slot is handed back to the irq
+    dev->evt_tail = (uint8_t)((tail + 1) & (PEC11R_EVT_QUEUE - 1));
+    return true;
+}
@@ -2,6 +2,16 @@
 #include <stdint.h>
 #include <stdbool.h> 
 
+#define PEC11R_EVT_QUEUE 16 //power of two; events beyond this are dropped until the queue is drained
+#define PEC11R_MAX_IRQ_DEVS 2 //encoders that can decode in the background at once
+
+//events produced by background decoding
+typedef enum {
+    PEC11R_EVT_CW = 0, //one detent clockwise
+    PEC11R_EVT_CCW = 1, //one detent counter-clockwise
+    PEC11R_EVT_PRESS = 2 //debounced switch press
+} pec11r_event_t;
+
 typedef struct{
     uint32_t gpio_a;
     uint32_t gpio_b;
@@ -12,9 +22,18 @@ typedef struct{
     bool sw_prev;
     uint32_t last_sw_change_us;
     bool sw_held;
+    volatile bool sw_recheck; //irq mode: an alarm re-reads the switch when the debounce window closes
 
     int8_t edge_accum;
     uint8_t edge_per_detent;
+
+    //background decoding; written from the gpio irq, read from the main loop
+    bool irq_mode;
+    volatile int32_t position; //detents, cw positive
+    volatile uint8_t evt_head; //next slot the irq writes
+    volatile uint8_t evt_tail; //next slot the reader takes
+    uint8_t events[PEC11R_EVT_QUEUE];
+    volatile uint32_t evt_dropped; //events lost to a full queue
 } pec11r_t;
 
 void pec11r_init(pec11r_t *dev, uint32_t gpio_a, uint32_t gpio_b, uint32_t gpio_sw);
@@ -26,3 +45,12 @@ bool pec11r_sw_pressed(pec11r_t *dev);
 int pec11r_update(pec11r_t *dev);
 
 int pec11r_detent_poll(pec11r_t *dev);
+
+//decode A/B and the switch from gpio edge interrupts from now on; polling functions should no longer be called
+bool pec11r_irq_enable(pec11r_t *dev);
+
+//detent count kept by background decoding
+int32_t pec11r_position(const pec11r_t *dev);
+
+//takes the oldest queued event; false if the queue is empty
+bool pec11r_event_pop(pec11r_t *dev, pec11r_event_t *evt);
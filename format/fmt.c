@@ -0,0 +1,72 @@
+#include "fmt.h"
+
+static const uint32_t POW10[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+#define MAX_SCALE 9
+
+void fmt_init(fmt_t *f, char *buf, size_t cap){
+    f->buf = buf;
+    f->cap = cap;
+    f->len = 0;
+    if(cap){ buf[0] = '\0'; }
+}
+
+void fmt_char(fmt_t *f, char c){
+    if(f->len + 1 >= f->cap){ return; } //full; keep room for the terminator
+    f->buf[f->len++] = c;
+    f->buf[f->len] = '\0';
+}
+
+void fmt_str(fmt_t *f, const char *s){
+    while(*s){ fmt_char(f, *s++); }
+}
+
+//helper; writes digits of v right to left ending at end, zero-filled to min_digits; returns the first char
+static char *put_digits(char *end, uint32_t v, int min_digits){
+    char *p = end;
+    do {
+        *--p = (char)('0' + v % 10);
+        v /= 10;
+        min_digits--;
+    } while(v || min_digits > 0);
+    return p;
+}
+
+//helper; pads to width and copies the finished number
+static void put_padded(fmt_t *f, const char *s, int n, int width){
+    for(int i = n; i < width; i++){ fmt_char(f, ' '); }
+    for(int i = 0; i < n; i++){ fmt_char(f, s[i]); }
+}
+
+void fmt_int(fmt_t *f, int32_t v, int width){
+    fmt_fixed(f, v, 0, 0, width);
+}
+
+void fmt_fixed(fmt_t *f, int32_t v, uint8_t scale, uint8_t decimals, int width){
+    if(scale > MAX_SCALE){ scale = MAX_SCALE; }
+    if(decimals > scale){ decimals = scale; }
+
+    //magnitude as unsigned so INT32_MIN works
+    uint32_t mag = (v < 0) ? (uint32_t)0 - (uint32_t)v : (uint32_t)v;
+
+    //drop the extra digits, rounding half away from zero
+    uint32_t div = POW10[scale - decimals];
+    if(div > 1){ mag = mag / div + ((mag % div) >= div / 2); }
+    int negative = (v < 0 && mag != 0); //no "-0.0" when it rounded to zero
+
+    char tmp[24]; //sign + 10 digits + point + up to 9 decimals
+    char *end = tmp + sizeof(tmp);
+    char *p = end;
+    if(decimals){
+        p = put_digits(p, mag % POW10[decimals], decimals);
+        *--p = '.';
+        mag /= POW10[decimals];
+    }
+    p = put_digits(p, mag, 1);
+    if(negative){ *--p = '-'; }
+    put_padded(f, p, (int)(end - p), width);
+}
+
+void fmt_value(fmt_t *f, int32_t v, uint8_t scale, uint8_t decimals, const char *unit){
+    fmt_fixed(f, v, scale, decimals, 0);
+    if(unit){ fmt_str(f, unit); }
+}
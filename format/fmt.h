@@ -0,0 +1,33 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+  Small string builder for display and log text.
+  - Writes into a caller-owned buffer; no heap, no varargs, no float
+  - Always nul-terminated; output past the end is dropped, never overflows
+  - Readings are fixed point (value * 10^scale), e.g. centi-degrees are scale 2
+*/
+
+typedef struct {
+    char *buf;
+    size_t cap; //including the terminator
+    size_t len;
+} fmt_t;
+
+//start an empty string in buf
+void fmt_init(fmt_t *f, char *buf, size_t cap);
+
+void fmt_char(fmt_t *f, char c);
+
+void fmt_str(fmt_t *f, const char *s);
+
+//decimal integer, right-aligned in width (0 = no padding)
+void fmt_int(fmt_t *f, int32_t v, int width);
+
+//fixed-point value with scale implied decimal digits, rounded half away from zero to decimals (<= scale)
+//e.g. fmt_fixed(f, 2347, 2, 1, 0) -> "23.5"
+void fmt_fixed(fmt_t *f, int32_t v, uint8_t scale, uint8_t decimals, int width);
+
+//value then unit, the common display case: fmt_value(f, 2347, 2, 1, " C") -> "23.5 C"
+void fmt_value(fmt_t *f, int32_t v, uint8_t scale, uint8_t decimals, const char *unit);
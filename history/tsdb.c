@@ -0,0 +1,260 @@
+#include "tsdb.h"
+#include <stdio.h>
+#include <string.h>
+
+#define MINUTE_S 60
+#define HOUR_S 3600
+#define MAX_RECORD_BYTES (5 * (1 + TSDB_MAX_FIELDS)) //worst case varint per field
+
+//zigzag keeps small negative deltas small: 0,-1,1,-2.. -> 0,1,2,3..
+static inline uint32_t zigzag(int32_t v){
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t v){
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+//7 bits per byte, high bit set on all but the last
+static inline int put_varint(uint8_t *out, uint32_t v){
+    int n = 0;
+    while (v >= 0x80) {
+        out[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+static inline uint32_t get_varint(const uint8_t *in, int *pos){
+    uint32_t v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        uint8_t b = in[(*pos)++];
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) break;
+    }
+    return v;
+}
+
+static void tier_init(tsdb_tier_t *t, uint8_t nfields, uint16_t nblocks, tsdb_block_meta_t *meta, uint8_t (*data)[TSDB_BLOCK_BYTES]){
+    t->nfields = nfields;
+    t->nblocks = nblocks;
+    t->head = 0;
+    t->used = 0;
+    t->meta = meta;
+    t->data = data;
+}
+
+//logical block i (0 = oldest) -> ring index
+static inline uint16_t tier_block(const tsdb_tier_t *t, uint32_t i){
+    return (uint16_t)((t->head + i) % t->nblocks);
+}
+
+static void tier_append(tsdb_tier_t *t, uint32_t ts, const int32_t *v){
+    if (t->used) {
+        uint16_t b = tier_block(t, t->used - 1u);
+        tsdb_block_meta_t *m = &t->meta[b];
+
+        //wrapping subtraction, so any int32 step round-trips exactly
+        uint8_t rec[MAX_RECORD_BYTES];
+        int n = put_varint(rec, ts - t->last_ts);
+        for (int f = 0; f < t->nfields; f++) {
+            n += put_varint(rec + n, zigzag((int32_t)((uint32_t)v[f] - (uint32_t)t->last[f])));
+        }
+
+        if (m->len + n <= TSDB_BLOCK_BYTES && m->count < UINT16_MAX) {
+            memcpy(&t->data[b][m->len], rec, (size_t)n);
+            m->len = (uint8_t)(m->len + n);
+            m->count++;
+            m->last_ts = ts;
+            t->last_ts = ts;
+            memcpy(t->last, v, sizeof(int32_t) * t->nfields);
+            return;
+        }
+    }
+
+    //start a new block, recycling the oldest when the ring is full
+    if (t->used == t->nblocks) {
+        t->head = tier_block(t, 1);
+        t->used--;
+    }
+    tsdb_block_meta_t *m = &t->meta[tier_block(t, t->used)];
+    t->used++;
+
+    m->first_ts = ts;
+    m->last_ts = ts;
+    memcpy(m->first, v, sizeof(int32_t) * t->nfields);
+    m->count = 1;
+    m->len = 0;
+    t->last_ts = ts;
+    memcpy(t->last, v, sizeof(int32_t) * t->nfields);
+}
+
+//fields are {value} for raw and {avg, min, max} for rollups
+static inline void to_point(const tsdb_tier_t *t, uint32_t ts, const int32_t *v, tsdb_point_t *p){
+    p->ts = ts;
+    p->avg = v[0];
+    p->min = (t->nfields > 1) ? v[1] : v[0];
+    p->max = (t->nfields > 2) ? v[2] : v[0];
+}
+
+void tsdb_init(tsdb_series_t *s){
+    memset(s, 0, sizeof(*s));
+    tier_init(&s->tiers[TSDB_RAW], 1, TSDB_RAW_BLOCKS, s->raw_meta, s->raw_data);
+    tier_init(&s->tiers[TSDB_MINUTE], 3, TSDB_MINUTE_BLOCKS, s->minute_meta, s->minute_data);
+    tier_init(&s->tiers[TSDB_HOUR], 3, TSDB_HOUR_BLOCKS, s->hour_meta, s->hour_data);
+}
+
+//writes a finished bucket to its tier
+static void acc_flush(tsdb_tier_t *t, const tsdb_acc_t *a, uint32_t bucket_s){
+    int32_t v[3] = {(int32_t)(a->sum / (int64_t)a->n), a->min, a->max};
+    tier_append(t, a->bucket * bucket_s, v);
+}
+
+static void acc_add(tsdb_acc_t *a, int32_t min, int32_t max, int64_t sum, uint32_t n){
+    if (min < a->min) a->min = min;
+    if (max > a->max) a->max = max;
+    a->sum += sum;
+    a->n += n;
+}
+
+static void acc_start(tsdb_acc_t *a, uint32_t bucket, int32_t min, int32_t max, int64_t sum, uint32_t n){
+    a->active = true;
+    a->bucket = bucket;
+    a->min = min;
+    a->max = max;
+    a->sum = sum;
+    a->n = n;
+}
+
+//minute closed: it goes to the minute tier and into the running hour
+static void close_minute(tsdb_series_t *s){
+    const tsdb_acc_t *m = &s->minute;
+    acc_flush(&s->tiers[TSDB_MINUTE], m, MINUTE_S);
+
+    uint32_t hour = m->bucket * MINUTE_S / HOUR_S;
+    if (s->hour.active && s->hour.bucket != hour) {
+        acc_flush(&s->tiers[TSDB_HOUR], &s->hour, HOUR_S);
+        s->hour.active = false;
+    }
+    if (s->hour.active) {
+        acc_add(&s->hour, m->min, m->max, m->sum, m->n);
+    } else {
+        acc_start(&s->hour, hour, m->min, m->max, m->sum, m->n);
+    }
+}
+
+void tsdb_append(tsdb_series_t *s, uint32_t ts, int32_t value){
+    tier_append(&s->tiers[TSDB_RAW], ts, &value);
+
+    uint32_t minute = ts / MINUTE_S;
+    if (s->minute.active && s->minute.bucket != minute) {
+        close_minute(s);
+        s->minute.active = false;
+    }
+    if (s->minute.active) {
+        acc_add(&s->minute, value, value, value, 1);
+    } else {
+        acc_start(&s->minute, minute, value, value, value, 1);
+    }
+}
+
+//first logical block whose last_ts >= t0; blocks are in time order, so binary search
+static uint32_t find_block(const tsdb_tier_t *t, uint32_t t0){
+    uint32_t lo = 0, hi = t->used;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (t->meta[tier_block(t, mid)].last_ts < t0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+uint32_t tsdb_query(const tsdb_series_t *s, tsdb_tier_id_t tier, uint32_t t0, uint32_t t1, tsdb_visit_fn fn, void *ctx){
+    if (tier >= TSDB_TIERS || t1 < t0) return 0;
+    const tsdb_tier_t *t = &s->tiers[tier];
+    uint32_t visited = 0;
+
+    for (uint32_t i = find_block(t, t0); i < t->used; i++) {
+        uint16_t b = tier_block(t, i);
+        const tsdb_block_meta_t *m = &t->meta[b];
+        if (m->first_ts > t1) break;
+
+        uint32_t ts = m->first_ts;
+        int32_t v[TSDB_MAX_FIELDS];
+        memcpy(v, m->first, sizeof(v));
+        int pos = 0;
+
+        for (uint32_t r = 0; r < m->count; r++) {
+            if (r > 0) {
+                ts += get_varint(t->data[b], &pos);
+                for (int f = 0; f < t->nfields; f++) {
+                    v[f] = (int32_t)((uint32_t)v[f] + (uint32_t)unzigzag(get_varint(t->data[b], &pos)));
+                }
+            }
+            if (ts < t0) continue;
+            if (ts > t1) return visited;
+
+            tsdb_point_t p;
+            to_point(t, ts, v, &p);
+            visited++;
+            if (!fn(&p, ctx)) return visited;
+        }
+    }
+    return visited;
+}
+
+typedef struct {
+    tsdb_point_t acc;
+    int64_t sum;
+    uint32_t n;
+} summary_ctx_t;
+
+static bool summary_visit(const tsdb_point_t *p, void *ctx){
+    summary_ctx_t *c = (summary_ctx_t *)ctx;
+    if (c->n == 0 || p->min < c->acc.min) c->acc.min = p->min;
+    if (c->n == 0 || p->max > c->acc.max) c->acc.max = p->max;
+    if (c->n == 0) c->acc.ts = p->ts;
+    c->sum += p->avg;
+    c->n++;
+    return true;
+}
+
+bool tsdb_summary(const tsdb_series_t *s, tsdb_tier_id_t tier, uint32_t t0, uint32_t t1, tsdb_point_t *out){
+    summary_ctx_t c = {0};
+    tsdb_query(s, tier, t0, t1, summary_visit, &c);
+    if (c.n == 0) return false;
+
+    c.acc.avg = (int32_t)(c.sum / (int64_t)c.n);
+    *out = c.acc;
+    return true;
+}
+
+void tsdb_usage(const tsdb_series_t *s, tsdb_tier_id_t tier, uint32_t *points, uint32_t *bytes){
+    *points = 0;
+    *bytes = 0;
+    if (tier >= TSDB_TIERS) return;
+
+    const tsdb_tier_t *t = &s->tiers[tier];
+    for (uint32_t i = 0; i < t->used; i++) {
+        const tsdb_block_meta_t *m = &t->meta[tier_block(t, i)];
+        *points += m->count;
+        *bytes += m->len;
+    }
+}
+
+void tsdb_report(const tsdb_series_t *s, const char *name){
+    static const char *TIER_NAMES[TSDB_TIERS] = {"raw", "1min", "1h"};
+    printf("history %s:", name);
+    for (int i = 0; i < TSDB_TIERS; i++) {
+        const tsdb_tier_t *t = &s->tiers[i];
+        uint32_t points, bytes;
+        tsdb_usage(s, (tsdb_tier_id_t)i, &points, &bytes);
+        uint32_t span = t->used ? t->last_ts - t->meta[t->head].first_ts : 0;
+        printf(" %s %lu pts/%lu B/%lu s%s", TIER_NAMES[i], (unsigned long)points, (unsigned long)bytes,
+            (unsigned long)span, (i + 1 < TSDB_TIERS) ? "," : "\n");
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+  In-RAM time series with tiered rollups, one tsdb_series_t per quantity.
+  - Tiers: raw samples, 1-minute and 1-hour rollups (avg/min/max); rollups are built on insert
+    from running accumulators, so nothing is ever recomputed from the raw data
+  - Each tier is a ring of fixed-size blocks; when full, the oldest block is dropped (O(1) append)
+  - Inside a block, records are deltas from the previous record, zigzag + varint encoded;
+    the first record of a block is kept uncompressed in its metadata so blocks decode independently
+  - Queries binary search the block metadata by time and only decode the blocks in range
+  - Timestamps are seconds, values are whatever fixed point the caller uses (e.g. centi-degrees)
+  - No locking; append and query from the same core
+*/
+
+#define TSDB_BLOCK_BYTES 64
+#define TSDB_RAW_BLOCKS 16 //1 KB, minutes of raw samples
+#define TSDB_MINUTE_BLOCKS 32 //2 KB, hours of 1-minute rollups
+#define TSDB_HOUR_BLOCKS 16 //1 KB, days of 1-hour rollups
+#define TSDB_MAX_FIELDS 3
+
+typedef enum {
+    TSDB_RAW = 0,
+    TSDB_MINUTE = 1,
+    TSDB_HOUR = 2,
+    TSDB_TIERS = 3
+} tsdb_tier_id_t;
+
+//one record as returned by queries; raw samples have avg == min == max
+typedef struct {
+    uint32_t ts; //sample time, or bucket start for rollups
+    int32_t avg;
+    int32_t min;
+    int32_t max;
+} tsdb_point_t;
+
+typedef struct {
+    uint32_t first_ts;
+    uint32_t last_ts;
+    int32_t first[TSDB_MAX_FIELDS]; //first record, uncompressed
+    uint16_t count; //records, including the first
+    uint8_t len; //encoded bytes used
+} tsdb_block_meta_t;
+
+typedef struct {
+    uint8_t nfields; //1 for raw, 3 for rollups
+    uint16_t nblocks;
+    uint16_t head; //oldest block
+    uint16_t used; //blocks holding data; newest is (head + used - 1) % nblocks
+    tsdb_block_meta_t *meta;
+    uint8_t (*data)[TSDB_BLOCK_BYTES];
+
+    //last record appended; deltas are taken against it
+    uint32_t last_ts;
+    int32_t last[TSDB_MAX_FIELDS];
+} tsdb_tier_t;
+
+//running rollup for the bucket in progress
+typedef struct {
+    bool active;
+    uint32_t bucket; //ts / bucket length
+    int32_t min;
+    int32_t max;
+    int64_t sum;
+    uint32_t n;
+} tsdb_acc_t;
+
+typedef struct {
+    tsdb_tier_t tiers[TSDB_TIERS];
+    tsdb_acc_t minute;
+    tsdb_acc_t hour;
+
+    tsdb_block_meta_t raw_meta[TSDB_RAW_BLOCKS];
+    tsdb_block_meta_t minute_meta[TSDB_MINUTE_BLOCKS];
+    tsdb_block_meta_t hour_meta[TSDB_HOUR_BLOCKS];
+    uint8_t raw_data[TSDB_RAW_BLOCKS][TSDB_BLOCK_BYTES];
+    uint8_t minute_data[TSDB_MINUTE_BLOCKS][TSDB_BLOCK_BYTES];
+    uint8_t hour_data[TSDB_HOUR_BLOCKS][TSDB_BLOCK_BYTES];
+} tsdb_series_t;
+
+//called per point in time order; return false to stop early
+typedef bool (*tsdb_visit_fn)(const tsdb_point_t *p, void *ctx);
+
+//empties every tier
+void tsdb_init(tsdb_series_t *s);
+
+//adds a sample; timestamps must not go backwards. minute/hour rollups are emitted when a bucket closes
+void tsdb_append(tsdb_series_t *s, uint32_t ts, int32_t value);
+
+//visits points of one tier with t0 <= ts <= t1; returns how many were visited
+uint32_t tsdb_query(const tsdb_series_t *s, tsdb_tier_id_t tier, uint32_t t0, uint32_t t1, tsdb_visit_fn fn, void *ctx);
+
+//min/max/avg over t0..t1 of one tier (avg is the mean of point avgs); false if there are no points
+bool tsdb_summary(const tsdb_series_t *s, tsdb_tier_id_t tier, uint32_t t0, uint32_t t1, tsdb_point_t *out);
+
+//points and encoded bytes currently held by a tier
+void tsdb_usage(const tsdb_series_t *s, tsdb_tier_id_t tier, uint32_t *points, uint32_t *bytes);
+
+//one line per tier: points, bytes, time span
+void tsdb_report(const tsdb_series_t *s, const char *name);
@@ -0,0 +1,2 @@
+#pragma once
+//nothing from the wifi driver itself is used
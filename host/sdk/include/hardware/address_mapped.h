@@ -0,0 +1,8 @@
+#pragma once
+#include "pico/types.h"
+
+typedef volatile uint32_t io_rw_32;
+typedef const volatile uint32_t io_ro_32;
+
+static inline void hw_set_bits(io_rw_32 *addr, uint32_t mask){ *addr |= mask; }
+static inline void hw_clear_bits(io_rw_32 *addr, uint32_t mask){ *addr &= ~mask; }
@@ -0,0 +1,6 @@
+#pragma once
+#include "pico/types.h"
+
+enum clock_index { clk_sys = 5 };
+
+static inline uint32_t clock_get_hz(enum clock_index clk_index){ return 125000000u; }
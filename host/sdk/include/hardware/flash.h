@@ -0,0 +1,13 @@
+#pragma once
+#include "pico/types.h"
+
+//only the geometry; storage/flash_rp2040.c is replaced by host/sim/flash_rp2040_sim.c on the host
+#define FLASH_PAGE_SIZE (1u << 8)
+#define FLASH_SECTOR_SIZE (1u << 12)
+#define XIP_BASE 0x10000000u
+#ifndef PICO_FLASH_SIZE_BYTES
+#define PICO_FLASH_SIZE_BYTES (2u * 1024u * 1024u)
+#endif
+
+void flash_range_erase(uint32_t flash_offs, size_t count);
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count);
@@ -0,0 +1,44 @@
+#pragma once
+#include "pico/types.h"
+#include "hardware/gpio.h"
+
+#define NUM_PIO_STATE_MACHINES 4
+
+typedef struct {
+    volatile uint32_t ctrl;
+    volatile uint32_t fstat;
+    volatile uint32_t fdebug;
+    volatile uint32_t flevel;
+    volatile uint32_t txf[NUM_PIO_STATE_MACHINES];
+    volatile uint32_t rxf[NUM_PIO_STATE_MACHINES];
+} pio_hw_t;
+
+typedef pio_hw_t *PIO;
+extern pio_hw_t pio0_hw_s;
+extern pio_hw_t pio1_hw_s;
+#define pio0 (&pio0_hw_s)
+#define pio1 (&pio1_hw_s)
+
+typedef struct {
+    const uint16_t *instructions;
+    uint8_t length;
+    int8_t origin;
+} pio_program_t;
+
+typedef struct {
+    uint32_t clkdiv;
+    uint32_t execctrl;
+    uint32_t shiftctrl;
+    uint32_t pinctrl;
+} pio_sm_config;
+
+//words pushed to a state machine take the time its program was set up for (host/sim, sim_pio_set_word_ns)
+uint pio_add_program(PIO pio, const pio_program_t *program);
+bool pio_can_add_program(PIO pio, const pio_program_t *program);
+int pio_claim_unused_sm(PIO pio, bool required);
+void pio_gpio_init(PIO pio, uint pin);
+void pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base, uint pin_count, bool is_out);
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data);
+uint pio_sm_get_tx_fifo_level(PIO pio, uint sm);
+bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm);
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx);
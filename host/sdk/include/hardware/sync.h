@@ -0,0 +1,10 @@
+#pragma once
+#include "pico/types.h"
+
+uint32_t save_and_disable_interrupts(void);
+void restore_interrupts(uint32_t status);
+
+static inline void __dmb(void){ __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+static inline void __sev(void){}
+void __wfe(void);
+void __wfi(void);
@@ -0,0 +1,5 @@
+#pragma once
+#include "pico/types.h"
+
+uint32_t time_us_32(void);
+uint64_t time_us_64(void);
@@ -0,0 +1,5 @@
+#pragma once
+//host stand-in for the pico sdk; only what the firmware sources use, backed by host/sim
+#include "pico/types.h"
+#include "pico/error.h"
+#include "pico/platform.h"
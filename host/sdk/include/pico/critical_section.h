@@ -0,0 +1,11 @@
+#pragma once
+#include "pico/types.h"
+
+//the host runs "irqs" from the thread that waits for them, so there is nothing to exclude
+typedef struct {
+    uint32_t depth;
+} critical_section_t;
+
+void critical_section_init(critical_section_t *crit_sec);
+void critical_section_enter_blocking(critical_section_t *crit_sec);
+void critical_section_exit(critical_section_t *crit_sec);
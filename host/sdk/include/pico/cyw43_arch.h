@@ -0,0 +1,4 @@
+#pragma once
+
+int cyw43_arch_init(void);
+void cyw43_arch_deinit(void);
@@ -0,0 +1,6 @@
+#pragma once
+#include "pico/types.h"
+
+//runs func straight away; nothing executes from flash on the host
+int flash_safe_execute(void (*func)(void *), void *param, uint32_t enter_exit_timeout_ms);
+bool flash_safe_execute_core_init(void);
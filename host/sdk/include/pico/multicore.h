@@ -0,0 +1,8 @@
+#pragma once
+#include "pico/types.h"
+
+//the host has one core; build with GREENEYE_DUAL_CORE=0
+void multicore_launch_core1(void (*entry)(void));
+void multicore_lockout_victim_init(void);
+bool multicore_lockout_start_timeout_us(uint64_t timeout_us);
+bool multicore_lockout_end_timeout_us(uint64_t timeout_us);
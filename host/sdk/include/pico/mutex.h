@@ -0,0 +1,10 @@
+#pragma once
+#include "pico/types.h"
+
+typedef struct {
+    bool owned;
+} mutex_t;
+
+void mutex_init(mutex_t *mtx);
+void mutex_enter_blocking(mutex_t *mtx);
+void mutex_exit(mutex_t *mtx);
@@ -0,0 +1,16 @@
+#pragma once
+#include "pico/types.h"
+
+#define __not_in_flash_func(f) f
+#define __time_critical_func(f) f
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+
+//keeps the compiler from moving memory accesses across it; what the sdk's does on the m0+ too
+static inline void __compiler_memory_barrier(void){
+    __asm__ volatile ("" : : : "memory");
+}
+
+//busy-wait body; on the host it hands the virtual clock to the next pending event (irq, alarm, dma)
+void tight_loop_contents(void);
+
+uint get_core_num(void);
@@ -0,0 +1,8 @@
+#pragma once
+#include "pico/types.h"
+
+bool stdio_init_all(void);
+int putchar_raw(int c);
+
+//next byte pushed with sim_stdin_push, or PICO_ERROR_TIMEOUT
+int getchar_timeout_us(uint32_t timeout_us);
@@ -0,0 +1,7 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t; //plain microseconds since boot, as with PICO_OPAQUE_ABSOLUTE_TIME_T off
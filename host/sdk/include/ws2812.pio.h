@@ -0,0 +1,31 @@
+#pragma once
+//host stand-in for the pioasm output of led/ws2812.pio; the init functions set the word times in host/sim
+#include "hardware/pio.h"
+
+#define ws2812_T1 3
+#define ws2812_T2 3
+#define ws2812_T3 4
+#define ws2812_parallel_T1 3
+#define ws2812_parallel_T2 3
+#define ws2812_parallel_T3 4
+
+extern const pio_program_t ws2812_program;
+extern const pio_program_t ws2812_parallel_program;
+
+void sim_pio_set_word_ns(PIO pio, uint sm, uint32_t ns);
+
+//24 bit times per pixel word
+static inline void ws2812_program_init(PIO pio, uint sm, uint offset, uint pin, float freq, bool rgbw){
+    pio_gpio_init(pio, pin);
+    pio_sm_set_consecutive_pindirs(pio, sm, pin, 1, true);
+    sim_pio_set_word_ns(pio, sm, (uint32_t)((rgbw ? 32 : 24) * 1e9f / freq));
+}
+
+//one bit time (all strips at once) per word
+static inline void ws2812_parallel_program_init(PIO pio, uint sm, uint offset, uint pin_base, uint pin_count, float freq){
+    for (uint i = pin_base; i < pin_base + pin_count; i++) {
+        pio_gpio_init(pio, i);
+    }
+    pio_sm_set_consecutive_pindirs(pio, sm, pin_base, pin_count, true);
+    sim_pio_set_word_ns(pio, sm, (uint32_t)(1e9f / freq));
+}
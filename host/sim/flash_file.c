@@ -0,0 +1,99 @@
+#include "flash_file.h"
+#include <stdlib.h>
+#include <string.h>
+
+//helper; writes mem[off, off + len) through to the file
+static bool sync_range(flash_file_t *ff, uint32_t off, uint32_t len){
+    if (!ff->fp) return true;
+    if (fseek(ff->fp, (long)off, SEEK_SET) != 0) return false;
+    if (fwrite(&ff->mem[off], 1, len, ff->fp) != len) return false;
+    return fflush(ff->fp) == 0;
+}
+
+//helper; how many of len bytes the operation gets through before the power fails
+static uint32_t allowed(flash_file_t *ff, uint32_t len){
+    if (ff->budget < 0) return len;
+    uint32_t n = (ff->budget < (int64_t)len) ? (uint32_t)ff->budget : len;
+    ff->budget -= n;
+    if (n < len || ff->budget == 0) ff->dead = true; //the write that used up the budget still finishes
+    return n;
+}
+
+static bool file_read(void *ctx, uint32_t off, void *buf, uint32_t len){
+    flash_file_t *ff = (flash_file_t *)ctx;
+    if (ff->dead || off + len > ff->size) return false;
+    memcpy(buf, &ff->mem[off], len);
+    return true;
+}
+
+static bool file_prog(void *ctx, uint32_t off, const void *buf, uint32_t len){
+    flash_file_t *ff = (flash_file_t *)ctx;
+    if (ff->dead || off % FLASH_DEV_PAGE || len % FLASH_DEV_PAGE || off + len > ff->size) return false;
+
+    const uint8_t *src = (const uint8_t *)buf;
+    uint32_t n = allowed(ff, len);
+    for (uint32_t i = 0; i < n; i++) {
+        ff->mem[off + i] &= src[i]; //nor: programming only clears bits
+    }
+    ff->progs++;
+    ff->bytes_touched += n;
+    return sync_range(ff, off, n) && n == len;
+}
+
+static bool file_erase(void *ctx, uint32_t off){
+    flash_file_t *ff = (flash_file_t *)ctx;
+    if (ff->dead || off % FLASH_DEV_SECTOR || off + FLASH_DEV_SECTOR > ff->size) return false;
+
+    uint32_t n = allowed(ff, FLASH_DEV_SECTOR);
+    memset(&ff->mem[off + FLASH_DEV_SECTOR - n], 0xFF, n); //worst case for the log: the header survives longest
+    ff->erases++;
+    ff->bytes_touched += n;
+    return sync_range(ff, off + FLASH_DEV_SECTOR - n, n) && n == FLASH_DEV_SECTOR;
+}
+
+bool flash_file_open(flash_file_t *ff, flash_dev_t *dev, const char *path, uint32_t size){
+    memset(ff, 0, sizeof(*ff));
+    ff->size = size;
+    ff->budget = -1;
+    ff->mem = malloc(size);
+    if (!ff->mem) return false;
+    memset(ff->mem, 0xFF, size);
+
+    if (path) {
+        ff->fp = fopen(path, "r+b");
+        bool loaded = ff->fp && fread(ff->mem, 1, size, ff->fp) == size;
+        if (!loaded) { //missing or a different size: start from a blank part
+            if (ff->fp) fclose(ff->fp);
+            memset(ff->mem, 0xFF, size);
+            ff->fp = fopen(path, "w+b");
+            if (!ff->fp || !sync_range(ff, 0, size)) {
+                flash_file_close(ff);
+                return false;
+            }
+        }
+    }
+
+    dev->size = size;
+    dev->read = file_read;
+    dev->prog = file_prog;
+    dev->erase = file_erase;
+    dev->ctx = ff;
+    return true;
+}
+
+void flash_file_close(flash_file_t *ff){
+    if (ff->fp) fclose(ff->fp);
+    free(ff->mem);
+    ff->fp = NULL;
+    ff->mem = NULL;
+}
+
+void flash_file_cut_power_after(flash_file_t *ff, uint32_t bytes){
+    ff->budget = bytes;
+    ff->dead = (bytes == 0);
+}
+
+void flash_file_power_cycle(flash_file_t *ff){
+    ff->budget = -1;
+    ff->dead = false;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "flash_dev.h"
+
+/*
+  NOR flash image for flash_dev_t on the host, in RAM and optionally mirrored to a file so it
+  survives the process (a "reboot" is just opening the same file again).
+  - Program can only clear bits; erase sets a whole sector to 0xFF
+  - Power loss: after a set number of bytes have been touched, the operation in progress stops
+    part way (a program lands its first bytes; an erase clears from the end of the sector back,
+    so the header is the last thing to go) and everything fails until flash_file_power_cycle
+*/
+
+typedef struct {
+    FILE *fp; //NULL for a RAM-only image
+    uint8_t *mem;
+    uint32_t size;
+
+    int64_t budget; //bytes the next operations may still touch before power fails; < 0 = no limit
+    bool dead;
+
+    //stats
+    uint32_t progs;
+    uint32_t erases;
+    uint64_t bytes_touched;
+} flash_file_t;
+
+//path NULL keeps the image in RAM; an existing file of the right size is loaded, anything else starts erased
+bool flash_file_open(flash_file_t *ff, flash_dev_t *dev, const char *path, uint32_t size);
+
+void flash_file_close(flash_file_t *ff);
+
+//power fails once bytes more have been touched; the operation that crosses it is torn
+void flash_file_cut_power_after(flash_file_t *ff, uint32_t bytes);
+
+//power back; the image keeps whatever the torn operation left
+void flash_file_power_cycle(flash_file_t *ff);
@@ -0,0 +1,23 @@
+#include "flash_rp2040.h"
+#include <stdlib.h>
+#include "flash_file.h"
+
+/*
+  Host stand-in for storage/flash_rp2040.c: the spare flash is a flash_file_t image. It is kept in
+  the file named by GREENEYE_FLASH_IMAGE if that is set, so the log survives from one run to the
+  next like a reboot; otherwise it is RAM and starts erased every run
+*/
+
+#define SPARE_BYTES (1024u * 1024u) //roughly what a 2 MB board has left after the image
+
+bool flash_rp2040_init(flash_dev_t *dev, uint32_t max_bytes){
+    static flash_file_t image;
+    static bool opened = false;
+
+    uint32_t size = SPARE_BYTES;
+    if (max_bytes && size > max_bytes) size = max_bytes & ~(FLASH_DEV_SECTOR - 1);
+
+    if (opened) flash_file_close(&image);
+    opened = flash_file_open(&image, dev, getenv("GREENEYE_FLASH_IMAGE"), size);
+    return opened && size > 0;
+}
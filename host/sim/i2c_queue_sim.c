@@ -0,0 +1,71 @@
+#include "i2c_queue_rp2040.h"
+#include "i2c_bus.h"
+#include "sim.h"
+#include <string.h>
+#include "pico/stdlib.h"
+
+/*
+  Host stand-in for i2c/i2c_queue_rp2040.c: same entry point, but each segment is one event on the
+  virtual clock, due after its wire time, instead of fifo-level interrupts
+*/
+
+#define MAX_SEGMENT (2 + 4096) //prefix + the largest write anyone queues
+
+typedef struct {
+    i2c_inst_t *port;
+    i2c_queue_t *q;
+
+    uint8_t addr;
+    uint8_t wr[MAX_SEGMENT]; //prefix and wr, as they go on the wire
+    size_t wr_len;
+    size_t payload; //wr bytes without the prefix
+    uint8_t *rd;
+    size_t rd_len;
+    uint32_t start_us;
+} port_state_t;
+
+static port_state_t ports[NUM_I2CS];
+
+//stop detected; the device model sees the segment now
+static void segment_done(void *ctx){
+    port_state_t *s = (port_state_t *)ctx;
+    int result = sim_i2c_exchange(s->port, s->addr, s->wr, s->wr_len, s->rd, s->rd_len);
+    sim_i2c_set_busy(s->port, false);
+
+    size_t len = s->wr_len + s->rd_len;
+    i2c_bus_record(s->port, s->addr, len, result < 0 ? PICO_ERROR_GENERIC : (int)len, time_us_32() - s->start_us);
+    i2c_queue_segment_done(s->q, result < 0 ? PICO_ERROR_GENERIC : (int)(s->payload + s->rd_len));
+}
+
+static void sim_start(void *ctx, uint8_t addr, const uint8_t *prefix, size_t prefix_len,
+                      const uint8_t *wr, size_t wr_len, uint8_t *rd, size_t rd_len){
+    port_state_t *s = (port_state_t *)ctx;
+    s->addr = addr;
+    if (prefix_len) memcpy(s->wr, prefix, prefix_len);
+    if (wr_len) memcpy(s->wr + prefix_len, wr, wr_len);
+    s->wr_len = prefix_len + wr_len;
+    s->payload = wr_len;
+    s->rd = rd;
+    s->rd_len = rd_len;
+    s->start_us = time_us_32();
+
+    //a repeated start costs about another address byte
+    uint32_t bytes = (uint32_t)(s->wr_len + s->rd_len) + ((s->wr_len && rd_len) ? 1u : 0u);
+    sim_i2c_set_busy(s->port, true);
+    sim_at(sim_now_us() + sim_i2c_wire_us(s->port, bytes), segment_done, s);
+}
+
+void i2c_queue_rp2040_init(i2c_queue_t *q, i2c_inst_t *port){
+    port_state_t *s = &ports[i2c_hw_index(port)];
+    s->port = port;
+    s->q = q;
+
+    const i2c_queue_ctrl_t ctrl = {
+        .start = sim_start,
+        .lock = NULL, //events never run inside the queue code
+        .unlock = NULL,
+        .now_us = time_us_32,
+        .ctx = s
+    };
+    i2c_queue_init(q, &ctrl);
+}
@@ -0,0 +1,76 @@
+#include "aht20_model.h"
+#include <string.h>
+#include "pico/stdlib.h"
+
+#define STATUS_BUSY 0x80u
+#define STATUS_CALIBRATED 0x08u
+
+static uint8_t crc8(const uint8_t *data, size_t len){ //x^8 + x^5 + x^4 + 1, init 0xFF
+    uint8_t crc = 0xFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static bool busy(const aht20_model_t *m){
+    return m->measured && sim_now_us() - m->measure_start_us < AHT20_MODEL_MEASURE_US;
+}
+
+static bool model_write(void *ctx, const uint8_t *src, size_t len){
+    aht20_model_t *m = (aht20_model_t *)ctx;
+    if (sim_now_us() < AHT20_MODEL_POWERUP_US) {
+        m->nacks++;
+        return false;
+    }
+    if (len == 3 && src[0] == 0xAC && src[1] == 0x33 && src[2] == 0x00) {
+        m->triggers++;
+        m->measured = true;
+        m->measure_start_us = sim_now_us();
+        m->frame[1] = (uint8_t)(m->raw_h >> 12);
+        m->frame[2] = (uint8_t)(m->raw_h >> 4);
+        m->frame[3] = (uint8_t)(((m->raw_h & 0x0F) << 4) | ((m->raw_t >> 16) & 0x0F));
+        m->frame[4] = (uint8_t)(m->raw_t >> 8);
+        m->frame[5] = (uint8_t)m->raw_t;
+    }
+    return true; //anything else (soft reset, init) is accepted and ignored
+}
+
+static bool model_read(void *ctx, uint8_t *dst, size_t len){
+    aht20_model_t *m = (aht20_model_t *)ctx;
+    uint8_t out[7];
+    memcpy(out, m->frame, 6);
+    out[0] = STATUS_CALIBRATED | (busy(m) ? STATUS_BUSY : 0);
+    out[6] = crc8(out, 6);
+    if (m->corrupt_reads) {
+        m->corrupt_reads--;
+        out[6] ^= 0x5A;
+    }
+    m->reads++;
+    for (size_t i = 0; i < len; i++) {
+        dst[i] = (i < sizeof(out)) ? out[i] : 0xFF;
+    }
+    return true;
+}
+
+void aht20_model_init(aht20_model_t *m, i2c_inst_t *port){
+    memset(m, 0, sizeof(*m));
+    m->dev = (sim_i2c_dev_t){0x38, model_write, model_read, m};
+    aht20_model_set(m, 2250, 4500);
+    sim_i2c_attach(port, &m->dev);
+}
+
+void aht20_model_set(aht20_model_t *m, int32_t temp_cc, int32_t humidity_cp){
+    //inverse of the datasheet conversions: rh = raw / 2^20 * 100, t = raw / 2^20 * 200 - 50
+    uint32_t raw_h = (uint32_t)(((uint64_t)humidity_cp << 20) / 10000);
+    uint32_t raw_t = (uint32_t)(((uint64_t)(temp_cc + 5000) << 20) / 20000);
+    aht20_model_set_raw(m, raw_t, raw_h);
+}
+
+void aht20_model_set_raw(aht20_model_t *m, uint32_t raw_t, uint32_t raw_h){
+    m->raw_h = raw_h > 0xFFFFF ? 0xFFFFF : raw_h;
+    m->raw_t = raw_t > 0xFFFFF ? 0xFFFFF : raw_t;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "sim.h"
+
+/*
+  AHT20 behaviour on the simulated bus.
+  - Commands are nacked for the first 40 ms after power-on (t = 0); reads return the status byte
+  - 0xAC 0x33 0x00 starts a measurement that is busy for 80 ms; the frame is status, 20-bit humidity,
+    20-bit temperature, crc8, and stays readable until the next trigger
+*/
+
+#define AHT20_MODEL_POWERUP_US 40000
+#define AHT20_MODEL_MEASURE_US 80000
+
+typedef struct {
+    sim_i2c_dev_t dev;
+
+    uint32_t raw_h; //20-bit values the next measurement latches
+    uint32_t raw_t;
+
+    bool measured; //a frame was latched at least once
+    uint64_t measure_start_us;
+    uint8_t frame[6]; //status byte filled in at read time
+    uint32_t corrupt_reads; //the next n reads get a wrong crc
+
+    //stats
+    uint32_t triggers;
+    uint32_t reads;
+    uint32_t nacks;
+} aht20_model_t;
+
+void aht20_model_init(aht20_model_t *m, i2c_inst_t *port);
+
+//conditions for the next measurement, in centi-degrees C and centi-percent RH
+void aht20_model_set(aht20_model_t *m, int32_t temp_cc, int32_t humidity_cp);
+
+//raw 20-bit readings for the next measurement
+void aht20_model_set_raw(aht20_model_t *m, uint32_t raw_t, uint32_t raw_h);
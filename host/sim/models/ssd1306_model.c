@@ -0,0 +1,130 @@
+#include "ssd1306_model.h"
+#include <string.h>
+
+#define CO_BIT 0x80u
+#define DC_BIT 0x40u
+
+//argument bytes following a command, for the commands that take any
+static uint8_t arg_count(uint8_t c){
+    switch (c) {
+        case 0x21: //column range
+        case 0x22: //page range
+            return 2;
+        case 0x20: //memory mode
+        case 0x81: //contrast
+        case 0x8D: //charge pump
+        case 0xA8: //mux ratio
+        case 0xD3: //display offset
+        case 0xD5: //clock divide
+        case 0xD9: //precharge
+        case 0xDA: //com pins
+        case 0xDB: //vcomh
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static void run_command(ssd1306_model_t *m){
+    const uint8_t *c = m->cmd;
+    switch (c[0]) {
+        case 0xAE: m->on = false; break;
+        case 0xAF: m->on = true; break;
+        case 0x20: m->mode = c[1] & 3; break;
+        case 0x21:
+            m->col0 = c[1] & 0x7F;
+            m->col1 = c[2] & 0x7F;
+            m->col = m->col0;
+            break;
+        case 0x22:
+            m->page0 = c[1] & 7;
+            m->page1 = c[2] & 7;
+            m->page = m->page0;
+            break;
+        default:
+            if (m->mode == 2 && c[0] >= 0xB0 && c[0] <= 0xB7) m->page = c[0] & 7; //page start
+            else if (m->mode == 2 && c[0] <= 0x0F) m->col = (uint8_t)((m->col & 0xF0) | c[0]); //column low nibble
+            else if (m->mode == 2 && c[0] >= 0x10 && c[0] <= 0x17) m->col = (uint8_t)((m->col & 0x0F) | ((c[0] & 7) << 4));
+            break;
+    }
+}
+
+static void command_byte(ssd1306_model_t *m, uint8_t b){
+    m->command_bytes++;
+    if (m->cmd_len == 0) m->cmd_need = 1 + arg_count(b);
+    m->cmd[m->cmd_len++] = b;
+    if (m->cmd_len == m->cmd_need) {
+        run_command(m);
+        m->cmd_len = 0;
+    }
+}
+
+static void data_byte(ssd1306_model_t *m, uint8_t b){
+    m->data_bytes++;
+    m->gddram[m->page * SSD1306_MODEL_WIDTH + m->col] = b;
+
+    if (m->mode == 2) { //page mode: column wraps inside the page
+        m->col = (uint8_t)((m->col + 1) & 0x7F);
+        return;
+    }
+    if (m->mode == 1) { //vertical: down the window, then next column
+        if (m->page++ >= m->page1) {
+            m->page = m->page0;
+            m->col = (m->col >= m->col1) ? m->col0 : (uint8_t)(m->col + 1);
+        }
+        return;
+    }
+    if (m->col++ >= m->col1) { //horizontal: across the window, then next page
+        m->col = m->col0;
+        m->page = (m->page >= m->page1) ? m->page0 : (uint8_t)(m->page + 1);
+    }
+}
+
+static bool model_write(void *ctx, const uint8_t *src, size_t len){
+    ssd1306_model_t *m = (ssd1306_model_t *)ctx;
+    m->transactions++;
+
+    size_t i = 0;
+    while (i < len) {
+        uint8_t control = src[i++];
+        bool data = (control & DC_BIT) != 0;
+        if (control & CO_BIT) { //one byte, then another control byte
+            if (i < len) {
+                if (data) data_byte(m, src[i]); else command_byte(m, src[i]);
+                i++;
+            }
+            continue;
+        }
+        for (; i < len; i++) { //stream to the stop
+            if (data) data_byte(m, src[i]); else command_byte(m, src[i]);
+        }
+    }
+    return true;
+}
+
+//status register; bit 6 is set while the display is off
+static bool model_read(void *ctx, uint8_t *dst, size_t len){
+    ssd1306_model_t *m = (ssd1306_model_t *)ctx;
+    memset(dst, m->on ? 0x00 : 0x40, len);
+    return true;
+}
+
+void ssd1306_model_init(ssd1306_model_t *m, i2c_inst_t *port, uint8_t addr){
+    memset(m, 0, sizeof(*m));
+    for (size_t i = 0; i < sizeof(m->gddram); i++) {
+        m->gddram[i] = (uint8_t)(i * 151u + 7u); //ram is random at power-on
+    }
+    m->mode = 2; //reset state
+    m->col1 = SSD1306_MODEL_WIDTH - 1;
+    m->page1 = SSD1306_MODEL_PAGES - 1;
+    m->dev = (sim_i2c_dev_t){addr, model_write, model_read, m};
+    sim_i2c_attach(port, &m->dev);
+}
+
+uint32_t ssd1306_model_diff(const ssd1306_model_t *m, const uint8_t *frame){
+    uint32_t diff = 0;
+    for (size_t i = 0; i < sizeof(m->gddram); i++) {
+        if (m->gddram[i] != frame[i]) diff++;
+    }
+    return diff;
+}
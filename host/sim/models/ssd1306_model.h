@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "sim.h"
+
+/*
+  SSD1306 behaviour on the simulated bus, enough to check what the driver puts on the panel.
+  - Every transaction is a run of control bytes: Co = 1 means one byte follows before the next control
+    byte; Co = 0 means the rest of the transaction is all commands or all data (D/C bit)
+  - Horizontal and page addressing, with the column/page window; the pointer survives a stop, so a
+    chunked write carries on where the last chunk ended
+  - Commands outside the set the driver uses are parsed for their argument count and otherwise ignored
+*/
+
+#define SSD1306_MODEL_WIDTH 128
+#define SSD1306_MODEL_PAGES 8
+
+typedef struct {
+    sim_i2c_dev_t dev;
+
+    uint8_t gddram[SSD1306_MODEL_PAGES * SSD1306_MODEL_WIDTH];
+    bool on;
+    uint8_t mode; //0 horizontal, 1 vertical, 2 page
+    uint8_t col, page; //ram pointer
+    uint8_t col0, col1, page0, page1; //window
+
+    //command being assembled across bytes
+    uint8_t cmd[4];
+    uint8_t cmd_len, cmd_need;
+
+    //stats
+    uint32_t transactions;
+    uint32_t data_bytes;
+    uint32_t command_bytes;
+} ssd1306_model_t;
+
+void ssd1306_model_init(ssd1306_model_t *m, i2c_inst_t *port, uint8_t addr);
+
+//number of bytes where the panel differs from a page-major frame buffer
+uint32_t ssd1306_model_diff(const ssd1306_model_t *m, const uint8_t *frame);
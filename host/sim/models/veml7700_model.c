@@ -0,0 +1,95 @@
+#include "veml7700_model.h"
+#include <string.h>
+#include "pico/stdlib.h"
+
+#define CONFIG_REG 0x00
+#define OUTPUT_REG 0x04
+#define SHUTDOWN_BIT 0x0001u
+
+//gain in eighths from the ALS_GAIN field
+static uint32_t gain8(uint16_t config){
+    switch ((config >> 11) & 3) {
+        case 0: return 8; //1x
+        case 1: return 16; //2x
+        case 2: return 2; //1/4x
+        default: return 1; //1/8x
+    }
+}
+
+//ALS_IT field to ms
+static uint32_t itime_ms(uint16_t config){
+    switch ((config >> 6) & 15) {
+        case 12: return 25;
+        case 8: return 50;
+        case 0: return 100;
+        case 1: return 200;
+        case 2: return 400;
+        case 3: return 800;
+        default: return 100;
+    }
+}
+
+static uint16_t integrate(const veml7700_model_t *m){
+    if (m->forced_counts >= 0) return (uint16_t)m->forced_counts;
+    uint16_t config = m->regs[CONFIG_REG];
+    //counts per lux = gain8 * itime / 53.76
+    uint64_t counts = (uint64_t)(m->lux_mlux < 0 ? 0 : m->lux_mlux) * gain8(config) * itime_ms(config) / 53760u;
+    return counts > 65535 ? 65535 : (uint16_t)counts;
+}
+
+//latches integrations finished since the last access
+static void update(veml7700_model_t *m){
+    uint16_t config = m->regs[CONFIG_REG];
+    if (config & SHUTDOWN_BIT) return;
+    uint64_t period = (uint64_t)itime_ms(config) * 1000u;
+    uint64_t now = sim_now_us();
+    if (now - m->integration_start_us >= period) {
+        m->counts = integrate(m);
+        m->integration_start_us += (now - m->integration_start_us) / period * period;
+    }
+}
+
+static bool model_write(void *ctx, const uint8_t *src, size_t len){
+    veml7700_model_t *m = (veml7700_model_t *)ctx;
+    if (src[0] >= VEML7700_MODEL_REGS) return false;
+    update(m);
+    m->ptr = src[0];
+    if (len < 3) return true; //pointer only
+
+    uint16_t old = m->regs[m->ptr];
+    m->regs[m->ptr] = (uint16_t)(src[1] | (src[2] << 8));
+    if (m->ptr == CONFIG_REG) {
+        m->config_writes++;
+        if (m->regs[CONFIG_REG] != old) m->integration_start_us = sim_now_us(); //restarts at the new setting
+    }
+    return true;
+}
+
+static bool model_read(void *ctx, uint8_t *dst, size_t len){
+    veml7700_model_t *m = (veml7700_model_t *)ctx;
+    update(m);
+    m->regs[OUTPUT_REG] = m->counts;
+    uint16_t v = m->regs[m->ptr];
+    m->reads++;
+    for (size_t i = 0; i < len; i++) {
+        dst[i] = (i == 0) ? (uint8_t)v : (i == 1) ? (uint8_t)(v >> 8) : 0;
+    }
+    return true;
+}
+
+void veml7700_model_init(veml7700_model_t *m, i2c_inst_t *port){
+    memset(m, 0, sizeof(*m));
+    m->dev = (sim_i2c_dev_t){0x10, model_write, model_read, m};
+    m->regs[CONFIG_REG] = SHUTDOWN_BIT; //powers up shut down
+    m->forced_counts = -1;
+    m->lux_mlux = 250000;
+    sim_i2c_attach(port, &m->dev);
+}
+
+void veml7700_model_set_mlux(veml7700_model_t *m, int32_t lux_mlux){
+    m->lux_mlux = lux_mlux;
+}
+
+void veml7700_model_force_counts(veml7700_model_t *m, int32_t counts){
+    m->forced_counts = counts;
+}
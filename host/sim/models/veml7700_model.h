@@ -0,0 +1,38 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "sim.h"
+
+/*
+  VEML7700 behaviour on the simulated bus.
+  - 16-bit little-endian registers behind a one-byte register pointer; a write of just the pointer
+    selects what the next read returns (the driver's write + repeated start read)
+  - The output register holds the counts of the last finished integration; a config change restarts
+    integration, so the old counts stay readable until one integration time has passed
+  - counts = lux * sensitivity, sensitivity = 1 / 0.0042 lux at gain 2, 800 ms; clipped at 65535
+*/
+
+#define VEML7700_MODEL_REGS 8
+
+typedef struct {
+    sim_i2c_dev_t dev;
+
+    uint16_t regs[VEML7700_MODEL_REGS];
+    uint8_t ptr;
+    int32_t lux_mlux; //light level the sensor sees
+    int32_t forced_counts; //>= 0 overrides lux with a fixed count (conversion checks)
+
+    uint64_t integration_start_us;
+    uint16_t counts; //last finished integration
+
+    //stats
+    uint32_t config_writes;
+    uint32_t reads;
+} veml7700_model_t;
+
+void veml7700_model_init(veml7700_model_t *m, i2c_inst_t *port);
+
+void veml7700_model_set_mlux(veml7700_model_t *m, int32_t lux_mlux);
+
+//every integration from now on returns counts; -1 goes back to the light level
+void veml7700_model_force_counts(veml7700_model_t *m, int32_t counts);
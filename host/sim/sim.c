@@ -0,0 +1,357 @@
+#include "sim_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/critical_section.h"
+#include "pico/mutex.h"
+#include "pico/multicore.h"
+#include "pico/flash.h"
+#include "pico/cyw43_arch.h"
+#include "hardware/sync.h"
+
+//------------- CLOCK + EVENTS -------------
+
+typedef struct {
+    bool used;
+    int id;
+    uint64_t at;
+    uint64_t order; //ties at the same time fire in the order they were added
+    sim_event_fn fn;
+    void *ctx;
+} event_t;
+
+static uint64_t now_us;
+static event_t events[SIM_MAX_EVENTS];
+static int next_id = 1;
+static uint64_t next_order;
+
+static void alarms_reset(void);
+static void stdin_reset(void);
+
+void sim_reset(void){
+    now_us = 0;
+    memset(events, 0, sizeof(events));
+    alarms_reset();
+    stdin_reset();
+    sim_irq_reset();
+    sim_i2c_reset();
+    sim_gpio_reset();
+    sim_dma_reset();
+}
+
+uint64_t sim_now_us(void){
+    return now_us;
+}
+
+int sim_at(uint64_t at_us, sim_event_fn fn, void *ctx){
+    for (int i = 0; i < SIM_MAX_EVENTS; i++) {
+        if (events[i].used) continue;
+        events[i] = (event_t){true, next_id++, at_us < now_us ? now_us : at_us, next_order++, fn, ctx};
+        return events[i].id;
+    }
+    return -1;
+}
+
+bool sim_cancel(int id){
+    for (int i = 0; i < SIM_MAX_EVENTS; i++) {
+        if (events[i].used && events[i].id == id) {
+            events[i].used = false;
+            return true;
+        }
+    }
+    return false;
+}
+
+//helper; earliest pending event, NULL if none
+static event_t *next_event(void){
+    event_t *e = NULL;
+    for (int i = 0; i < SIM_MAX_EVENTS; i++) {
+        if (!events[i].used) continue;
+        if (!e || events[i].at < e->at || (events[i].at == e->at && events[i].order < e->order)) e = &events[i];
+    }
+    return e;
+}
+
+bool sim_step(void){
+    event_t *e = next_event();
+    if (!e) return false;
+
+    if (e->at > now_us) now_us = e->at;
+    sim_event_fn fn = e->fn;
+    void *ctx = e->ctx;
+    e->used = false; //before the call, so the handler may schedule again
+    fn(ctx);
+    return true;
+}
+
+void sim_run_until(uint64_t t){
+    event_t *e;
+    while ((e = next_event()) && e->at <= t) {
+        sim_step();
+    }
+    if (t > now_us) now_us = t;
+}
+
+void sim_advance_us(uint64_t us){
+    sim_run_until(now_us + us);
+}
+
+//------------- TIME -------------
+
+uint32_t time_us_32(void){ return (uint32_t)now_us; }
+uint64_t time_us_64(void){ return now_us; }
+
+absolute_time_t get_absolute_time(void){ return now_us; }
+absolute_time_t make_timeout_time_us(uint64_t us){ return now_us + us; }
+absolute_time_t make_timeout_time_ms(uint32_t ms){ return now_us + (uint64_t)ms * 1000u; }
+
+void sleep_us(uint64_t us){ sim_advance_us(us); }
+void sleep_ms(uint32_t ms){ sim_advance_us((uint64_t)ms * 1000u); }
+void sleep_until(absolute_time_t t){ sim_run_until(t); }
+
+bool best_effort_wfe_or_timeout(absolute_time_t t){
+    event_t *e = next_event();
+    if (e && e->at <= t) { //woken by an "irq" before the timeout
+        sim_step();
+        return now_us >= t;
+    }
+    sim_run_until(t);
+    return true;
+}
+
+//every spin-wait in the firmware is waiting for an interrupt; jump straight to the next one
+void tight_loop_contents(void){
+    if (!sim_step()) now_us++;
+}
+
+void __wfe(void){ tight_loop_contents(); }
+void __wfi(void){ tight_loop_contents(); }
+
+uint get_core_num(void){ return 0; }
+
+//------------- ALARMS -------------
+
+#define MAX_ALARMS 32
+
+typedef struct {
+    alarm_id_t id; //0 = free
+    alarm_callback_t cb;
+    void *user_data;
+    uint64_t at;
+    int event;
+} alarm_t;
+
+struct alarm_pool {
+    int unused;
+};
+
+static alarm_t alarms[MAX_ALARMS];
+static alarm_id_t next_alarm_id = 1;
+static alarm_pool_t default_pool;
+
+static void alarms_reset(void){
+    memset(alarms, 0, sizeof(alarms));
+}
+
+static void alarm_fire(void *ctx){
+    alarm_t *a = (alarm_t *)ctx;
+    alarm_id_t id = a->id;
+    int64_t again = a->cb(id, a->user_data);
+    if (a->id != id) return; //cancelled from its own callback
+
+    if (again > 0) { //from now
+        a->at = now_us + (uint64_t)again;
+    } else if (again < 0) { //from when it was due; keeps a fixed rate
+        a->at += (uint64_t)(-again);
+    } else {
+        a->id = 0;
+        return;
+    }
+    a->event = sim_at(a->at, alarm_fire, a);
+}
+
+alarm_id_t add_alarm_at(absolute_time_t t, alarm_callback_t cb, void *user_data, bool fire_if_past){
+    if (t <= now_us && !fire_if_past) return 0;
+    for (int i = 0; i < MAX_ALARMS; i++) {
+        alarm_t *a = &alarms[i];
+        if (a->id) continue;
+        a->event = sim_at(t, alarm_fire, a);
+        if (a->event < 0) return -1;
+        a->id = next_alarm_id++;
+        a->cb = cb;
+        a->user_data = user_data;
+        a->at = t;
+        return a->id;
+    }
+    return -1; //no free slot, like a full pool
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t cb, void *user_data, bool fire_if_past){
+    return add_alarm_at(now_us + us, cb, user_data, fire_if_past);
+}
+
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t cb, void *user_data, bool fire_if_past){
+    return add_alarm_at(now_us + (uint64_t)ms * 1000u, cb, user_data, fire_if_past);
+}
+
+bool cancel_alarm(alarm_id_t id){
+    for (int i = 0; i < MAX_ALARMS; i++) {
+        if (id > 0 && alarms[i].id == id) {
+            sim_cancel(alarms[i].event);
+            alarms[i].id = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+static int64_t repeating_fire(alarm_id_t id, void *user_data){
+    repeating_timer_t *rt = (repeating_timer_t *)user_data;
+    return rt->callback(rt) ? rt->delay_us : 0; //negative delay = start to start, as in the sdk
+}
+
+bool alarm_pool_add_repeating_timer_us(alarm_pool_t *pool, int64_t delay_us, repeating_timer_callback_t cb,
+                                       void *user_data, repeating_timer_t *out){
+    if (delay_us == 0) delay_us = 1;
+    out->delay_us = delay_us;
+    out->pool = pool;
+    out->callback = cb;
+    out->user_data = user_data;
+    out->alarm_id = add_alarm_in_us((uint64_t)(delay_us < 0 ? -delay_us : delay_us), repeating_fire, out, true);
+    return out->alarm_id > 0;
+}
+
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t cb, void *user_data, repeating_timer_t *out){
+    return alarm_pool_add_repeating_timer_us(&default_pool, delay_us, cb, user_data, out);
+}
+
+bool add_repeating_timer_ms(int32_t delay_ms, repeating_timer_callback_t cb, void *user_data, repeating_timer_t *out){
+    return add_repeating_timer_us((int64_t)delay_ms * 1000, cb, user_data, out);
+}
+
+bool cancel_repeating_timer(repeating_timer_t *timer){
+    bool ok = cancel_alarm(timer->alarm_id);
+    timer->alarm_id = 0;
+    return ok;
+}
+
+alarm_pool_t *alarm_pool_create_with_unused_hardware_alarm(uint max_timers){
+    return &default_pool;
+}
+
+alarm_id_t alarm_pool_add_alarm_in_us(alarm_pool_t *pool, uint64_t us, alarm_callback_t cb, void *user_data, bool fire_if_past){
+    return add_alarm_in_us(us, cb, user_data, fire_if_past);
+}
+
+//------------- IRQ -------------
+
+#define MAX_SHARED 4
+
+static irq_handler_t handlers[NUM_IRQS][MAX_SHARED];
+static bool irq_enabled[NUM_IRQS];
+
+void sim_irq_reset(void){
+    memset(handlers, 0, sizeof(handlers));
+    memset(irq_enabled, 0, sizeof(irq_enabled));
+}
+
+void irq_set_enabled(uint num, bool enabled){ irq_enabled[num] = enabled; }
+bool irq_is_enabled(uint num){ return irq_enabled[num]; }
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler){
+    memset(handlers[num], 0, sizeof(handlers[num]));
+    handlers[num][0] = handler;
+}
+
+void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order_priority){
+    for (int i = 0; i < MAX_SHARED; i++) {
+        if (handlers[num][i] == handler) { //the sdk asserts on this too
+            fprintf(stderr, "sim: handler added twice to irq %u\n", num);
+            abort();
+        }
+    }
+    for (int i = 0; i < MAX_SHARED; i++) {
+        if (!handlers[num][i]) {
+            handlers[num][i] = handler;
+            return;
+        }
+    }
+    fprintf(stderr, "sim: too many shared handlers on irq %u\n", num);
+    abort();
+}
+
+void irq_remove_handler(uint num, irq_handler_t handler){
+    for (int i = 0; i < MAX_SHARED; i++) {
+        if (handlers[num][i] == handler) handlers[num][i] = NULL;
+    }
+}
+
+uint sim_irq_handler_count(uint num){
+    uint n = 0;
+    for (int i = 0; i < MAX_SHARED; i++) {
+        if (handlers[num][i]) n++;
+    }
+    return n;
+}
+
+void sim_irq_raise(uint num){
+    if (!irq_enabled[num]) return;
+    for (int i = 0; i < MAX_SHARED; i++) {
+        if (handlers[num][i]) handlers[num][i]();
+    }
+}
+
+uint32_t save_and_disable_interrupts(void){ return 0; }
+void restore_interrupts(uint32_t status){}
+
+//------------- SYNC -------------
+
+void critical_section_init(critical_section_t *crit_sec){ crit_sec->depth = 0; }
+void critical_section_enter_blocking(critical_section_t *crit_sec){ crit_sec->depth++; }
+void critical_section_exit(critical_section_t *crit_sec){ crit_sec->depth--; }
+
+void mutex_init(mutex_t *mtx){ mtx->owned = false; }
+void mutex_enter_blocking(mutex_t *mtx){ mtx->owned = true; }
+void mutex_exit(mutex_t *mtx){ mtx->owned = false; }
+
+void multicore_launch_core1(void (*entry)(void)){
+    fprintf(stderr, "sim: no second core; build with GREENEYE_DUAL_CORE=0\n");
+    abort();
+}
+void multicore_lockout_victim_init(void){}
+bool multicore_lockout_start_timeout_us(uint64_t timeout_us){ return true; }
+bool multicore_lockout_end_timeout_us(uint64_t timeout_us){ return true; }
+
+int flash_safe_execute(void (*func)(void *), void *param, uint32_t enter_exit_timeout_ms){
+    func(param);
+    return PICO_OK;
+}
+bool flash_safe_execute_core_init(void){ return true; }
+
+int cyw43_arch_init(void){ return 0; }
+void cyw43_arch_deinit(void){}
+
+//------------- STDIO -------------
+
+#define STDIN_DEPTH 64
+
+static int stdin_buf[STDIN_DEPTH];
+static uint32_t stdin_head, stdin_tail;
+
+static void stdin_reset(void){
+    stdin_head = stdin_tail = 0;
+}
+
+void sim_stdin_push(int c){
+    if (stdin_head - stdin_tail < STDIN_DEPTH) stdin_buf[stdin_head++ % STDIN_DEPTH] = c;
+}
+
+bool stdio_init_all(void){ return true; }
+
+int putchar_raw(int c){ return putchar(c); }
+
+int getchar_timeout_us(uint32_t timeout_us){
+    if (stdin_head == stdin_tail) return PICO_ERROR_TIMEOUT;
+    return stdin_buf[stdin_tail++ % STDIN_DEPTH];
+}
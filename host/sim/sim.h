@@ -0,0 +1,99 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "hardware/i2c.h"
+#include "hardware/pio.h"
+
+/*
+  Host simulation behind the stub sdk in host/sdk.
+  - Time is a virtual microsecond clock; cpu work takes none of it, only bus transfers, pio words
+    and sleeps move it, so timings read back by the firmware are simulated bus/peripheral time
+  - Interrupt sources (alarms, dma completion, queued i2c segments, gpio edges) are events on that
+    clock; they fire when the firmware sleeps or spins in tight_loop_contents, like an irq would
+  - I2C targets are device models (host/sim/models) attached per port and address
+*/
+
+#define SIM_MAX_EVENTS 64
+#define SIM_MAX_I2C_DEVS 8 //per port
+
+typedef void (*sim_event_fn)(void *ctx);
+
+//back to t = 0 with no events, irq handlers, gpio state or attached devices; driver statics are not reset
+void sim_reset(void);
+
+uint64_t sim_now_us(void);
+
+//runs fn at at_us (or straight after the current event if that is in the past); returns an id, -1 if full
+int sim_at(uint64_t at_us, sim_event_fn fn, void *ctx);
+
+bool sim_cancel(int id);
+
+//fires the earliest pending event, moving the clock to it; false if nothing is pending
+bool sim_step(void);
+
+//fires everything due up to t, then leaves the clock at t
+void sim_run_until(uint64_t t);
+
+void sim_advance_us(uint64_t us);
+
+//calls the handlers of irq num if it is enabled
+void sim_irq_raise(uint num);
+
+//handlers installed on irq num, exclusive or shared
+uint sim_irq_handler_count(uint num);
+
+//------------- I2C -------------
+
+//one target on the bus; a false return is a nack
+typedef struct {
+    uint8_t addr;
+    bool (*write)(void *ctx, const uint8_t *src, size_t len);
+    bool (*read)(void *ctx, uint8_t *dst, size_t len);
+    void *ctx;
+} sim_i2c_dev_t;
+
+void sim_i2c_attach(i2c_inst_t *port, sim_i2c_dev_t *dev);
+void sim_i2c_detach(i2c_inst_t *port, uint8_t addr);
+
+//time one start..stop carrying bytes takes at the port's baud rate; same model as i2c_bus_wire_us
+uint32_t sim_i2c_wire_us(i2c_inst_t *port, uint32_t bytes);
+
+//hands one start..stop to the device at addr without moving the clock: wr (if any), then rd (if any) after a
+//repeated start. returns wr_len + rd_len or PICO_ERROR_GENERIC on a nack. the caller accounts the wire time
+int sim_i2c_exchange(i2c_inst_t *port, uint8_t addr, const uint8_t *wr, size_t wr_len, uint8_t *rd, size_t rd_len);
+
+//every start..stop that reached the wire since reset, however it was started (blocking, queued, dma)
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes; //after the address byte
+    uint32_t nacks;
+    uint64_t wire_us; //modelled bus time, as sim_i2c_wire_us
+} sim_i2c_stats_t;
+
+void sim_i2c_stats(i2c_inst_t *port, sim_i2c_stats_t *out);
+
+//a queued segment owns the port until it completes; a blocking transfer meanwhile is a firmware bug and aborts
+void sim_i2c_set_busy(i2c_inst_t *port, bool busy);
+
+//------------- GPIO -------------
+
+//drives an input pin as the outside world would; edges raise IO_IRQ_BANK0 for pins with that edge enabled
+void sim_gpio_set(uint gpio, bool level);
+
+//drives every pin in mask at the same instant (bit n of levels for pin n); one irq for all of them, so a
+//handler sees them change together, as when a slow irq misses the edge in between
+void sim_gpio_set_mask(uint32_t mask, uint32_t levels);
+
+//------------- PIO -------------
+
+//time one word pushed to sm takes to shift out; set by the program's init function
+void sim_pio_set_word_ns(PIO pio, uint sm, uint32_t ns);
+
+//words sm has shifted out since reset, by hand or over dma
+uint32_t sim_pio_words(PIO pio, uint sm);
+
+//------------- STDIO -------------
+
+//queues a byte for getchar_timeout_us
+void sim_stdin_push(int c);
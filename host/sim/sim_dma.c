@@ -0,0 +1,231 @@
+#include "sim_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/i2c.h"
+#include "hardware/pio.h"
+#include "ws2812.pio.h"
+
+#define I2C_FIFO_DEPTH 16
+
+//------------- PIO -------------
+
+pio_hw_t pio0_hw_s, pio1_hw_s;
+
+static const uint16_t no_instructions[1];
+const pio_program_t ws2812_program = {no_instructions, 4, -1};
+const pio_program_t ws2812_parallel_program = {no_instructions, 4, -1};
+
+typedef struct {
+    uint32_t word_ns;
+    uint32_t words;
+} sm_t;
+
+static sm_t sms[2][NUM_PIO_STATE_MACHINES];
+static uint program_end[2];
+
+static uint pio_index(PIO pio){ return pio == pio1 ? 1u : 0u; }
+
+void sim_pio_set_word_ns(PIO pio, uint sm, uint32_t ns){ sms[pio_index(pio)][sm].word_ns = ns; }
+uint32_t sim_pio_words(PIO pio, uint sm){ return sms[pio_index(pio)][sm].words; }
+
+uint pio_add_program(PIO pio, const pio_program_t *program){
+    uint offset = program_end[pio_index(pio)];
+    program_end[pio_index(pio)] += program->length;
+    return offset;
+}
+
+bool pio_can_add_program(PIO pio, const pio_program_t *program){
+    return program_end[pio_index(pio)] + program->length <= 32;
+}
+
+int pio_claim_unused_sm(PIO pio, bool required){ return 0; }
+void pio_gpio_init(PIO pio, uint pin){}
+void pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base, uint pin_count, bool is_out){}
+
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data){
+    sm_t *s = &sms[pio_index(pio)][sm];
+    sim_advance_us((s->word_ns + 999) / 1000); //fifo depth ignored; a full frame takes the same time either way
+    s->words++;
+}
+
+uint pio_sm_get_tx_fifo_level(PIO pio, uint sm){ return 0; } //dma completion is modelled at the last word out
+bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm){ return true; }
+uint pio_get_dreq(PIO pio, uint sm, bool is_tx){ return pio_index(pio) * 8 + sm + (is_tx ? 0 : 4); }
+
+//------------- DMA -------------
+
+typedef struct {
+    bool claimed;
+    bool busy;
+    bool irq0_enabled;
+    bool irq0_status;
+    dma_channel_config cfg;
+    volatile void *write_addr;
+    const volatile void *read_addr;
+    uint count;
+} channel_t;
+
+static channel_t channels[NUM_DMA_CHANNELS];
+
+void sim_dma_reset(void){
+    memset(channels, 0, sizeof(channels));
+    memset(sms, 0, sizeof(sms));
+    memset(program_end, 0, sizeof(program_end));
+    memset(&pio0_hw_s, 0, sizeof(pio0_hw_s));
+    memset(&pio1_hw_s, 0, sizeof(pio1_hw_s));
+}
+
+int dma_claim_unused_channel(bool required){
+    for (int ch = 0; ch < NUM_DMA_CHANNELS; ch++) {
+        if (!channels[ch].claimed) {
+            channels[ch].claimed = true;
+            return ch;
+        }
+    }
+    if (required) abort();
+    return -1;
+}
+
+void dma_channel_claim(uint channel){ channels[channel].claimed = true; }
+void dma_channel_unclaim(uint channel){ channels[channel].claimed = false; }
+
+#define CTRL_SIZE_MASK 0x3u
+#define CTRL_INCR_READ (1u << 4)
+#define CTRL_INCR_WRITE (1u << 5)
+#define CTRL_DREQ_SHIFT 15
+
+dma_channel_config dma_channel_get_default_config(uint channel){
+    dma_channel_config c = {DMA_SIZE_32 | CTRL_INCR_READ};
+    return c;
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size){
+    c->ctrl = (c->ctrl & ~CTRL_SIZE_MASK) | (uint32_t)size;
+}
+
+void channel_config_set_read_increment(dma_channel_config *c, bool incr){
+    c->ctrl = incr ? (c->ctrl | CTRL_INCR_READ) : (c->ctrl & ~CTRL_INCR_READ);
+}
+
+void channel_config_set_write_increment(dma_channel_config *c, bool incr){
+    c->ctrl = incr ? (c->ctrl | CTRL_INCR_WRITE) : (c->ctrl & ~CTRL_INCR_WRITE);
+}
+
+void channel_config_set_dreq(dma_channel_config *c, uint dreq){
+    c->ctrl = (c->ctrl & ~(0x3Fu << CTRL_DREQ_SHIFT)) | (dreq << CTRL_DREQ_SHIFT);
+}
+
+static void set_ro(io_ro_32 *reg, uint32_t v){
+    *(io_rw_32 *)reg = v;
+}
+
+//helper; i2c port whose data_cmd the channel writes, NULL if it targets something else
+static i2c_inst_t *i2c_target(const channel_t *c){
+    if (c->write_addr == &i2c0->hw->data_cmd) return i2c0;
+    if (c->write_addr == &i2c1->hw->data_cmd) return i2c1;
+    return NULL;
+}
+
+//helper; pio tx fifo the channel writes, sm index in *sm
+static PIO pio_target(const channel_t *c, uint *sm){
+    for (uint i = 0; i < NUM_PIO_STATE_MACHINES; i++) {
+        *sm = i;
+        if (c->write_addr == &pio0->txf[i]) return pio0;
+        if (c->write_addr == &pio1->txf[i]) return pio1;
+    }
+    return NULL;
+}
+
+static uint32_t word_at(const channel_t *c, uint i){
+    switch (c->cfg.ctrl & CTRL_SIZE_MASK) {
+        case DMA_SIZE_8: return ((const volatile uint8_t *)c->read_addr)[i];
+        case DMA_SIZE_16: return ((const volatile uint16_t *)c->read_addr)[i];
+        default: return ((const volatile uint32_t *)c->read_addr)[i];
+    }
+}
+
+//last word handed to the peripheral
+static void channel_done(void *ctx){
+    channel_t *c = (channel_t *)ctx;
+    c->busy = false;
+    if (c->irq0_enabled) {
+        c->irq0_status = true;
+        sim_irq_raise(DMA_IRQ_0);
+    }
+}
+
+//i2c controller has shifted the whole stream out; the device sees it now, one start..stop per STOP bit
+static void i2c_stream_done(void *ctx){
+    channel_t *c = (channel_t *)ctx;
+    i2c_inst_t *port = i2c_target(c);
+    i2c_hw_t *hw = port->hw;
+
+    uint8_t seg[4096];
+    size_t n = 0;
+    bool nack = false;
+    for (uint i = 0; i < c->count; i++) {
+        uint32_t w = word_at(c, i);
+        if (!(w & I2C_IC_DATA_CMD_CMD_BITS) && n < sizeof(seg)) seg[n++] = (uint8_t)w; //reads over dma aren't modelled
+        if ((w & I2C_IC_DATA_CMD_STOP_BITS) || i == c->count - 1) {
+            if (n && sim_i2c_exchange(port, (uint8_t)hw->tar, seg, n, NULL, 0) < 0) nack = true;
+            n = 0;
+        }
+    }
+    if (nack) set_ro(&hw->raw_intr_stat, hw->raw_intr_stat | I2C_IC_INTR_STAT_R_TX_ABRT_BITS);
+    set_ro(&hw->status, I2C_IC_STATUS_TFE_BITS);
+    sim_i2c_set_busy(port, false);
+}
+
+static void start(channel_t *c){
+    c->busy = true;
+    uint64_t now = sim_now_us();
+
+    i2c_inst_t *port = i2c_target(c);
+    if (port) { //paced by the tx fifo: dma finishes while the last FIFO_DEPTH bytes are still going out
+        set_ro(&port->hw->status, I2C_IC_STATUS_ACTIVITY_BITS);
+        set_ro(&port->hw->raw_intr_stat, 0);
+        sim_i2c_set_busy(port, true);
+        uint32_t queued = c->count > I2C_FIFO_DEPTH ? c->count - I2C_FIFO_DEPTH : 0;
+        sim_at(now + (queued ? sim_i2c_wire_us(port, queued) : 0), channel_done, c);
+        sim_at(now + sim_i2c_wire_us(port, c->count), i2c_stream_done, c);
+        return;
+    }
+
+    uint sm;
+    PIO pio = pio_target(c, &sm);
+    if (pio) {
+        sm_t *s = &sms[pio_index(pio)][sm];
+        s->words += c->count;
+        sim_at(now + ((uint64_t)c->count * s->word_ns + 999) / 1000, channel_done, c);
+        return;
+    }
+
+    //memory to memory; instant
+    if (c->cfg.ctrl & CTRL_INCR_WRITE) {
+        memcpy((void *)c->write_addr, (const void *)c->read_addr, (size_t)c->count << (c->cfg.ctrl & CTRL_SIZE_MASK));
+    }
+    sim_at(now, channel_done, c);
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger){
+    channel_t *c = &channels[channel];
+    c->cfg = *config;
+    c->write_addr = write_addr;
+    c->read_addr = read_addr;
+    c->count = transfer_count;
+    if (trigger) start(c);
+}
+
+bool dma_channel_is_busy(uint channel){ return channels[channel].busy; }
+
+void dma_channel_wait_for_finish_blocking(uint channel){
+    while (channels[channel].busy) tight_loop_contents();
+}
+
+void dma_channel_set_irq0_enabled(uint channel, bool enabled){ channels[channel].irq0_enabled = enabled; }
+bool dma_channel_get_irq0_status(uint channel){ return channels[channel].irq0_status; }
+void dma_channel_acknowledge_irq0(uint channel){ channels[channel].irq0_status = false; }
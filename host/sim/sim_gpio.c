@@ -0,0 +1,131 @@
+#include "sim_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hardware/gpio.h"
+
+#define MAX_RAW_HANDLERS 4
+
+typedef struct {
+    bool level; //what the pin reads
+    bool driven; //set by sim_gpio_set; otherwise the pull decides
+    bool pull_up;
+    uint32_t irq_enabled; //gpio_irq_level bits
+    uint32_t irq_pending;
+} pin_t;
+
+typedef struct {
+    uint32_t mask;
+    irq_handler_t handler;
+} raw_handler_t;
+
+static pin_t pins[NUM_BANK0_GPIOS];
+static raw_handler_t raw_handlers[MAX_RAW_HANDLERS];
+
+static void bank0_irq(void);
+
+void sim_gpio_reset(void){
+    memset(pins, 0, sizeof(pins));
+    memset(raw_handlers, 0, sizeof(raw_handlers));
+}
+
+void gpio_init(uint gpio){
+    pins[gpio].driven = false;
+    pins[gpio].level = pins[gpio].pull_up;
+}
+
+void gpio_set_dir(uint gpio, bool out){}
+void gpio_set_function(uint gpio, enum gpio_function fn){}
+
+void gpio_pull_up(uint gpio){
+    pins[gpio].pull_up = true;
+    if (!pins[gpio].driven) pins[gpio].level = true;
+}
+
+void gpio_pull_down(uint gpio){
+    pins[gpio].pull_up = false;
+    if (!pins[gpio].driven) pins[gpio].level = false;
+}
+
+void gpio_disable_pulls(uint gpio){
+    gpio_pull_down(gpio);
+}
+
+bool gpio_get(uint gpio){
+    return pins[gpio].level;
+}
+
+uint32_t gpio_get_all(void){
+    uint32_t all = 0;
+    for (uint i = 0; i < NUM_BANK0_GPIOS; i++) {
+        if (pins[i].level) all |= 1u << i;
+    }
+    return all;
+}
+
+void gpio_put(uint gpio, bool value){
+    pins[gpio].level = value;
+}
+
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled){
+    if (enabled) {
+        pins[gpio].irq_enabled |= event_mask;
+    } else {
+        pins[gpio].irq_enabled &= ~event_mask;
+    }
+}
+
+void gpio_add_raw_irq_handler_masked(uint32_t gpio_mask, irq_handler_t handler){
+    for (int i = 0; i < MAX_RAW_HANDLERS; i++) {
+        if (!raw_handlers[i].handler) {
+            raw_handlers[i] = (raw_handler_t){gpio_mask, handler};
+            if (sim_irq_handler_count(IO_IRQ_BANK0) == 0) irq_add_shared_handler(IO_IRQ_BANK0, bank0_irq, 0);
+            return;
+        }
+    }
+    fprintf(stderr, "sim: too many raw gpio handlers\n");
+    abort();
+}
+
+void gpio_add_raw_irq_handler(uint gpio, irq_handler_t handler){
+    gpio_add_raw_irq_handler_masked(1u << gpio, handler);
+}
+
+uint32_t gpio_get_irq_event_mask(uint gpio){
+    return pins[gpio].irq_pending & pins[gpio].irq_enabled;
+}
+
+void gpio_acknowledge_irq(uint gpio, uint32_t event_mask){
+    pins[gpio].irq_pending &= ~event_mask;
+}
+
+//the sdk's bank0 dispatcher: raw handlers run for any of their pins with an event pending
+static void bank0_irq(void){
+    uint32_t active = 0;
+    for (uint i = 0; i < NUM_BANK0_GPIOS; i++) {
+        if (gpio_get_irq_event_mask(i)) active |= 1u << i;
+    }
+    for (int i = 0; i < MAX_RAW_HANDLERS; i++) {
+        if (raw_handlers[i].handler && (raw_handlers[i].mask & active)) raw_handlers[i].handler();
+    }
+}
+
+void sim_gpio_set_mask(uint32_t mask, uint32_t levels){
+    bool raise = false;
+    for (uint gpio = 0; gpio < NUM_BANK0_GPIOS; gpio++) {
+        if (!(mask & (1u << gpio))) continue;
+        pin_t *p = &pins[gpio];
+        bool level = (levels >> gpio) & 1u;
+        p->driven = true;
+        if (p->level == level) continue;
+
+        p->level = level;
+        p->irq_pending |= level ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+        if (gpio_get_irq_event_mask(gpio)) raise = true;
+    }
+    if (raise) sim_irq_raise(IO_IRQ_BANK0);
+}
+
+void sim_gpio_set(uint gpio, bool level){
+    sim_gpio_set_mask(1u << gpio, level ? (1u << gpio) : 0);
+}
@@ -0,0 +1,124 @@
+#include "sim_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+
+static i2c_hw_t i2c0_hw, i2c1_hw;
+i2c_inst_t i2c0_inst = {&i2c0_hw, false};
+i2c_inst_t i2c1_inst = {&i2c1_hw, false};
+
+typedef struct {
+    uint baud;
+    bool busy; //a queued segment is on the wire
+    sim_i2c_dev_t *devs[SIM_MAX_I2C_DEVS];
+    sim_i2c_stats_t stats;
+} port_t;
+
+static port_t ports[NUM_I2CS];
+
+void sim_i2c_reset(void){
+    memset(ports, 0, sizeof(ports));
+    memset(&i2c0_hw, 0, sizeof(i2c0_hw));
+    memset(&i2c1_hw, 0, sizeof(i2c1_hw));
+}
+
+static port_t *port_of(i2c_inst_t *i2c){
+    return &ports[i2c_hw_index(i2c)];
+}
+
+void sim_i2c_attach(i2c_inst_t *port, sim_i2c_dev_t *dev){
+    port_t *p = port_of(port);
+    sim_i2c_detach(port, dev->addr);
+    for (int i = 0; i < SIM_MAX_I2C_DEVS; i++) {
+        if (!p->devs[i]) {
+            p->devs[i] = dev;
+            return;
+        }
+    }
+    fprintf(stderr, "sim: too many devices on i2c%u\n", i2c_hw_index(port));
+    abort();
+}
+
+void sim_i2c_detach(i2c_inst_t *port, uint8_t addr){
+    port_t *p = port_of(port);
+    for (int i = 0; i < SIM_MAX_I2C_DEVS; i++) {
+        if (p->devs[i] && p->devs[i]->addr == addr) p->devs[i] = NULL;
+    }
+}
+
+static sim_i2c_dev_t *find(i2c_inst_t *port, uint8_t addr){
+    port_t *p = port_of(port);
+    for (int i = 0; i < SIM_MAX_I2C_DEVS; i++) {
+        if (p->devs[i] && p->devs[i]->addr == addr) return p->devs[i];
+    }
+    return NULL;
+}
+
+void sim_i2c_set_busy(i2c_inst_t *port, bool busy){
+    port_of(port)->busy = busy;
+}
+
+#define CLOCKS_PER_BYTE 9 //8 data bits + ack
+#define CLOCKS_PER_TRANSACTION (CLOCKS_PER_BYTE + 2) //address byte, start, stop
+
+uint32_t sim_i2c_wire_us(i2c_inst_t *port, uint32_t bytes){
+    uint baud = port_of(port)->baud ? port_of(port)->baud : 100000;
+    uint64_t clocks = CLOCKS_PER_TRANSACTION + (uint64_t)bytes * CLOCKS_PER_BYTE;
+    return (uint32_t)((clocks * 1000000u + baud - 1) / baud);
+}
+
+void sim_i2c_stats(i2c_inst_t *port, sim_i2c_stats_t *out){
+    *out = port_of(port)->stats;
+}
+
+int sim_i2c_exchange(i2c_inst_t *port, uint8_t addr, const uint8_t *wr, size_t wr_len, uint8_t *rd, size_t rd_len){
+    sim_i2c_stats_t *st = &port_of(port)->stats;
+    sim_i2c_dev_t *dev = find(port, addr);
+    st->transactions++;
+    if (!dev) { //address nack; only the address byte went out
+        st->nacks++;
+        st->wire_us += sim_i2c_wire_us(port, 0);
+        return PICO_ERROR_GENERIC;
+    }
+    st->bytes += (uint32_t)(wr_len + rd_len);
+    st->wire_us += sim_i2c_wire_us(port, (uint32_t)(wr_len + rd_len));
+    if (wr_len && (!dev->write || !dev->write(dev->ctx, wr, wr_len))) return PICO_ERROR_GENERIC;
+    if (rd_len && (!dev->read || !dev->read(dev->ctx, rd, rd_len))) return PICO_ERROR_GENERIC;
+    return (int)(wr_len + rd_len);
+}
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate){
+    port_of(i2c)->baud = baudrate;
+    i2c->hw->enable = 1;
+    *(io_rw_32 *)&i2c->hw->status = I2C_IC_STATUS_TFE_BITS; //read-only to the firmware
+    return baudrate;
+}
+
+//helper for the blocking sdk calls; the bus time passes first, so alarms due meanwhile fire as irqs would
+static int blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, uint8_t *dst, size_t len){
+    if (port_of(i2c)->busy) {
+        fprintf(stderr, "sim: blocking transfer to 0x%02X while i2c%u is running a queued segment\n", addr, i2c_hw_index(i2c));
+        abort();
+    }
+    bool present = find(i2c, addr) != NULL;
+    sim_advance_us(sim_i2c_wire_us(i2c, present ? (uint32_t)len : 0)); //a nack ends after the address byte
+    return src ? sim_i2c_exchange(i2c, addr, src, len, NULL, 0) : sim_i2c_exchange(i2c, addr, NULL, 0, dst, len);
+}
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop){
+    return blocking(i2c, addr, src, NULL, len);
+}
+
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop){
+    return blocking(i2c, addr, NULL, dst, len);
+}
+
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop, uint timeout_us){
+    return blocking(i2c, addr, src, NULL, len);
+}
+
+int i2c_read_timeout_us(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop, uint timeout_us){
+    return blocking(i2c, addr, NULL, dst, len);
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include "sim.h"
+
+//per-peripheral state, cleared by sim_reset
+void sim_i2c_reset(void);
+void sim_gpio_reset(void);
+void sim_dma_reset(void);
+void sim_irq_reset(void);
@@ -0,0 +1,43 @@
+# Builds the two size probes with CC and prints their text size, e.g. for the m0+:
+#   cmake -DCC=arm-none-eabi-gcc -DSIZE=arm-none-eabi-size -DFW=<repo> -DOUT=<dir> -P fmt_size.cmake
+# FLAGS and PRINTF_FLAGS (lists) override the target and libc options.
+if(NOT DEFINED FLAGS)
+    set(FLAGS -mcpu=cortex-m0plus -mthumb -Os -ffunction-sections -fdata-sections -Wl,--gc-sections
+        --specs=nano.specs --specs=nosys.specs)
+endif()
+if(NOT DEFINED PRINTF_FLAGS)
+    set(PRINTF_FLAGS -u _printf_float) # newlib-nano leaves %f out unless asked
+endif()
+
+set(DIR ${CMAKE_CURRENT_LIST_DIR})
+file(MAKE_DIRECTORY ${OUT})
+
+function(text_size name out)
+    execute_process(COMMAND ${SIZE} ${OUT}/${name}.elf OUTPUT_VARIABLE report RESULT_VARIABLE rc)
+    if(NOT rc EQUAL 0)
+        message(FATAL_ERROR "${SIZE} failed on ${name}.elf")
+    endif()
+    # berkeley format: header line, then text data bss dec hex filename
+    string(REGEX MATCH "\n[ \t]*([0-9]+)[ \t]+([0-9]+)" row "${report}")
+    math(EXPR flash "${CMAKE_MATCH_1} + ${CMAKE_MATCH_2}") # initialised data is stored in flash too
+    set(${out} ${flash} PARENT_SCOPE)
+endfunction()
+
+function(build name)
+    execute_process(
+        COMMAND ${CC} ${FLAGS} ${ARGN} -I${FW}/format -o ${OUT}/${name}.elf ${DIR}/${name}.c
+        RESULT_VARIABLE rc ERROR_VARIABLE err)
+    if(NOT rc EQUAL 0)
+        message(FATAL_ERROR "building ${name} failed:\n${err}")
+    endif()
+endfunction()
+
+build(size_fmt ${FW}/format/fmt.c)
+build(size_printf ${PRINTF_FLAGS})
+text_size(size_fmt fmt_bytes)
+text_size(size_printf printf_bytes)
+math(EXPR saved "${printf_bytes} - ${fmt_bytes}")
+message("flash: fmt ${fmt_bytes} bytes, snprintf %f ${printf_bytes} bytes, ${saved} saved")
+if(saved LESS_EQUAL 0)
+    message(FATAL_ERROR "fmt is not smaller than snprintf %f")
+endif()
@@ -0,0 +1,12 @@
+//flash-size probe: one reading to text through fmt
+#include "fmt.h"
+
+volatile int32_t reading = 2347;
+char text[24];
+
+int main(void){
+    fmt_t f;
+    fmt_init(&f, text, sizeof(text));
+    fmt_value(&f, reading, 2, 1, " C");
+    return text[0];
+}
@@ -0,0 +1,11 @@
+//flash-size probe: the same reading through snprintf with %f, as before fmt
+#include <stdio.h>
+#include <stdint.h>
+
+volatile int32_t reading = 2347;
+char text[24];
+
+int main(void){
+    snprintf(text, sizeof(text), "%.1f C", reading / 100.0f);
+    return text[0];
+}
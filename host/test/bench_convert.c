@@ -0,0 +1,157 @@
+//integer sensor conversions against the float ones, through the drivers and the device models:
+//every 20-bit aht20 raw value and every veml7700 count at every gain/itime, plus time per fetch
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "check.h"
+#include "sim.h"
+#include "aht20_model.h"
+#include "veml7700_model.h"
+#include "aht20.h"
+#include "veml7700.h"
+#include "i2c_bus.h"
+#include "pico/stdlib.h"
+
+static const i2c_bus_t BUS = {i2c0, 4, 5, 400 * 1000};
+
+#define TIMED_FETCHES 200000
+
+static aht20_model_t aht_model;
+static veml7700_model_t veml_model;
+static aht20_t aht;
+static veml7700_t veml;
+
+static uint64_t cpu_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static long long llabs_diff(long long a, long long b){
+    return a > b ? a - b : b - a;
+}
+
+//exact value rounded half up, the rounding the fixed-point code does
+static long long round_exact(double v){
+    return (long long)floor(v + 0.5);
+}
+
+static void check_aht20(void){
+    long long worst_exact = 0, worst_float = 0;
+    for (uint32_t raw = 0; raw < (1u << 20); raw++) {
+        aht20_model_set_raw(&aht_model, raw, raw);
+        int32_t temp_cc, humidity_cp;
+        CHECK(aht20_read_fixed(&aht, &temp_cc, &humidity_cp));
+        float temp_c, humidity;
+        CHECK(aht20_fetch(&aht, &temp_c, &humidity)); //same frame; it stays readable until the next trigger
+
+        long long exact_cp = round_exact(raw * 10000.0 / 1048576.0);
+        long long exact_cc = round_exact(raw * 20000.0 / 1048576.0) - 5000;
+        long long d = llabs_diff(humidity_cp, exact_cp) > llabs_diff(temp_cc, exact_cc) ? llabs_diff(humidity_cp, exact_cp) : llabs_diff(temp_cc, exact_cc);
+        if (d > worst_exact) worst_exact = d;
+
+        long long f = llabs_diff(humidity_cp, llround(humidity * 100.0)) > llabs_diff(temp_cc, llround(temp_c * 100.0)) ?
+            llabs_diff(humidity_cp, llround(humidity * 100.0)) : llabs_diff(temp_cc, llround(temp_c * 100.0));
+        if (f > worst_float) worst_float = f;
+        if (f > 1) {
+            fprintf(stderr, "aht20 raw %u: fixed %d cc %d cp, float %.4f C %.4f %%\n", (unsigned)raw, (int)temp_cc, (int)humidity_cp, temp_c, humidity);
+        }
+        CHECK(f <= 1);
+    }
+    printf("aht20: 2^20 raw values, worst |fixed - exact| %lld, |fixed - float| %lld (0.01 units)\n", worst_exact, worst_float);
+    CHECK_EQ(worst_exact, 0);
+}
+
+static const veml7700_gain_t GAINS[] = {GAIN_1_08x, GAIN_1_04x, GAIN_1x, GAIN_2x};
+static const veml7700_itime_t ITIMES[] = {ITIME_25MS, ITIME_50MS, ITIME_100MS, ITIME_200MS, ITIME_400MS, ITIME_800MS};
+
+static double gain_value(veml7700_gain_t gain){
+    switch (gain) {
+        case GAIN_2x: return 2.0;
+        case GAIN_1_04x: return 0.25;
+        case GAIN_1_08x: return 0.125;
+        default: return 1.0;
+    }
+}
+
+//one counts value through both driver reads; the model latches it at the end of the next integration
+static void veml_read_both(uint16_t counts, int32_t *mlux, float *lux){
+    veml7700_model_force_counts(&veml_model, counts);
+    sleep_us((uint64_t)veml.itime_ms * 1000u);
+    CHECK(veml7700_read_mlux(&veml, mlux));
+    CHECK(veml7700_read_lux(&veml, lux));
+}
+
+static void check_veml7700(void){
+    for (size_t g = 0; g < sizeof(GAINS) / sizeof(GAINS[0]); g++) {
+        for (size_t t = 0; t < sizeof(ITIMES) / sizeof(ITIMES[0]); t++) {
+            CHECK(veml7700_config(&veml, GAINS[g], ITIMES[t]));
+            double mlux_per_count = 4.2 * (800.0 / ITIMES[t]) * (2.0 / gain_value(GAINS[g]));
+            long long worst_exact = 0;
+            double worst_float = 0; //in units of the float's own resolution at that value
+            for (uint32_t counts = 0; counts <= 65535; counts++) {
+                int32_t mlux;
+                float lux;
+                veml_read_both((uint16_t)counts, &mlux, &lux);
+
+                long long d = llabs_diff(mlux, round_exact(counts * mlux_per_count));
+                if (d > worst_exact) worst_exact = d;
+                CHECK(d <= 1);
+
+                //float carries 24 bits, so past ~16000 lux its own step is over 1 mlux; allow one lsb plus that
+                double step = (double)lux * 1000.0 * ldexp(1.0, -23);
+                double f = fabs(mlux - (double)lux * 1000.0);
+                if (f > 1.0 + step) {
+                    fprintf(stderr, "veml7700 gain %d itime %d counts %u: %d mlux, float %.3f lux\n", (int)GAINS[g], (int)ITIMES[t], (unsigned)counts, (int)mlux, lux);
+                }
+                CHECK(f <= 1.0 + step);
+                if (f > worst_float) worst_float = f;
+            }
+            printf("veml7700 gain %-2d itime %3d ms: worst |fixed - exact| %lld mlux, |fixed - float| %.2f mlux\n",
+                   (int)GAINS[g], (int)ITIMES[t], worst_exact, worst_float);
+        }
+    }
+}
+
+static void time_fetches(void){
+    //one latched frame, fetched over and over; bus emulation is the same for both, the conversion is the difference
+    aht20_model_set(&aht_model, 2345, 4567);
+    int32_t temp_cc, humidity_cp;
+    CHECK(aht20_read_fixed(&aht, &temp_cc, &humidity_cp));
+
+    float temp_c, humidity;
+    uint64_t t0 = cpu_ns();
+    for (int i = 0; i < TIMED_FETCHES; i++) CHECK(aht20_fetch_fixed(&aht, &temp_cc, &humidity_cp));
+    uint64_t t1 = cpu_ns();
+    for (int i = 0; i < TIMED_FETCHES; i++) CHECK(aht20_fetch(&aht, &temp_c, &humidity));
+    uint64_t t2 = cpu_ns();
+    printf("aht20 fetch: fixed %.1f ns, float %.1f ns\n", (double)(t1 - t0) / TIMED_FETCHES, (double)(t2 - t1) / TIMED_FETCHES);
+
+    uint64_t t3 = cpu_ns();
+    int32_t mlux;
+    for (int i = 0; i < TIMED_FETCHES; i++) CHECK(veml7700_read_mlux(&veml, &mlux));
+    uint64_t t4 = cpu_ns();
+    float lux;
+    for (int i = 0; i < TIMED_FETCHES; i++) CHECK(veml7700_read_lux(&veml, &lux));
+    uint64_t t5 = cpu_ns();
+    printf("veml7700 read: fixed %.1f ns, float %.1f ns\n", (double)(t4 - t3) / TIMED_FETCHES, (double)(t5 - t4) / TIMED_FETCHES);
+    //the host has an fpu; on the m0+ the float side is soft-float calls, so the gap there is far wider
+}
+
+int main(void){
+    sim_reset();
+    i2c_bus_init(&BUS);
+    aht20_model_init(&aht_model, BUS.port);
+    veml7700_model_init(&veml_model, BUS.port);
+    aht20_init(&aht, BUS.port);
+    veml7700_init(&veml, BUS.port);
+    sleep_ms(AHT20_MODEL_POWERUP_US / 1000);
+
+    check_aht20();
+    check_veml7700();
+    time_fetches();
+    printf("bench_convert: ok\n");
+    return 0;
+}
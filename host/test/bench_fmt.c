@@ -0,0 +1,123 @@
+//fmt against snprintf: same text for random readings, scales, decimals, widths and buffer sizes,
+//then time per call for fmt_value, snprintf with %f (what it replaced) and snprintf on integers
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "check.h"
+#include "fmt.h"
+
+#define CASES 2000000
+#define TIMED_CALLS 1000000
+
+static const uint32_t POW10[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+static uint32_t rng = 0x2545F491u; //xorshift; the same cases every run
+
+static uint32_t next(void){
+    rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+    return rng;
+}
+
+static uint64_t cpu_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+//dropped digits are exactly one half: fmt rounds away from zero, printf to even on the binary value
+static int is_tie(int32_t v, uint8_t scale, uint8_t decimals){
+    uint32_t div = POW10[scale - decimals];
+    uint32_t mag = (v < 0) ? (uint32_t)0 - (uint32_t)v : (uint32_t)v;
+    return div > 1 && mag % div == div / 2;
+}
+
+static int32_t random_value(void){
+    switch (next() % 4) {
+        case 0: return (int32_t)next(); //anything, INT32_MIN included
+        case 1: return (int32_t)(next() % 2001) - 1000; //around zero, where -0 and rounding to 0 live
+        case 2: return (int32_t)(next() % 200001) - 100000; //display range of the readings
+        default: return (next() & 1) ? INT32_MAX : INT32_MIN;
+    }
+}
+
+static void check_equivalence(void){
+    uint32_t ties = 0;
+    for (uint32_t i = 0; i < CASES; i++) {
+        int32_t v = random_value();
+        uint8_t scale = (uint8_t)(next() % 10);
+        uint8_t decimals = (uint8_t)(next() % (scale + 1u));
+        int width = (int)(next() % 16);
+        size_t cap = 1 + next() % 24;
+
+        char got[32], want[32];
+        fmt_t f;
+        fmt_init(&f, got, cap);
+        fmt_fixed(&f, v, scale, decimals, width);
+        CHECK(f.len < cap);
+        CHECK_EQ(strlen(got), f.len);
+
+        //long double holds every int32 / 10^scale closely enough that only exact halves can round differently
+        char full[64];
+        snprintf(full, sizeof(full), "%*.*Lf", width, decimals, (long double)v / POW10[scale]);
+        if (strchr(full, '-') && !strpbrk(full, "123456789")) { //printf keeps the sign of a value that rounds to zero
+            snprintf(full, sizeof(full), "%*.*Lf", width, decimals, 0.0L);
+        }
+        size_t n = strlen(full) < cap ? strlen(full) : cap - 1; //what snprintf(want, cap, ...) keeps
+        memcpy(want, full, n);
+        want[n] = '\0';
+        if (strcmp(got, want)) {
+            if (is_tie(v, scale, decimals)) { //fmt must match the value nudged one unit away from zero
+                char nudged[32];
+                fmt_init(&f, nudged, cap);
+                fmt_fixed(&f, v < 0 ? v - 1 : v + 1, scale, decimals, width);
+                CHECK(!strcmp(got, nudged));
+                ties++;
+                continue;
+            }
+            fprintf(stderr, "v %d scale %u decimals %u width %d cap %zu: fmt \"%s\" snprintf \"%s\"\n",
+                    (int)v, scale, decimals, width, cap, got, want);
+            CHECK(0);
+        }
+    }
+    printf("fmt: %u cases match snprintf; %u exact halves rounded away from zero instead of to even\n", CASES - ties, ties);
+}
+
+static void time_calls(void){
+    char buf[32];
+    volatile char sink = 0;
+    int32_t values[256];
+    for (int i = 0; i < 256; i++) values[i] = (int32_t)(next() % 6001) - 1000; //-10.00 .. 50.00 C
+
+    uint64_t t0 = cpu_ns();
+    for (int i = 0; i < TIMED_CALLS; i++) {
+        fmt_t f;
+        fmt_init(&f, buf, sizeof(buf));
+        fmt_value(&f, values[i & 255], 2, 1, " C");
+        sink ^= buf[0];
+    }
+    uint64_t t1 = cpu_ns();
+    for (int i = 0; i < TIMED_CALLS; i++) {
+        snprintf(buf, sizeof(buf), "%.1f C", values[i & 255] / 100.0f);
+        sink ^= buf[0];
+    }
+    uint64_t t2 = cpu_ns();
+    for (int i = 0; i < TIMED_CALLS; i++) {
+        int32_t v = values[i & 255];
+        int32_t deci = (v < 0 ? v - 5 : v + 5) / 10;
+        snprintf(buf, sizeof(buf), "%s%d.%d C", (deci < 0) ? "-" : "", (deci < 0 ? -deci : deci) / 10, (deci < 0 ? -deci : deci) % 10);
+        sink ^= buf[0];
+    }
+    uint64_t t3 = cpu_ns();
+    (void)sink;
+    printf("per call: fmt_value %.1f ns, snprintf %%.1f %.1f ns, snprintf integer parts %.1f ns\n",
+           (double)(t1 - t0) / TIMED_CALLS, (double)(t2 - t1) / TIMED_CALLS, (double)(t3 - t2) / TIMED_CALLS);
+}
+
+int main(void){
+    check_equivalence();
+    time_calls();
+    printf("bench_fmt: ok\n");
+    return 0;
+}
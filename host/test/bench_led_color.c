@@ -0,0 +1,117 @@
+//led color conversion: the lut path (led_color_to_grb) against the double-math formula it replaced,
+//timed per pixel on the host; rdtsc ticks on x86 (constant-rate, not core cycles), ns from the process cpu clock everywhere
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "check.h"
+#include "led_color.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#else
+#define HAVE_TSC 0
+#endif
+
+#define PIXELS 4096 //colors per pass; a little over a 16x16 matrix at 16 frames
+#define PASSES 2000
+
+//the pre-lut ws2812.c conversion, verbatim
+#define MAX_BRIGHTNESS 0.05 //5% brightness max
+#define BRIGHTNESS_SCALE MAX_BRIGHTNESS*255
+
+static uint32_t old_rgb_to_grb(uint8_t r, uint8_t g, uint8_t b){
+    r = (uint8_t)((r*BRIGHTNESS_SCALE)/255);
+    g = (uint8_t)((g*BRIGHTNESS_SCALE)/255);
+    b = (uint8_t)((b*BRIGHTNESS_SCALE)/255);
+    return (((uint32_t)g << 16) | ((uint32_t)r << 8) | (uint32_t)b);
+}
+
+static uint8_t colors[PIXELS][3];
+static uint32_t out[PIXELS];
+
+static uint64_t cpu_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t cycles(void){
+#if HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+typedef struct {
+    double ns_per_px;
+    double cycles_per_px;
+} timing_t;
+
+//noinline so both paths pay the same call per pixel, as they do from ws2812.c
+__attribute__((noinline)) static uint32_t old_path(uint8_t r, uint8_t g, uint8_t b, uint32_t phase){
+    (void)phase;
+    return old_rgb_to_grb(r, g, b);
+}
+
+__attribute__((noinline)) static uint32_t lut_path(uint8_t r, uint8_t g, uint8_t b, uint32_t phase){
+    return led_color_to_grb(r, g, b, phase);
+}
+
+static timing_t run(uint32_t (*convert)(uint8_t, uint8_t, uint8_t, uint32_t), uint32_t phase){
+    uint64_t t0 = cpu_ns(), c0 = cycles();
+    for (int pass = 0; pass < PASSES; pass++) {
+        for (int i = 0; i < PIXELS; i++) {
+            out[i] = convert(colors[i][0], colors[i][1], colors[i][2], phase == LED_COLOR_NO_DITHER ? phase : phase + (uint32_t)i);
+        }
+        __asm__ volatile("" ::: "memory"); //keep every pass
+    }
+    uint64_t c1 = cycles(), t1 = cpu_ns();
+    double n = (double)PASSES * PIXELS;
+    return (timing_t){(double)(t1 - t0) / n, (double)(c1 - c0) / n};
+}
+
+static void report(const char *name, timing_t t){
+    if (HAVE_TSC) {
+        printf("%-22s %6.2f ns/px %7.2f tsc ticks/px\n", name, t.ns_per_px, t.cycles_per_px);
+    } else {
+        printf("%-22s %6.2f ns/px\n", name, t.ns_per_px);
+    }
+}
+
+int main(void){
+    uint32_t x = 0x12345678u; //xorshift; the same colors every run
+    for (int i = 0; i < PIXELS; i++) {
+        for (int c = 0; c < 3; c++) {
+            x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+            colors[i][c] = (uint8_t)x;
+        }
+    }
+
+    led_color_init();
+
+    //same 5% cap as before: full white stays at the old ceiling, give or take the rounding
+    uint32_t old_white = old_rgb_to_grb(255, 255, 255) & 0xFF, new_white = led_color_to_grb(255, 255, 255, LED_COLOR_NO_DITHER) & 0xFF;
+    printf("full scale: old %u, lut %u (brightness %u)\n", (unsigned)old_white, (unsigned)new_white, (unsigned)led_color_brightness());
+    CHECK(new_white >= old_white && new_white <= old_white + 1);
+    CHECK_EQ(led_color_to_grb(0, 0, 0, 0), 0); //dithering never lights an off pixel
+
+    //monotonic per channel, with and without dither
+    for (uint32_t phase = 0; phase < 8; phase++) {
+        for (int v = 1; v < 256; v++) {
+            CHECK(led_color_to_grb((uint8_t)v, 0, 0, phase) >= led_color_to_grb((uint8_t)(v - 1), 0, 0, phase));
+        }
+    }
+
+    timing_t old_t = run(old_path, LED_COLOR_NO_DITHER);
+    timing_t lut_t = run(lut_path, LED_COLOR_NO_DITHER);
+    timing_t dither_t = run(lut_path, 0);
+    report("double formula", old_t);
+    report("lut", lut_t);
+    report("lut + dither", dither_t);
+    printf("lut speedup: %.1fx\n", old_t.ns_per_px / lut_t.ns_per_px);
+    //host fpu hides most of the gap; on the m0+ every double op is a soft-float call, so treat this as a floor
+    printf("bench_led_color: ok\n");
+    return 0;
+}
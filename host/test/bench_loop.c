@@ -0,0 +1,109 @@
+//main.c's boot and scheduler loop against simulated parts; reports bus and cpu cost per loop
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "sim.h"
+#include "aht20_model.h"
+#include "veml7700_model.h"
+#include "ssd1306_model.h"
+
+#define main greeneye_main
+#include "../../main.c"
+#undef main
+
+static uint64_t cpu_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void usage(void){
+    fprintf(stderr, "usage: bench_loop [--seconds n] [--no-oled] [--no-aht20] [--no-veml7700] [--max-bus-us n] [--max-cpu-ns n] [-v]\n");
+    exit(2);
+}
+
+int main(int argc, char **argv){
+    uint32_t seconds = 60;
+    uint64_t max_bus_us = 0, max_cpu_ns = 0; //per loop; 0 = no budget
+    bool oled_present = true, aht_present = true, veml_present = true, verbose = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = (uint32_t)strtoul(argv[++i], NULL, 0);
+        else if (!strcmp(argv[i], "--max-bus-us") && i + 1 < argc) max_bus_us = strtoull(argv[++i], NULL, 0);
+        else if (!strcmp(argv[i], "--max-cpu-ns") && i + 1 < argc) max_cpu_ns = strtoull(argv[++i], NULL, 0);
+        else if (!strcmp(argv[i], "--no-oled")) oled_present = false;
+        else if (!strcmp(argv[i], "--no-aht20")) aht_present = false;
+        else if (!strcmp(argv[i], "--no-veml7700")) veml_present = false;
+        else if (!strcmp(argv[i], "-v")) verbose = true;
+        else usage();
+    }
+
+    //the firmware's own log goes to /dev/null unless asked for; the report goes to the real stdout
+    FILE *out = fdopen(dup(STDOUT_FILENO), "w");
+    if (!verbose && !freopen("/dev/null", "w", stdout)) return 1;
+
+    static aht20_model_t aht_m;
+    static veml7700_model_t veml_m;
+    static ssd1306_model_t oled_m;
+    sim_reset();
+    if (aht_present) aht20_model_init(&aht_m, I2C_PORT);
+    if (veml_present) veml7700_model_init(&veml_m, I2C_PORT);
+    if (oled_present) ssd1306_model_init(&oled_m, I2C_PORT, SSD1306_ADDR_0x3C);
+
+    boot();
+    fprintf(out, "boot: %llu us simulated\n", (unsigned long long)sim_now_us());
+
+    sim_i2c_stats_t bus0, bus1;
+    sim_i2c_stats(I2C_PORT, &bus0);
+    uint64_t end_us = sim_now_us() + (uint64_t)seconds * 1000000u;
+    uint64_t loops = 0, cpu = 0;
+    while (sim_now_us() < end_us) {
+        uint64_t t0 = cpu_ns();
+        sched_run_once(&sched);
+        cpu += cpu_ns() - t0;
+        loops++;
+    }
+    sim_i2c_stats(I2C_PORT, &bus1);
+    fflush(stdout);
+
+    uint32_t txns = bus1.transactions - bus0.transactions;
+    uint64_t bus_us = bus1.wire_us - bus0.wire_us;
+    uint64_t bus_per_loop = loops ? bus_us / loops : 0;
+    uint64_t cpu_per_loop = loops ? cpu / loops : 0;
+    fprintf(out, "loop: %u s simulated, %llu loops\n", seconds, (unsigned long long)loops);
+    fprintf(out, "bus: %llu us (%.2f%% busy), %u transactions, %u bytes, %u nacks\n", (unsigned long long)bus_us,
+            100.0 * (double)bus_us / ((double)seconds * 1e6), txns, bus1.bytes - bus0.bytes, bus1.nacks - bus0.nacks);
+    fprintf(out, "per loop: %llu bus us, %.2f transactions, %llu cpu ns\n", (unsigned long long)bus_per_loop,
+            loops ? (double)txns / (double)loops : 0.0, (unsigned long long)cpu_per_loop);
+
+    int rc = 0;
+    if (oled_present) { //the panel must end up showing the driver's frame
+        ssd1306_flush_wait(&oled);
+        uint32_t diff = ssd1306_model_diff(&oled_m, oled.buffer);
+        fprintf(out, "oled: %u bytes differ from the frame buffer\n", diff);
+        if (diff && !oled.dirty_pages) rc = 1;
+    }
+    readings_t r;
+    readings_read(&shared_readings, &r);
+    //a missing part is never polled, so its reading stays NONE rather than ERR
+    if (r.climate_state != (aht_present ? READING_OK : READING_NONE) || r.lux_state != (veml_present ? READING_OK : READING_NONE)) {
+        fprintf(out, "FAIL: reading states climate %d lux %d\n", r.climate_state, r.lux_state);
+        rc = 1;
+    }
+    if (aht_present && (aht_m.nacks || aht_m.corrupt_reads)) { //every trigger went out after power-up
+        fprintf(out, "FAIL: %u aht20 commands nacked\n", aht_m.nacks);
+        rc = 1;
+    }
+    if (max_bus_us && bus_per_loop > max_bus_us) {
+        fprintf(out, "FAIL: bus time per loop over budget (%llu us)\n", (unsigned long long)max_bus_us);
+        rc = 1;
+    }
+    if (max_cpu_ns && cpu_per_loop > max_cpu_ns) {
+        fprintf(out, "FAIL: cpu time per loop over budget (%llu ns)\n", (unsigned long long)max_cpu_ns);
+        rc = 1;
+    }
+    fclose(out);
+    return rc;
+}
@@ -0,0 +1,271 @@
+//i2c_queue against a scripted controller that records every start..stop and completes them when told,
+//then end to end through the simulated bus: priorities, chunked writes stepping aside, repeated starts
+#include <stdio.h>
+#include <string.h>
+#include "check.h"
+#include "sim.h"
+#include "veml7700_model.h"
+#include "i2c_queue.h"
+#include "i2c_queue_rp2040.h"
+#include "i2c_bus.h"
+#include "pico/stdlib.h"
+
+#define MAX_SEGMENTS 64
+
+typedef struct {
+    uint8_t addr;
+    uint8_t wire[256]; //prefix then wr, as the controller would shift them out
+    size_t wr_len; //including the prefix
+    size_t prefix_len;
+    size_t rd_len; //> 0 with wr_len > 0 is a repeated start
+} segment_t;
+
+//the scripted controller: start only records, the test finishes segments one at a time
+static segment_t segs[MAX_SEGMENTS];
+static size_t nsegs;
+static uint8_t *pending_rd;
+static size_t pending_rd_len;
+static bool in_start;
+static uint32_t clock_us;
+
+static void ctrl_start(void *ctx, uint8_t addr, const uint8_t *prefix, size_t prefix_len,
+                       const uint8_t *wr, size_t wr_len, uint8_t *rd, size_t rd_len){
+    CHECK(!in_start);
+    CHECK(nsegs < MAX_SEGMENTS);
+    CHECK(prefix_len + wr_len <= sizeof(segs[0].wire));
+    in_start = true;
+    segment_t *s = &segs[nsegs++];
+    s->addr = addr;
+    if (prefix_len) memcpy(s->wire, prefix, prefix_len);
+    if (wr_len) memcpy(s->wire + prefix_len, wr, wr_len);
+    s->wr_len = prefix_len + wr_len;
+    s->prefix_len = prefix_len;
+    s->rd_len = rd_len;
+    pending_rd = rd;
+    pending_rd_len = rd_len;
+    in_start = false;
+}
+
+static uint32_t ctrl_now(void){ return clock_us; }
+
+static const i2c_queue_ctrl_t CTRL = {ctrl_start, NULL, NULL, ctrl_now, NULL};
+
+//the segment on the bus ends after us; reads come back as addr, addr + 1, ...
+static void finish(i2c_queue_t *q, bool ok, uint32_t us){
+    CHECK(nsegs > 0);
+    const segment_t *s = &segs[nsegs - 1];
+    clock_us += us;
+    for (size_t i = 0; i < pending_rd_len; i++) pending_rd[i] = (uint8_t)(s->addr + i);
+    i2c_queue_segment_done(q, ok ? (int)(s->wr_len - s->prefix_len + s->rd_len) : -1);
+}
+
+//completion log shared by the callbacks
+static uint8_t done_order[32];
+static int done_result[32];
+static size_t ndone;
+
+static void on_done(void *ctx, int result){
+    CHECK(ndone < sizeof(done_order));
+    done_order[ndone] = (uint8_t)(uintptr_t)ctx;
+    done_result[ndone++] = result;
+}
+
+static void reset(i2c_queue_t *q){
+    i2c_queue_init(q, &CTRL);
+    nsegs = 0;
+    ndone = 0;
+    clock_us = 0;
+}
+
+static void test_priorities(void){
+    i2c_queue_t q;
+    reset(&q);
+    static const uint8_t byte = 0xAA;
+    i2c_txn_t first, low, normal, high1, high2;
+    i2c_txn_init(&first, 0x10, I2C_PRIO_NORMAL, &byte, 1, NULL, 0, on_done, (void *)1);
+    i2c_txn_init(&low, 0x11, I2C_PRIO_LOW, &byte, 1, NULL, 0, on_done, (void *)2);
+    i2c_txn_init(&normal, 0x12, I2C_PRIO_NORMAL, &byte, 1, NULL, 0, on_done, (void *)3);
+    i2c_txn_init(&high1, 0x13, I2C_PRIO_HIGH, &byte, 1, NULL, 0, on_done, (void *)4);
+    i2c_txn_init(&high2, 0x14, I2C_PRIO_HIGH, &byte, 1, NULL, 0, on_done, (void *)5);
+
+    CHECK(i2c_queue_submit(&q, &first)); //idle bus: straight on
+    CHECK_EQ(nsegs, 1);
+    CHECK(!i2c_queue_submit(&q, &first)); //still busy
+    CHECK(i2c_queue_submit(&q, &low));
+    CHECK(i2c_queue_submit(&q, &normal));
+    CHECK(i2c_queue_submit(&q, &high1));
+    CHECK(i2c_queue_submit(&q, &high2));
+    CHECK_EQ(nsegs, 1); //nothing preempts a segment on the bus
+
+    for (int i = 0; i < 5; i++) finish(&q, true, 100);
+    static const uint8_t want[] = {1, 4, 5, 3, 2}; //priority first, fifo within one
+    CHECK_EQ(ndone, 5);
+    CHECK(!memcmp(done_order, want, sizeof(want)));
+    CHECK(i2c_queue_idle(&q));
+    CHECK(!low.busy && low.result == 1);
+
+    //low waited behind four 100 us segments
+    CHECK_EQ(q.max_wait_us[I2C_PRIO_LOW], 400);
+    CHECK_EQ(q.max_wait_us[I2C_PRIO_HIGH], 200);
+}
+
+static void test_chunk_yield(void){
+    i2c_queue_t q;
+    reset(&q);
+    uint8_t frame[100];
+    for (size_t i = 0; i < sizeof(frame); i++) frame[i] = (uint8_t)i;
+
+    i2c_txn_t flush, sensor;
+    i2c_txn_init(&flush, 0x3C, I2C_PRIO_LOW, frame, sizeof(frame), NULL, 0, on_done, (void *)1);
+    flush.chunk = 32;
+    flush.prefix[0] = 0x40; //data control byte, as the ssd1306 uses it
+    flush.prefix_len = 1;
+    CHECK(i2c_queue_submit(&q, &flush));
+
+    //a sensor read arrives while the first chunk is on the bus
+    uint8_t reg = 0x04, rd[2];
+    i2c_txn_init(&sensor, 0x10, I2C_PRIO_HIGH, &reg, 1, rd, sizeof(rd), on_done, (void *)2);
+    CHECK(i2c_queue_submit(&q, &sensor));
+    finish(&q, true, 300);
+    CHECK_EQ(q.yields, 1);
+    CHECK_EQ(segs[1].addr, 0x10); //the read went next, between chunks
+
+    finish(&q, true, 50);
+    CHECK_EQ(ndone, 1);
+    CHECK_EQ(done_order[0], 2);
+    while (!i2c_queue_idle(&q)) finish(&q, true, 300);
+
+    //chunks: 32 bytes bare, then 32, 32, 4 each behind the prefix
+    CHECK_EQ(nsegs, 5);
+    static const size_t chunk_len[] = {32, 0, 32, 32, 4};
+    uint8_t rebuilt[sizeof(frame)];
+    size_t at = 0;
+    for (size_t i = 0; i < nsegs; i++) {
+        if (i == 1) continue;
+        CHECK_EQ(segs[i].addr, 0x3C);
+        CHECK_EQ(segs[i].prefix_len, i ? 1 : 0);
+        if (i) CHECK_EQ(segs[i].wire[0], 0x40);
+        CHECK_EQ(segs[i].wr_len - segs[i].prefix_len, chunk_len[i]);
+        memcpy(rebuilt + at, segs[i].wire + segs[i].prefix_len, chunk_len[i]);
+        at += chunk_len[i];
+    }
+    CHECK_EQ(at, sizeof(frame));
+    CHECK(!memcmp(rebuilt, frame, sizeof(frame)));
+    CHECK_EQ(ndone, 2);
+    CHECK_EQ(done_result[1], (int)sizeof(frame)); //prefixes not counted
+    CHECK_EQ(q.yields, 1); //nothing else was waiting at the later chunk ends
+}
+
+static void test_repeated_start(void){
+    i2c_queue_t q;
+    reset(&q);
+    uint8_t reg = 0x71, rd[7] = {0};
+    i2c_txn_t t;
+    i2c_txn_init(&t, 0x38, I2C_PRIO_HIGH, &reg, 1, rd, sizeof(rd), on_done, (void *)1);
+    CHECK(i2c_queue_submit(&q, &t));
+    CHECK_EQ(nsegs, 1);
+    CHECK_EQ(segs[0].wr_len, 1); //write and read in one segment
+    CHECK_EQ(segs[0].rd_len, sizeof(rd));
+    finish(&q, true, 200);
+    CHECK_EQ(done_result[0], 1 + (int)sizeof(rd));
+    CHECK_EQ(rd[0], 0x38);
+    CHECK_EQ(rd[6], 0x38 + 6);
+
+    //a repeated start can't be split, and empty or oversized-prefix transactions are refused
+    t.chunk = 1;
+    CHECK(!i2c_queue_submit(&q, &t));
+    i2c_txn_init(&t, 0x38, I2C_PRIO_HIGH, NULL, 0, NULL, 0, NULL, NULL);
+    CHECK(!i2c_queue_submit(&q, &t));
+    i2c_txn_init(&t, 0x38, I2C_PRIO_HIGH, &reg, 1, NULL, 0, NULL, NULL);
+    t.prefix_len = I2C_QUEUE_MAX_PREFIX + 1;
+    CHECK(!i2c_queue_submit(&q, &t));
+    CHECK_EQ(nsegs, 1);
+}
+
+//a nack mid-way drops the rest of the chunks and the next transaction still runs
+static void test_failure(void){
+    i2c_queue_t q;
+    reset(&q);
+    uint8_t frame[64] = {0};
+    static const uint8_t byte = 1;
+    i2c_txn_t flush, next;
+    i2c_txn_init(&flush, 0x3C, I2C_PRIO_LOW, frame, sizeof(frame), NULL, 0, on_done, (void *)1);
+    flush.chunk = 16;
+    i2c_txn_init(&next, 0x10, I2C_PRIO_LOW, &byte, 1, NULL, 0, on_done, (void *)2);
+    CHECK(i2c_queue_submit(&q, &flush));
+    CHECK(i2c_queue_submit(&q, &next));
+    finish(&q, true, 100);
+    finish(&q, false, 10);
+    CHECK_EQ(ndone, 1);
+    CHECK(done_result[0] < 0);
+    CHECK_EQ(q.failed, 1);
+    CHECK_EQ(segs[nsegs - 1].addr, 0x10);
+    finish(&q, true, 100);
+    CHECK_EQ(done_result[1], 1);
+    CHECK(i2c_queue_idle(&q));
+    CHECK_EQ(q.segments, 3);
+}
+
+//done runs after the queue is unlocked and t is free, so a callback may submit t again
+static i2c_queue_t *resubmit_q;
+static i2c_txn_t resubmit_t;
+static int resubmits;
+
+static void on_done_resubmit(void *ctx, int result){
+    if (++resubmits < 3) CHECK(i2c_queue_submit(resubmit_q, &resubmit_t));
+}
+
+static void test_resubmit_from_done(void){
+    i2c_queue_t q;
+    reset(&q);
+    static const uint8_t byte = 2;
+    resubmit_q = &q;
+    i2c_txn_init(&resubmit_t, 0x10, I2C_PRIO_NORMAL, &byte, 1, NULL, 0, on_done_resubmit, NULL);
+    CHECK(i2c_queue_submit(&q, &resubmit_t));
+    while (!i2c_queue_idle(&q)) finish(&q, true, 100);
+    CHECK_EQ(resubmits, 3);
+    CHECK_EQ(nsegs, 3);
+}
+
+//the same queue behind the simulated controller: the bus time passes and the model sees a write + read
+static void test_sim_bus(void){
+    static const i2c_bus_t bus = {i2c0, 4, 5, 400 * 1000};
+    static veml7700_model_t model;
+    static i2c_queue_t q;
+    sim_reset();
+    i2c_bus_init(&bus);
+    veml7700_model_init(&model, bus.port);
+    i2c_queue_rp2040_init(&q, bus.port);
+    ndone = 0;
+
+    static const uint8_t config[3] = {0x00, 0x40, 0x08}; //config register, gain 2x, itime 200 ms, powered on
+    static const uint8_t reg = 0x00;
+    uint8_t rd[2] = {0};
+    i2c_txn_t write, read;
+    i2c_txn_init(&write, 0x10, I2C_PRIO_NORMAL, config, sizeof(config), NULL, 0, on_done, (void *)1);
+    i2c_txn_init(&read, 0x10, I2C_PRIO_HIGH, &reg, 1, rd, sizeof(rd), on_done, (void *)2);
+
+    uint64_t t0 = sim_now_us();
+    CHECK(i2c_queue_submit(&q, &write));
+    CHECK(i2c_queue_submit(&q, &read));
+    CHECK_EQ(sim_now_us(), t0); //submit never waits for the bus
+    while (!i2c_queue_idle(&q)) tight_loop_contents();
+
+    CHECK_EQ(ndone, 2);
+    CHECK_EQ(done_order[0], 1); //already on the bus when the read came in
+    CHECK_EQ(done_result[1], 3);
+    CHECK_EQ(rd[0] | (rd[1] << 8), 0x0840); //the read-back saw the write
+    CHECK_EQ(model.config_writes, 1);
+    CHECK(sim_now_us() - t0 >= sim_i2c_wire_us(bus.port, 3) + sim_i2c_wire_us(bus.port, 3));
+}
+
+int main(void){
+    test_priorities();
+    test_chunk_yield();
+    test_repeated_start();
+    test_failure();
+    test_resubmit_from_done();
+    test_sim_bus();
+    printf("test_i2c_queue: ok\n");
+    return 0;
+}
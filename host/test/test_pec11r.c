@@ -0,0 +1,232 @@
+//pec11r: recorded A/B edge sequences replayed through the polling path and the gpio irq path;
+//both decode with the same lut and detent accumulator
+#include <stdio.h>
+#include <string.h>
+#include "check.h"
+#include "sim.h"
+#include "pec11r.h"
+#include "pico/stdlib.h"
+
+#define PIN_A 6
+#define PIN_B 7
+#define PIN_SW 8
+#define AB_MASK ((1u << PIN_A) | (1u << PIN_B))
+
+#define MAX_EDGES 4096
+
+typedef struct {
+    uint32_t at_us;
+    uint8_t ab; //A in bit 1, B in bit 0, as pec11r_read_ab
+} edge_t;
+
+typedef struct {
+    edge_t e[MAX_EDGES];
+    uint32_t n;
+    uint32_t t; //time of the next clean edge
+} seq_t;
+
+//quadrature from rest (11): cw 11 -> 10 -> 00 -> 01 -> 11, ccw the reverse
+static const uint8_t CW[4] = {2, 0, 1, 3};
+static const uint8_t CCW[4] = {1, 0, 2, 3};
+
+static void push(seq_t *s, uint32_t at, uint8_t ab){
+    CHECK(s->n < MAX_EDGES);
+    s->e[s->n++] = (edge_t){at, ab};
+}
+
+//detents at one edge every gap_us; bounce > 0 makes each edge chatter (new, old, new) bounce us apart;
+//skip = n drops the state after the n-th edge (1-based), so both pins change together there
+static void turn(seq_t *s, int detents, uint32_t gap_us, uint32_t bounce_us, uint32_t skip){
+    const uint8_t *cycle = (detents > 0) ? CW : CCW;
+    uint8_t prev = 3;
+    uint32_t edge = 0;
+    for (int d = 0; d < (detents > 0 ? detents : -detents); d++) {
+        for (int i = 0; i < 4; i++) {
+            uint8_t ab = cycle[i];
+            if (++edge == skip) continue; //never seen
+            if (bounce_us) {
+                push(s, s->t, ab);
+                push(s, s->t + bounce_us, prev);
+                push(s, s->t + 2 * bounce_us, ab);
+            } else {
+                push(s, s->t, ab);
+            }
+            prev = ab;
+            s->t += gap_us;
+        }
+    }
+}
+
+static void set_ab(uint8_t ab){
+    sim_gpio_set_mask(AB_MASK, ((uint32_t)(ab >> 1) << PIN_A) | ((uint32_t)(ab & 1) << PIN_B));
+}
+
+//replays s into pec11r_detent_poll called every poll_us; returns the detent total
+static int replay_polled(const seq_t *s, uint32_t poll_us){
+    static pec11r_t enc;
+    sim_reset();
+    pec11r_init(&enc, PIN_A, PIN_B, UINT32_MAX);
+
+    int pos = 0;
+    uint32_t i = 0;
+    uint32_t end = s->n ? s->e[s->n - 1].at_us + poll_us : 0;
+    for (uint32_t t = 0; t <= end; t += poll_us) {
+        while (i < s->n && s->e[i].at_us <= t) set_ab(s->e[i++].ab);
+        sim_run_until(t);
+        pos += pec11r_detent_poll(&enc);
+    }
+    return pos;
+}
+
+//irq decoding; the handler runs on every edge in the sequence, clock doesn't matter except for the switch
+static pec11r_t irq_enc;
+
+//fresh counters on the same device; the driver has no way to unregister, so it stays in its irq slot
+static void irq_start(void){
+    pec11r_init(&irq_enc, PIN_A, PIN_B, PIN_SW);
+    CHECK(pec11r_irq_enable(&irq_enc));
+}
+
+static int replay_irq(const seq_t *s, uint32_t *cw, uint32_t *ccw){
+    uint64_t t0 = sim_now_us();
+    for (uint32_t i = 0; i < s->n; i++) {
+        sim_run_until(t0 + s->e[i].at_us);
+        set_ab(s->e[i].ab);
+    }
+    *cw = *ccw = 0;
+    pec11r_event_t evt;
+    while (pec11r_event_pop(&irq_enc, &evt)) {
+        if (evt == PEC11R_EVT_CW) (*cw)++;
+        if (evt == PEC11R_EVT_CCW) (*ccw)++;
+    }
+    return (int)pec11r_position(&irq_enc);
+}
+
+static seq_t seq;
+
+static void test_polled(void){
+    //slow and clean: every edge seen
+    memset(&seq, 0, sizeof(seq));
+    turn(&seq, 5, 4000, 0, 0);
+    CHECK_EQ(replay_polled(&seq, 1000), 5);
+
+    memset(&seq, 0, sizeof(seq));
+    turn(&seq, -5, 4000, 0, 0);
+    CHECK_EQ(replay_polled(&seq, 1000), -5);
+
+    //bounce shorter than the poll period is mostly invisible; when a poll lands inside it, +1 -1 +1 cancels
+    memset(&seq, 0, sizeof(seq));
+    turn(&seq, 8, 4000, 30, 0);
+    CHECK_EQ(replay_polled(&seq, 1000), 8);
+
+    //fast spin: edges 300 us apart against a 1 ms poll; several edges fall between polls and alias
+    memset(&seq, 0, sizeof(seq));
+    turn(&seq, 20, 300, 0, 0);
+    int fast = replay_polled(&seq, 1000);
+    printf("polled at 1 ms, 20 detents at 300 us/edge: %d\n", fast);
+    CHECK(fast != 20); //why main.c decodes from the gpio irq instead
+}
+
+static void test_irq(void){
+    uint32_t cw, ccw;
+
+    //fast spin: the irq sees every edge, so nothing is lost however slowly the events are drained
+    irq_start();
+    memset(&seq, 0, sizeof(seq));
+    turn(&seq, 12, 300, 0, 0);
+    CHECK_EQ(replay_irq(&seq, &cw, &ccw), 12);
+    CHECK_EQ(cw, 12);
+    CHECK_EQ(ccw, 0);
+
+    //faster still, with contact bounce on every edge: +1 -1 +1 per edge, never a false detent either way
+    irq_start();
+    memset(&seq, 0, sizeof(seq));
+    turn(&seq, 8, 100, 5, 0);
+    turn(&seq, -5, 100, 5, 0);
+    CHECK_EQ(replay_irq(&seq, &cw, &ccw), 3);
+    CHECK_EQ(cw, 8);
+    CHECK_EQ(ccw, 5);
+
+    //missed edge (both pins change between two irqs): that step decodes as 0, so the count may come up one short
+    //but never reverses, and the detents after it still count
+    for (uint32_t skip = 1; skip <= 8; skip++) {
+        irq_start();
+        memset(&seq, 0, sizeof(seq));
+        turn(&seq, 10, 200, 0, skip);
+        int pos = replay_irq(&seq, &cw, &ccw);
+        CHECK(pos >= 9 && pos <= 10);
+        CHECK_EQ(ccw, 0);
+
+        irq_start();
+        memset(&seq, 0, sizeof(seq));
+        turn(&seq, 10, 200, 3, skip * 5); //with bounce as well
+        pos = replay_irq(&seq, &cw, &ccw);
+        CHECK(pos >= 9 && pos <= 10);
+        CHECK_EQ(ccw, 0);
+    }
+
+    //queue overflow: position stays exact, the events beyond the queue are counted as dropped
+    irq_start();
+    memset(&seq, 0, sizeof(seq));
+    turn(&seq, 40, 150, 0, 0);
+    CHECK_EQ(replay_irq(&seq, &cw, &ccw), 40);
+    CHECK_EQ(cw, PEC11R_EVT_QUEUE - 1);
+    CHECK_EQ(irq_enc.evt_dropped, 40 - (PEC11R_EVT_QUEUE - 1));
+}
+
+static void test_button(void){
+    irq_start();
+    uint64_t t = sim_now_us() + 100000;
+    //press with 2 ms of chatter, release with chatter, press again
+    const struct { uint64_t at; bool level; } sw[] = {
+        {t, 0}, {t + 300, 1}, {t + 700, 0}, {t + 1500, 1}, {t + 2000, 0},
+        {t + 150000, 1}, {t + 150400, 0}, {t + 151000, 1},
+        {t + 300000, 0}
+    };
+    for (size_t i = 0; i < count_of(sw); i++) {
+        sim_run_until(sw[i].at);
+        sim_gpio_set(PIN_SW, sw[i].level);
+    }
+    pec11r_event_t evt;
+    int presses = 0;
+    while (pec11r_event_pop(&irq_enc, &evt)) {
+        CHECK_EQ(evt, PEC11R_EVT_PRESS);
+        presses++;
+    }
+    CHECK_EQ(presses, 2);
+}
+
+//quick taps: each release lands inside the press's debounce window, so only the re-read after the
+//window sees it; without that the next press looks like no change and is lost
+static void test_quick_taps(void){
+    irq_start();
+    uint64_t t = sim_now_us() + 100000;
+    const struct { uint64_t at; bool level; } sw[] = {
+        {t, 0}, {t + 8000, 1}, //clean 8 ms tap
+        {t + 60000, 0}, {t + 60200, 1}, {t + 60500, 0}, {t + 72000, 1}, //chattery press, 12 ms tap
+        {t + 100000, 0}, {t + 100300, 1}, {t + 100600, 0}, {t + 100900, 1}, //release chatter, all in the window
+        {t + 140000, 0}, {t + 250000, 1}, //long press after all that
+    };
+    for (size_t i = 0; i < count_of(sw); i++) {
+        sim_run_until(sw[i].at);
+        sim_gpio_set(PIN_SW, sw[i].level);
+    }
+    sim_run_until(t + 300000);
+    pec11r_event_t evt;
+    int presses = 0;
+    while (pec11r_event_pop(&irq_enc, &evt)) {
+        CHECK_EQ(evt, PEC11R_EVT_PRESS);
+        presses++;
+    }
+    CHECK_EQ(presses, 4);
+    CHECK(!irq_enc.sw_held); //released at the end
+}
+
+int main(void){
+    test_polled();
+    test_irq();
+    test_button();
+    test_quick_taps();
+    printf("test_pec11r: ok\n");
+    return 0;
+}
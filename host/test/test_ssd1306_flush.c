@@ -0,0 +1,164 @@
+//ssd1306 flushes against the simulated i2c controller, dma and an ssd1306 model: what reaches the panel,
+//how many transactions it takes, and that the async paths return before the bus work is done
+#include <stdio.h>
+#include <string.h>
+#include "check.h"
+#include "sim.h"
+#include "ssd1306_model.h"
+#include "ssd1306.h"
+#include "i2c_bus.h"
+#include "i2c_queue_rp2040.h"
+#include "pico/stdlib.h"
+
+static const i2c_bus_t BUS = {i2c0, 4, 5, 400 * 1000};
+
+static ssd1306_model_t panel;
+static ssd1306_t oled;
+static uint32_t callbacks;
+
+static void on_flushed(void *ctx){
+    callbacks++;
+}
+
+static void test_blocking(void){
+    CHECK(ssd1306_init(&oled, BUS.port, SSD1306_ADDR_0x3C, 0));
+    CHECK(panel.on);
+    CHECK_EQ(ssd1306_model_diff(&panel, oled.buffer), 0); //power-on garbage cleared by one full frame
+
+    //one pixel: a one-column window, one transaction
+    ssd1306_reset_stats(&oled);
+    uint32_t before = panel.transactions;
+    ssd1306_draw_pixel(&oled, 70, 20, true);
+    uint32_t skipped;
+    CHECK(ssd1306_show_dirty(&oled, &skipped));
+    CHECK_EQ(skipped, BUFFER_SIZE - 1);
+    CHECK_EQ(panel.transactions - before, 1);
+    CHECK_EQ(oled.stats.bytes, WINDOW_HEADER_SIZE + 1);
+    CHECK_EQ(ssd1306_model_diff(&panel, oled.buffer), 0);
+
+    //nothing dirty: no traffic
+    before = panel.transactions;
+    CHECK(ssd1306_show_dirty(&oled, NULL));
+    CHECK_EQ(panel.transactions, before);
+}
+
+static void test_async(void){
+    //text across two pages; the call returns with the frame still on the wire
+    ssd1306_draw_string(&oled, 10, 4, "FLUSH", 1, TRUNCATE);
+    uint8_t sent[BUFFER_SIZE];
+    memcpy(sent, oled.buffer, sizeof(sent));
+
+    uint64_t t0 = sim_now_us();
+    callbacks = 0;
+    CHECK(ssd1306_show_async(&oled, on_flushed, NULL));
+    CHECK_EQ(sim_now_us(), t0); //no bus time spent in the call
+    CHECK(!ssd1306_flush_done(&oled));
+    CHECK(!ssd1306_show_async(&oled, on_flushed, NULL)); //one frame in flight at a time
+
+    //drawing goes on in the back buffer while the front one streams
+    ssd1306_draw_string(&oled, 10, 30, "NEXT", 1, TRUNCATE);
+    ssd1306_flush_wait(&oled);
+    CHECK_EQ(callbacks, 1);
+    CHECK(sim_now_us() > t0);
+    CHECK_EQ(ssd1306_model_diff(&panel, sent), 0); //the panel has the frame as it was at the call
+
+    //and the later drawing is still dirty for the next flush
+    CHECK(oled.dirty_pages != 0);
+    CHECK(ssd1306_show_async(&oled, on_flushed, NULL));
+    ssd1306_flush_wait(&oled);
+    CHECK_EQ(callbacks, 2);
+    CHECK_EQ(ssd1306_model_diff(&panel, oled.buffer), 0);
+
+    //clean buffer: callback straight away, no dma
+    CHECK(ssd1306_show_async(&oled, on_flushed, NULL));
+    CHECK_EQ(callbacks, 3);
+    CHECK(ssd1306_flush_done(&oled));
+}
+
+static void test_async_nack(void){
+    //panel unplugged mid-run: the abort is cleared and the whole frame is resent once it answers again
+    i2c_bus_stats_reset();
+    sim_i2c_detach(BUS.port, SSD1306_ADDR_0x3C);
+    ssd1306_draw_pixel(&oled, 1, 1, true);
+    CHECK(ssd1306_show_async(&oled, NULL, NULL));
+    ssd1306_flush_wait(&oled);
+    CHECK_EQ(oled.dirty_pages, 0xFF);
+
+    i2c_bus_stats_t st;
+    i2c_bus_stats_snapshot(&st);
+    CHECK_EQ(st.count, 1);
+    CHECK_EQ(st.devs[0].nacks, 1);
+
+    sim_i2c_attach(BUS.port, &panel.dev);
+    CHECK(ssd1306_show_async(&oled, NULL, NULL));
+    ssd1306_flush_wait(&oled);
+    CHECK_EQ(ssd1306_model_diff(&panel, oled.buffer), 0);
+}
+
+static void test_queued(void){
+    static i2c_queue_t q;
+    i2c_queue_rp2040_init(&q, BUS.port);
+    i2c_bus_attach_queue(BUS.port, &q);
+    CHECK(!ssd1306_show_async(&oled, NULL, NULL)); //the queue owns the controller now
+
+    ssd1306_fill_buffer(&oled);
+    uint32_t before = panel.transactions;
+    callbacks = 0;
+    uint64_t t0 = sim_now_us();
+    CHECK(ssd1306_show_queued(&oled, &q, on_flushed, NULL));
+    CHECK_EQ(sim_now_us(), t0);
+    ssd1306_flush_wait(&oled);
+    CHECK_EQ(callbacks, 1);
+    CHECK_EQ(ssd1306_model_diff(&panel, oled.buffer), 0); //chunks continue where the last one stopped
+
+    uint32_t len = WINDOW_HEADER_SIZE + BUFFER_SIZE;
+    CHECK_EQ(panel.transactions - before, (len + SSD1306_QUEUE_CHUNK - 1) / SSD1306_QUEUE_CHUNK);
+
+    //blocking writes wait for the queued frame, then go through the queue too
+    ssd1306_clear_buffer(&oled);
+    CHECK(ssd1306_show_queued(&oled, &q, NULL, NULL));
+    CHECK(ssd1306_show(&oled));
+    CHECK_EQ(ssd1306_model_diff(&panel, oled.buffer), 0);
+    i2c_bus_attach_queue(BUS.port, NULL);
+}
+
+//two panels on one queue: each queued frame is sent from its own device, so the other panel's
+//flushes and blocking writes can't overwrite it while it waits its turn
+static void test_queued_two_panels(void){
+    static i2c_queue_t q;
+    static ssd1306_model_t panel2;
+    static ssd1306_t oled2;
+    ssd1306_model_init(&panel2, BUS.port, SSD1306_ADDR_0x3D);
+    CHECK(ssd1306_init(&oled2, BUS.port, SSD1306_ADDR_0x3D, 0));
+    i2c_queue_rp2040_init(&q, BUS.port);
+    i2c_bus_attach_queue(BUS.port, &q);
+
+    ssd1306_fill_buffer(&oled);
+    ssd1306_clear_buffer(&oled2);
+    ssd1306_draw_string(&oled2, 0, 0, "SECOND", 2, TRUNCATE);
+    CHECK(ssd1306_show_queued(&oled, &q, NULL, NULL));
+    CHECK(ssd1306_show_queued(&oled2, &q, NULL, NULL));
+    CHECK(!ssd1306_flush_done(&oled)); //both still queued
+
+    //more drawing on the second panel, flushed the blocking way behind both frames
+    ssd1306_draw_string(&oled2, 0, 32, "PANEL", 2, TRUNCATE);
+    CHECK(ssd1306_show_dirty(&oled2, NULL));
+    ssd1306_flush_wait(&oled);
+    CHECK_EQ(ssd1306_model_diff(&panel, oled.buffer), 0);
+    CHECK_EQ(ssd1306_model_diff(&panel2, oled2.buffer), 0);
+    i2c_bus_attach_queue(BUS.port, NULL);
+}
+
+int main(void){
+    sim_reset();
+    i2c_bus_init(&BUS);
+    ssd1306_model_init(&panel, BUS.port, SSD1306_ADDR_0x3C);
+
+    test_blocking();
+    test_async();
+    test_async_nack();
+    test_queued();
+    test_queued_two_panels();
+    printf("test_ssd1306_flush: ok\n");
+    return 0;
+}
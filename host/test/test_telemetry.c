@@ -0,0 +1,228 @@
+//telemetry frames: crc16 check value, cobs against a reference decoder (including 254/255-byte zero-free runs),
+//full batches at exactly TELEM_FRAME_MAX, and every field of telem_push/telem_flush output read back.
+//with a path argument, also writes the frames as a capture for tools/telemetry_decode.py
+#include <stdio.h>
+#include <string.h>
+#include "check.h"
+#include "crc16.h"
+#include "telemetry.h"
+
+#define SAMPLES 100 //33 full frames and a partial one
+
+//the textbook decoder, written independently of cobs_encode; returns the decoded length, -1 if malformed
+static int cobs_decode(const uint8_t *in, uint32_t len, uint8_t *out){
+    uint32_t i = 0, o = 0;
+    while (i < len) {
+        uint8_t code = in[i];
+        if (code == 0 || i + code > len) return -1;
+        for (uint32_t k = 1; k < code; k++) out[o++] = in[i + k];
+        i += code;
+        if (code < 0xFF && i < len) out[o++] = 0;
+    }
+    return (int)o;
+}
+
+static uint8_t in[1200], enc[1300], dec[1300];
+
+//encodes in[0, len), checks the bound, that no zero survives, and that it decodes back
+static uint32_t round_trip(uint32_t len){
+    uint32_t n = cobs_encode(in, len, enc);
+    CHECK(n >= len + 1);
+    CHECK(n <= len + len / 254 + 1);
+    for (uint32_t i = 0; i < n; i++) CHECK(enc[i] != 0);
+    CHECK_EQ(cobs_decode(enc, n, dec), len);
+    CHECK(memcmp(in, dec, len) == 0);
+    return n;
+}
+
+static void test_crc(void){
+    CHECK_EQ(crc16_ccitt((const uint8_t *)"123456789", 9), 0x29B1); //ccitt-false check value
+    CHECK_EQ(crc16_ccitt(NULL, 0), 0xFFFF);
+}
+
+static void test_cobs(void){
+    //small cases straight from the spec
+    static const uint8_t zero[] = {0x00}, two_zeros[] = {0x00, 0x00}, mixed[] = {0x11, 0x22, 0x00, 0x33};
+    static const uint8_t zero_enc[] = {0x01, 0x01}, two_zeros_enc[] = {0x01, 0x01, 0x01}, mixed_enc[] = {0x03, 0x11, 0x22, 0x02, 0x33};
+    CHECK_EQ(cobs_encode(in, 0, enc), 1);
+    CHECK_EQ(enc[0], 0x01);
+    CHECK_EQ(cobs_encode(zero, sizeof(zero), enc), sizeof(zero_enc));
+    CHECK(memcmp(enc, zero_enc, sizeof(zero_enc)) == 0);
+    CHECK_EQ(cobs_encode(two_zeros, sizeof(two_zeros), enc), sizeof(two_zeros_enc));
+    CHECK(memcmp(enc, two_zeros_enc, sizeof(two_zeros_enc)) == 0);
+    CHECK_EQ(cobs_encode(mixed, sizeof(mixed), enc), sizeof(mixed_enc));
+    CHECK(memcmp(enc, mixed_enc, sizeof(mixed_enc)) == 0);
+
+    //zero-free runs around the 254-byte block limit, where a code byte has no implied zero
+    for (uint32_t i = 0; i < sizeof(in); i++) in[i] = (uint8_t)(i % 255 + 1);
+    for (uint32_t len = 250; len <= 260; len++) round_trip(len);
+    CHECK_EQ(round_trip(253), 254);
+    CHECK_EQ(enc[0], 0xFE);
+    CHECK_EQ(round_trip(254), 256);
+    CHECK_EQ(enc[0], 0xFF);
+    CHECK_EQ(enc[255], 0x01); //empty block after a full one
+    CHECK_EQ(round_trip(255), 257);
+    CHECK_EQ(enc[0], 0xFF);
+    CHECK_EQ(enc[255], 0x02);
+    CHECK_EQ(round_trip(508), 511);
+
+    //a zero right at the block limit, and either side of it
+    for (uint32_t at = 252; at <= 256; at++) {
+        for (uint32_t i = 0; i < sizeof(in); i++) in[i] = (uint8_t)(i % 255 + 1);
+        in[at] = 0;
+        round_trip(600);
+    }
+
+    //random data, sparse and dense in zeros
+    uint32_t x = 0x2545F491u; //xorshift; the same data every run
+    for (uint32_t pass = 0; pass < 200; pass++) {
+        uint32_t len = pass * 5 % sizeof(in);
+        for (uint32_t i = 0; i < len; i++) {
+            x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+            in[i] = (pass & 1) ? (uint8_t)x : (uint8_t)(x % 300 < 256 ? x % 300 : 0);
+        }
+        round_trip(len);
+    }
+}
+
+typedef struct {
+    uint8_t buf[SAMPLES * TELEM_FRAME_MAX];
+    uint32_t len;
+    uint32_t writes;
+    uint32_t last; //length of the newest write
+} sink_t;
+
+static void sink_write(const uint8_t *buf, uint32_t len, void *ctx){
+    sink_t *k = (sink_t *)ctx;
+    CHECK(len <= TELEM_FRAME_MAX);
+    CHECK(k->len + len <= sizeof(k->buf));
+    memcpy(k->buf + k->len, buf, len);
+    k->len += len;
+    k->writes++;
+    k->last = len;
+}
+
+static uint32_t get_u32(const uint8_t *p){
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static telem_sample_t sample(uint32_t i){
+    static const int32_t edges[] = {INT32_MIN, -1, 0, INT32_MAX};
+    telem_sample_t s = {
+        .uptime_ms = i * 500,
+        .temp_cc = -1234 + (int32_t)i * 57,
+        .humidity_cp = 4567 - (int32_t)i * 13,
+        .lux_mlux = (int32_t)(i * i * 1001),
+        .score = (uint8_t)(i % 11),
+        .flags = (uint8_t)(i % 16),
+    };
+    if (i % 10 == 7) s.lux_mlux = edges[i / 10 % 4]; //full-range fields in a few frames
+    if (i == 0) s.flags = 0x5; //ok, ok
+    return s;
+}
+
+static sink_t sink;
+
+//frames are 0x00 | cobs | 0x00; reads them all back and checks them against sample()
+static void check_stream(uint32_t frames){
+    uint32_t i = 0, seq = 0, next_sample = 0;
+    while (i < sink.len) {
+        CHECK_EQ(sink.buf[i], 0x00);
+        uint32_t end = i + 1;
+        while (end < sink.len && sink.buf[end] != 0x00) end++;
+        CHECK(end < sink.len); //closing delimiter
+
+        int n = cobs_decode(sink.buf + i + 1, end - i - 1, dec);
+        CHECK(n >= TELEM_HEADER_BYTES + 2);
+        uint16_t crc = (uint16_t)(dec[n - 2] | dec[n - 1] << 8);
+        CHECK_EQ(crc, crc16_ccitt(dec, (uint32_t)n - 2));
+        CHECK_EQ(dec[0], TELEM_VERSION);
+        CHECK_EQ(dec[1], TELEM_TYPE_SAMPLES);
+        CHECK_EQ(dec[2] | dec[3] << 8, seq);
+        uint8_t count = dec[4];
+        CHECK(count >= 1 && count <= TELEM_BATCH);
+        CHECK_EQ(n, TELEM_HEADER_BYTES + count * TELEM_SAMPLE_BYTES + 2);
+
+        for (uint8_t k = 0; k < count; k++, next_sample++) {
+            const uint8_t *p = dec + TELEM_HEADER_BYTES + k * TELEM_SAMPLE_BYTES;
+            telem_sample_t want = sample(next_sample);
+            CHECK_EQ(get_u32(p), want.uptime_ms);
+            CHECK_EQ((int32_t)get_u32(p + 4), want.temp_cc);
+            CHECK_EQ((int32_t)get_u32(p + 8), want.humidity_cp);
+            CHECK_EQ((int32_t)get_u32(p + 12), want.lux_mlux);
+            CHECK_EQ(p[16], want.score);
+            CHECK_EQ(p[17], want.flags);
+        }
+        seq++;
+        i = end + 1;
+    }
+    CHECK_EQ(seq, frames);
+    CHECK_EQ(next_sample, SAMPLES);
+}
+
+static telem_t t;
+
+static void test_frames(void){
+    CHECK_EQ(TELEM_FRAME_MAX, 64); //one usb full-speed packet
+
+    memset(&sink, 0, sizeof(sink));
+    telem_init(&t, sink_write, &sink);
+    telem_flush(&t); //nothing queued, nothing sent
+    CHECK_EQ(sink.writes, 0);
+
+    for (uint32_t i = 0; i < SAMPLES; i++) {
+        telem_sample_t s = sample(i);
+        uint32_t before = sink.writes;
+        telem_push(&t, &s);
+        if ((i + 1) % TELEM_BATCH == 0) {
+            CHECK_EQ(sink.writes, before + 1);
+            CHECK_EQ(sink.last, TELEM_FRAME_MAX); //a full batch always fills the packet exactly
+        } else {
+            CHECK_EQ(sink.writes, before);
+        }
+    }
+    telem_flush(&t);
+    CHECK_EQ(sink.last, 1 + (TELEM_HEADER_BYTES + TELEM_SAMPLE_BYTES + 2) + 1 + 1);
+    telem_flush(&t);
+    CHECK_EQ(t.frames, SAMPLES / TELEM_BATCH + 1);
+    CHECK_EQ(t.bytes, sink.len);
+    check_stream(t.frames);
+
+    //all-zero samples are the worst case for cobs: still 64 bytes
+    memset(&sink, 0, sizeof(sink));
+    telem_init(&t, sink_write, &sink);
+    telem_sample_t z = {0};
+    for (int i = 0; i < TELEM_BATCH; i++) telem_push(&t, &z);
+    CHECK_EQ(sink.len, TELEM_FRAME_MAX);
+}
+
+//the same stream as test_frames, with a stray text line between frames for the decoder to resync past
+static void write_capture(const char *path){
+    memset(&sink, 0, sizeof(sink));
+    telem_init(&t, sink_write, &sink);
+    for (uint32_t i = 0; i < SAMPLES; i++) {
+        telem_sample_t s = sample(i);
+        telem_push(&t, &s);
+        if (i == SAMPLES / 2) {
+            static const char text[] = "greeneye: boot log line\r\n";
+            memcpy(sink.buf + sink.len, text, sizeof(text) - 1);
+            sink.len += sizeof(text) - 1;
+        }
+    }
+    telem_flush(&t);
+
+    FILE *f = fopen(path, "wb");
+    CHECK(f);
+    CHECK_EQ(fwrite(sink.buf, 1, sink.len, f), sink.len);
+    CHECK(fclose(f) == 0);
+    printf("wrote %u frames, %u bytes to %s\n", (unsigned)t.frames, (unsigned)sink.len, path);
+}
+
+int main(int argc, char **argv){
+    test_crc();
+    test_cobs();
+    test_frames();
+    if (argc > 1) write_capture(argv[1]);
+    printf("test_telemetry: ok\n");
+    return 0;
+}
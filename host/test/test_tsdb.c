@@ -0,0 +1,215 @@
+//tsdb: delta/zigzag/varint round trips at the int32 extremes, minute/hour rollups against a brute-force
+//reference, queries across a recycled block, and how much history a series holds in its fixed footprint
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "check.h"
+#include "tsdb.h"
+
+#define MAX_POINTS 4096
+
+typedef struct {
+    tsdb_point_t p[MAX_POINTS];
+    uint32_t n;
+    uint32_t stop_after; //0 = visit everything
+} collect_t;
+
+static bool collect(const tsdb_point_t *p, void *ctx){
+    collect_t *c = (collect_t *)ctx;
+    CHECK(c->n < MAX_POINTS);
+    c->p[c->n++] = *p;
+    return !c->stop_after || c->n < c->stop_after;
+}
+
+static uint32_t query(const tsdb_series_t *s, tsdb_tier_id_t tier, uint32_t t0, uint32_t t1, collect_t *c){
+    memset(c, 0, sizeof(*c));
+    uint32_t n = tsdb_query(s, tier, t0, t1, collect, c);
+    CHECK_EQ(n, c->n);
+    return n;
+}
+
+static uint32_t rng = 0x9E3779B9u; //xorshift; the same series every run
+
+static uint32_t next(void){
+    rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+    return rng;
+}
+
+static tsdb_series_t s;
+static collect_t got;
+
+//every raw step the codec has to carry exactly: full-range swings, repeats, zero and huge time gaps
+static void test_codec_extremes(void){
+    static const struct { uint32_t dt; int32_t v; } steps[] = {
+        {0, INT32_MIN}, {1, INT32_MAX}, {0, INT32_MIN}, {1, INT32_MIN}, {1, INT32_MIN}, {0, 0}, {1, -1},
+        {1, 1}, {1, INT32_MAX}, {1, -INT32_MAX}, {0x7FFFFFFFu, 42}, {1, 42}, {127, 43}, {128, -43}, {16384, 0},
+    };
+    const uint32_t n = sizeof(steps) / sizeof(steps[0]);
+    tsdb_init(&s);
+    uint32_t ts = 1000;
+    uint32_t want_ts[sizeof(steps) / sizeof(steps[0])];
+    for (uint32_t i = 0; i < n; i++) {
+        ts += steps[i].dt;
+        want_ts[i] = ts;
+        tsdb_append(&s, ts, steps[i].v);
+    }
+
+    CHECK_EQ(query(&s, TSDB_RAW, 0, UINT32_MAX, &got), n);
+    for (uint32_t i = 0; i < n; i++) {
+        CHECK_EQ(got.p[i].ts, want_ts[i]);
+        CHECK_EQ(got.p[i].avg, steps[i].v);
+        CHECK_EQ(got.p[i].min, steps[i].v);
+        CHECK_EQ(got.p[i].max, steps[i].v);
+    }
+
+    //worst-case records (5-byte varints) still decode when they spill into the next block
+    tsdb_init(&s);
+    for (uint32_t i = 0; i < 100; i++) tsdb_append(&s, 0x02000000u * i, (i & 1) ? INT32_MIN : INT32_MAX);
+    CHECK_EQ(query(&s, TSDB_RAW, 0, UINT32_MAX, &got), 100); //16 blocks hold 100 of these before recycling
+    for (uint32_t i = 0; i < 100; i++) {
+        CHECK_EQ(got.p[i].ts, 0x02000000u * i);
+        CHECK_EQ(got.p[i].avg, (i & 1) ? INT32_MIN : INT32_MAX);
+    }
+}
+
+#define HOURS 6
+#define SAMPLES (HOURS * 3600)
+
+static int32_t values[SAMPLES]; //one sample a second, starting at ts 0
+
+//min/max/avg of values[from, to) as the accumulators build them: avg is the truncated mean
+static tsdb_point_t reference(uint32_t from, uint32_t to){
+    tsdb_point_t p = {from, 0, values[from], values[from]};
+    int64_t sum = 0;
+    for (uint32_t i = from; i < to; i++) {
+        if (values[i] < p.min) p.min = values[i];
+        if (values[i] > p.max) p.max = values[i];
+        sum += values[i];
+    }
+    p.avg = (int32_t)(sum / (int64_t)(to - from));
+    return p;
+}
+
+static void check_rollups(tsdb_tier_id_t tier, uint32_t bucket_s){
+    uint32_t n = query(&s, tier, 0, UINT32_MAX, &got);
+    CHECK(n > 0);
+    for (uint32_t i = 0; i < n; i++) {
+        const tsdb_point_t *p = &got.p[i];
+        CHECK_EQ(p->ts % bucket_s, 0);
+        if (i) CHECK_EQ(p->ts, got.p[i - 1].ts + bucket_s); //no bucket skipped
+        tsdb_point_t want = reference(p->ts, p->ts + bucket_s);
+        CHECK_EQ(p->avg, want.avg);
+        CHECK_EQ(p->min, want.min);
+        CHECK_EQ(p->max, want.max);
+    }
+    //only closed buckets are written; the last one, still open, stays in the accumulator
+    CHECK_EQ(got.p[n - 1].ts + 2 * bucket_s, SAMPLES);
+}
+
+static void test_rollups(void){
+    tsdb_init(&s);
+    int32_t v = 2200;
+    for (uint32_t i = 0; i < SAMPLES; i++) {
+        v += (int32_t)(next() % 41) - 20; //noisy walk, with the odd spike below
+        values[i] = (next() % 500 == 0) ? v + (int32_t)(next() % 20001) - 10000 : v;
+        tsdb_append(&s, i, values[i]);
+    }
+    check_rollups(TSDB_MINUTE, 60);
+    check_rollups(TSDB_HOUR, 3600);
+    CHECK_EQ(query(&s, TSDB_HOUR, 0, UINT32_MAX, &got), HOURS - 1);
+
+    //summary over whole hours of the minute tier equals the hour tier's min/max
+    tsdb_point_t sum_min, hour;
+    CHECK(tsdb_summary(&s, TSDB_MINUTE, 3 * 3600, 4 * 3600 - 1, &sum_min));
+    CHECK(tsdb_summary(&s, TSDB_HOUR, 3 * 3600, 3 * 3600, &hour));
+    CHECK_EQ(sum_min.min, hour.min);
+    CHECK_EQ(sum_min.max, hour.max);
+    CHECK_EQ(sum_min.ts, 3 * 3600);
+}
+
+//raw ring has long since recycled its oldest blocks: queries start at what is still held
+static void test_recycled_queries(void){
+    //s still holds test_rollups' series; the raw tier keeps only the newest samples
+    CHECK_EQ(s.tiers[TSDB_RAW].used, TSDB_RAW_BLOCKS);
+    uint32_t oldest = s.tiers[TSDB_RAW].meta[s.tiers[TSDB_RAW].head].first_ts;
+    CHECK(oldest > 0);
+
+    //range straddling the recycled boundary: starts at the oldest held sample, nothing from before it
+    uint32_t n = query(&s, TSDB_RAW, oldest - 100, oldest + 50, &got);
+    CHECK_EQ(n, 51);
+    for (uint32_t i = 0; i < n; i++) {
+        CHECK_EQ(got.p[i].ts, oldest + i);
+        CHECK_EQ(got.p[i].avg, values[oldest + i]);
+    }
+
+    //range inside one block and across block boundaries, against the reference
+    uint32_t newest = SAMPLES - 1;
+    for (uint32_t t0 = oldest; t0 < newest; t0 += 97) {
+        uint32_t t1 = t0 + 150 > newest ? newest : t0 + 150;
+        CHECK_EQ(query(&s, TSDB_RAW, t0, t1, &got), t1 - t0 + 1);
+        CHECK_EQ(got.p[0].ts, t0);
+        CHECK_EQ(got.p[got.n - 1].ts, t1);
+        CHECK_EQ(got.p[got.n - 1].avg, values[t1]);
+
+        tsdb_point_t sum, want = reference(t0, t1 + 1);
+        CHECK(tsdb_summary(&s, TSDB_RAW, t0, t1, &sum));
+        CHECK_EQ(sum.min, want.min);
+        CHECK_EQ(sum.max, want.max);
+        CHECK_EQ(sum.avg, want.avg); //raw points are single samples, so the mean of avgs is the mean
+    }
+
+    //bounds: empty, inverted, single point, past the end, early stop
+    CHECK_EQ(query(&s, TSDB_RAW, 0, oldest - 1, &got), 0);
+    CHECK_EQ(query(&s, TSDB_RAW, newest, oldest, &got), 0);
+    CHECK_EQ(query(&s, TSDB_RAW, newest + 1, UINT32_MAX, &got), 0);
+    CHECK_EQ(query(&s, TSDB_RAW, newest, newest, &got), 1);
+    CHECK_EQ(query(&s, (tsdb_tier_id_t)TSDB_TIERS, 0, UINT32_MAX, &got), 0);
+    tsdb_point_t none;
+    CHECK(!tsdb_summary(&s, TSDB_RAW, 0, oldest - 1, &none));
+    memset(&got, 0, sizeof(got));
+    got.stop_after = 5;
+    CHECK_EQ(tsdb_query(&s, TSDB_RAW, oldest, newest, collect, &got), 5);
+}
+
+//one sample a second, like the aht20 in main.c, for long enough that every tier has wrapped
+static void test_capacity(void){
+    const uint32_t days = 10;
+    tsdb_init(&s);
+    int32_t v = 2200;
+    for (uint32_t t = 0; t < days * 86400; t++) {
+        v += (int32_t)(next() % 7) - 3; //sensor noise, a few centi-degrees
+        if (v < 1500) v = 1500;
+        if (v > 3000) v = 3000;
+        tsdb_append(&s, t, v);
+    }
+
+    static const char *NAMES[TSDB_TIERS] = {"raw", "1min", "1h"};
+    static const uint32_t CAP[TSDB_TIERS] = {TSDB_RAW_BLOCKS, TSDB_MINUTE_BLOCKS, TSDB_HOUR_BLOCKS};
+    uint32_t span[TSDB_TIERS];
+    for (int i = 0; i < TSDB_TIERS; i++) {
+        const tsdb_tier_t *t = &s.tiers[i];
+        uint32_t points, bytes;
+        tsdb_usage(&s, (tsdb_tier_id_t)i, &points, &bytes);
+        span[i] = t->last_ts - t->meta[t->head].first_ts;
+        CHECK(bytes <= CAP[i] * TSDB_BLOCK_BYTES);
+        CHECK_EQ(query(&s, (tsdb_tier_id_t)i, 0, UINT32_MAX, &got), points);
+        printf("%-4s %5u points in %4u bytes, %.1f h\n", NAMES[i], (unsigned)points, (unsigned)bytes, span[i] / 3600.0);
+    }
+    printf("series: %zu bytes, all three %zu bytes\n", sizeof(tsdb_series_t), 3 * sizeof(tsdb_series_t));
+
+    //"days of data in a few KB": a series fits in 6 KB and its hour tier reaches back a week;
+    //raw at ~2 bytes a sample only covers the last few minutes, the minute tier most of a working day
+    CHECK(sizeof(tsdb_series_t) <= 6 * 1024);
+    CHECK(span[TSDB_HOUR] >= 6 * 86400);
+    CHECK(span[TSDB_MINUTE] >= 8 * 3600);
+    CHECK(span[TSDB_RAW] >= 5 * 60);
+}
+
+int main(void){
+    test_codec_extremes();
+    test_rollups();
+    test_recycled_queries();
+    test_capacity();
+    printf("test_tsdb: ok\n");
+    return 0;
+}
@@ -1,6 +1,16 @@
 #include "i2c_bus.h"
 #include "hardware/gpio.h"
+#include "pico/stdlib.h"
+#include "pico/critical_section.h"
 #include <stdio.h>
+#include <string.h>
+
+//per-device counters; sensors on core0 and the oled on core1 both record, so updates take the lock
+static i2c_bus_stats_t stats;
+static critical_section_t stats_lock;
+static bool stats_lock_ready = false;
+
+static i2c_queue_t *queues[NUM_I2CS]; //per port, NULL = blocking sdk calls
 
 void i2c_bus_init(const i2c_bus_t *bus){
     i2c_init(bus->port, bus->freq_hz);
@@ -10,17 +20,20 @@ void i2c_bus_init(const i2c_bus_t *bus){
 
     gpio_pull_up(bus->sda_pin);
     gpio_pull_up(bus->scl_pin);
+
+    if (!stats_lock_ready) {
+        critical_section_init(&stats_lock);
+        stats_lock_ready = true;
+        stats.since_us = time_us_64();
+    }
 }
 
 int i2c_bus_scan(const i2c_bus_t *bus){
     int count = 0;
     printf("\nStarting i2c scan.");
     
-    //ret = common practice shorthand in c for "returned value"
     for (uint8_t addr = 0x08; addr <= 0x77; addr++) { 
-        uint8_t dummy; //empty integer that takes up 8 bits of memory
-        int ret = i2c_read_blocking(bus->port, addr, &dummy, 1, false); //read returned value into the dummy's memory location
-        if (ret >= 0) {
+        if (i2c_bus_probe(bus, addr)) {
             printf("\nFound device at 0x%02X\n", addr);
             count++;
         }
@@ -28,4 +41,265 @@ int i2c_bus_scan(const i2c_bus_t *bus){
 
     printf("\nFinished i2c scan.\n");   
     return count;
-}
\ No newline at end of file
+}
+
+#define PROBE_TIMEOUT_US 2000 //a present device answers in ~0.2 ms at 100 kHz; this only bounds a stuck bus
+
+bool i2c_bus_probe(const i2c_bus_t *bus, uint8_t addr){
+    uint8_t dummy; //empty integer that takes up 8 bits of memory
+    //not recorded: every absent address would take a row in the stats table
+    return i2c_read_timeout_us(bus->port, addr, &dummy, 1, false, PROBE_TIMEOUT_US) >= 0;
+}
+
+#define CLOCKS_PER_BYTE 9 //8 data bits + ack
+#define CLOCKS_PER_TRANSACTION (CLOCKS_PER_BYTE + 2) //address byte, plus about a clock each for start and stop
+
+uint32_t i2c_bus_wire_us(const i2c_bus_t *bus, uint32_t transactions, uint32_t bytes){
+    uint64_t clocks = (uint64_t)transactions * CLOCKS_PER_TRANSACTION + (uint64_t)bytes * CLOCKS_PER_BYTE;
+    return (uint32_t)((clocks * 1000000u + bus->freq_hz - 1) / bus->freq_hz);
+}
+
+//helper; finds or adds the entry for a device, NULL once the table is full. call with the lock held
+static i2c_bus_dev_stats_t *dev_stats(i2c_inst_t *port, uint8_t addr){
+    for (uint8_t i = 0; i < stats.count; i++) {
+        if (stats.devs[i].port == port && stats.devs[i].addr == addr) return &stats.devs[i];
+    }
+    if (stats.count == I2C_BUS_MAX_DEVICES) return NULL;
+
+    i2c_bus_dev_stats_t *d = &stats.devs[stats.count++];
+    memset(d, 0, sizeof(*d));
+    d->port = port;
+    d->addr = addr;
+    return d;
+}
+
+void i2c_bus_record(i2c_inst_t *port, uint8_t addr, size_t len, int result, uint32_t us){
+    if (!stats_lock_ready) return;
+
+    critical_section_enter_blocking(&stats_lock);
+    i2c_bus_dev_stats_t *d = dev_stats(port, addr);
+    if (d) {
+        d->transactions++;
+        if (result > 0) d->bytes += (uint32_t)result;
+        if (result == PICO_ERROR_GENERIC) {
+            d->nacks++;
+        } else if (result != (int)len) {
+            d->errors++;
+        }
+        d->total_us += us;
+        if (us > d->max_us) d->max_us = us;
+    }
+    critical_section_exit(&stats_lock);
+}
+
+void i2c_bus_attach_queue(i2c_inst_t *port, i2c_queue_t *q){
+    queues[i2c_hw_index(port)] = q;
+}
+
+i2c_queue_t *i2c_bus_queue(i2c_inst_t *port){
+    return queues[i2c_hw_index(port)];
+}
+
+//helper; runs one transaction through the queue and waits for it. the queue's controller records the traffic
+static int queued_transfer(i2c_queue_t *q, uint8_t addr, const uint8_t *src, size_t wlen, uint8_t *dst, size_t rlen){
+    i2c_txn_t t;
+    i2c_txn_init(&t, addr, I2C_PRIO_HIGH, src, wlen, dst, rlen, NULL, NULL);
+    if (!i2c_queue_submit(q, &t)) return PICO_ERROR_GENERIC;
+    while (t.busy) {
+        tight_loop_contents(); //the i2c irq moves it along, between chunks of any bulk write ahead of us
+    }
+    return t.result;
+}
+
+int i2c_bus_write(i2c_inst_t *port, uint8_t addr, const uint8_t *src, size_t len, bool nostop){
+    i2c_queue_t *q = i2c_bus_queue(port);
+    if (q) return queued_transfer(q, addr, src, len, NULL, 0);
+
+    uint32_t start = time_us_32();
+    int ret = i2c_write_blocking(port, addr, src, len, nostop);
+    i2c_bus_record(port, addr, len, ret, time_us_32() - start);
+    return ret;
+}
+
+int i2c_bus_read(i2c_inst_t *port, uint8_t addr, uint8_t *dst, size_t len, bool nostop){
+    i2c_queue_t *q = i2c_bus_queue(port);
+    if (q) return queued_transfer(q, addr, NULL, 0, dst, len);
+
+    uint32_t start = time_us_32();
+    int ret = i2c_read_blocking(port, addr, dst, len, nostop);
+    i2c_bus_record(port, addr, len, ret, time_us_32() - start);
+    return ret;
+}
+
+int i2c_bus_write_read(i2c_inst_t *port, uint8_t addr, const uint8_t *src, size_t wlen, uint8_t *dst, size_t rlen){
+    i2c_queue_t *q = i2c_bus_queue(port);
+    if (q) { //one queued transaction, so nothing can land between the write and the read
+        int ret = queued_transfer(q, addr, src, wlen, dst, rlen);
+        return (ret < 0) ? ret : (int)rlen;
+    }
+
+    int write = i2c_bus_write(port, addr, src, wlen, true);
+    if (write != (int)wlen) return (write < 0) ? write : PICO_ERROR_GENERIC;
+    return i2c_bus_read(port, addr, dst, rlen, false);
+}
+
+void i2c_bus_stats_snapshot(i2c_bus_stats_t *out){
+    if (!stats_lock_ready) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    critical_section_enter_blocking(&stats_lock);
+    memcpy(out, &stats, sizeof(*out));
+    critical_section_exit(&stats_lock);
+}
+
+void i2c_bus_stats_reset(void){
+    if (!stats_lock_ready) return;
+    critical_section_enter_blocking(&stats_lock);
+    for (uint8_t i = 0; i < stats.count; i++) { //keep the entries, so devices stay in the same rows
+        i2c_inst_t *port = stats.devs[i].port;
+        uint8_t addr = stats.devs[i].addr;
+        memset(&stats.devs[i], 0, sizeof(stats.devs[i]));
+        stats.devs[i].port = port;
+        stats.devs[i].addr = addr;
+    }
+    stats.since_us = time_us_64();
+    critical_section_exit(&stats_lock);
+}
+
+void i2c_bus_stats_dump(void){
+    i2c_bus_stats_t snap;
+    i2c_bus_stats_snapshot(&snap);
+    uint64_t window = time_us_64() - snap.since_us;
+
+    printf("\n%-9s %8s %8s %6s %6s %9s %8s %6s %7s\n", "i2c dev", "tx", "bytes", "nack", "err", "busy_us", "max_us", "busy%", "avoided");
+    for (uint8_t i = 0; i < snap.count; i++) {
+        const i2c_bus_dev_stats_t *d = &snap.devs[i];
+        printf("i2c%u 0x%02X %8lu %8lu %6lu %6lu %9lu %8lu %5lu%% %7lu\n", i2c_hw_index(d->port), d->addr,
+            (unsigned long)d->transactions, (unsigned long)d->bytes, (unsigned long)d->nacks, (unsigned long)d->errors,
+            (unsigned long)d->total_us, (unsigned long)d->max_us,
+            window ? (unsigned long)(d->total_us * 100 / window) : 0ul, (unsigned long)d->avoided);
+    }
+}
+
+//helper; counts a transaction the register shadow saved
+static void record_avoided(i2c_inst_t *port, uint8_t addr){
+    if (!stats_lock_ready) return;
+
+    critical_section_enter_blocking(&stats_lock);
+    i2c_bus_dev_stats_t *d = dev_stats(port, addr);
+    if (d) d->avoided++;
+    critical_section_exit(&stats_lock);
+}
+
+void i2c_reg_init(i2c_reg_dev_t *dev, i2c_inst_t *port, uint8_t addr, bool msb_first){
+    memset(dev, 0, sizeof(*dev));
+    dev->port = port;
+    dev->addr = addr;
+    dev->msb_first = msb_first;
+}
+
+bool i2c_reg_shadow(i2c_reg_dev_t *dev, uint8_t reg){
+    for (uint8_t i = 0; i < dev->shadow_count; i++) {
+        if (dev->shadow_reg[i] == reg) return true;
+    }
+    if (dev->shadow_count == I2C_REG_SHADOW_MAX) return false;
+    dev->shadow_reg[dev->shadow_count++] = reg; //not valid until the first read or write
+    return true;
+}
+
+void i2c_reg_invalidate(i2c_reg_dev_t *dev){
+    dev->shadow_valid = 0;
+}
+
+//helper; shadow slot of reg, -1 if it isn't cached
+static int shadow_slot(const i2c_reg_dev_t *dev, uint8_t reg){
+    for (uint8_t i = 0; i < dev->shadow_count; i++) {
+        if (dev->shadow_reg[i] == reg) return i;
+    }
+    return -1;
+}
+
+//helpers shared by the 8 and 16-bit calls; width is 1 or 2 bytes
+static bool reg_read(i2c_reg_dev_t *dev, uint8_t reg, size_t width, uint16_t *val){
+    int slot = shadow_slot(dev, reg);
+    if (slot >= 0 && (dev->shadow_valid & (1u << slot))) {
+        *val = dev->shadow_val[slot];
+        record_avoided(dev->port, dev->addr);
+        return true;
+    }
+
+    uint8_t buf[2];
+    if (i2c_bus_write_read(dev->port, dev->addr, &reg, 1, buf, width) != (int)width) return false;
+    if (width == 1) {
+        *val = buf[0];
+    } else {
+        *val = dev->msb_first ? (uint16_t)((buf[0] << 8) | buf[1]) : (uint16_t)((buf[1] << 8) | buf[0]);
+    }
+
+    if (slot >= 0) {
+        dev->shadow_val[slot] = *val;
+        dev->shadow_valid |= (uint8_t)(1u << slot);
+    }
+    return true;
+}
+
+static bool reg_write(i2c_reg_dev_t *dev, uint8_t reg, size_t width, uint16_t val){
+    int slot = shadow_slot(dev, reg);
+    if (slot >= 0 && (dev->shadow_valid & (1u << slot)) && dev->shadow_val[slot] == val) { //chip already holds it
+        record_avoided(dev->port, dev->addr);
+        return true;
+    }
+
+    uint8_t buf[3] = {reg};
+    if (width == 1) {
+        buf[1] = (uint8_t)val;
+    } else {
+        buf[1] = (uint8_t)(dev->msb_first ? (val >> 8) : val);
+        buf[2] = (uint8_t)(dev->msb_first ? val : (val >> 8));
+    }
+    bool ok = (i2c_bus_write(dev->port, dev->addr, buf, width + 1, false) == (int)(width + 1));
+
+    if (slot >= 0) {
+        if (ok) {
+            dev->shadow_val[slot] = val;
+            dev->shadow_valid |= (uint8_t)(1u << slot);
+        } else {
+            dev->shadow_valid &= (uint8_t)~(1u << slot); //may or may not have landed
+        }
+    }
+    return ok;
+}
+
+static bool reg_update(i2c_reg_dev_t *dev, uint8_t reg, size_t width, uint16_t mask, uint16_t bits){
+    uint16_t val;
+    if (!reg_read(dev, reg, width, &val)) return false; //from the shadow when cached, so no bus read
+    return reg_write(dev, reg, width, (uint16_t)((val & ~mask) | (bits & mask)));
+}
+
+bool i2c_reg_read8(i2c_reg_dev_t *dev, uint8_t reg, uint8_t *val){
+    uint16_t v;
+    if (!reg_read(dev, reg, 1, &v)) return false;
+    *val = (uint8_t)v;
+    return true;
+}
+
+bool i2c_reg_write8(i2c_reg_dev_t *dev, uint8_t reg, uint8_t val){
+    return reg_write(dev, reg, 1, val);
+}
+
+bool i2c_reg_read16(i2c_reg_dev_t *dev, uint8_t reg, uint16_t *val){
+    return reg_read(dev, reg, 2, val);
+}
+
+bool i2c_reg_write16(i2c_reg_dev_t *dev, uint8_t reg, uint16_t val){
+    return reg_write(dev, reg, 2, val);
+}
+
+bool i2c_reg_update8(i2c_reg_dev_t *dev, uint8_t reg, uint8_t mask, uint8_t bits){
+    return reg_update(dev, reg, 1, mask, bits);
+}
+
+bool i2c_reg_update16(i2c_reg_dev_t *dev, uint8_t reg, uint16_t mask, uint16_t bits){
+    return reg_update(dev, reg, 2, mask, bits);
+}
@@ -1,6 +1,12 @@
 #pragma once
 #include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
 #include "hardware/i2c.h"
+#include "i2c_queue.h"
+
+#define I2C_BUS_MAX_DEVICES 8 //distinct port/address pairs tracked
+#define I2C_REG_SHADOW_MAX 4 //cached registers per device
 
 typedef struct {
     i2c_inst_t *port; //bus line
@@ -9,6 +15,89 @@ typedef struct {
     uint32_t freq_hz; //frequency in hz
 } i2c_bus_t;
 
+//counters for one port/address
+typedef struct {
+    i2c_inst_t *port;
+    uint8_t addr;
+
+    uint32_t transactions;
+    uint32_t bytes; //payload moved, not counting the address byte
+    uint32_t nacks; //address not acknowledged
+    uint32_t errors; //timeouts and short transfers
+    uint64_t total_us; //time spent blocked in the transfer (bus occupancy for async transfers)
+    uint32_t max_us;
+    uint32_t avoided; //transactions the register shadow made unnecessary
+} i2c_bus_dev_stats_t;
+
+//register access to one device with 8-bit register addresses
+typedef struct {
+    i2c_inst_t *port;
+    uint8_t addr;
+    bool msb_first; //16-bit registers go high byte first; false for little-endian parts (veml7700)
+
+    //optional shadow of registers only the host changes (config, not data), see i2c_reg_shadow
+    uint8_t shadow_count;
+    uint8_t shadow_reg[I2C_REG_SHADOW_MAX];
+    uint16_t shadow_val[I2C_REG_SHADOW_MAX];
+    uint8_t shadow_valid; //bit n = shadow_val[n] matches the chip
+} i2c_reg_dev_t;
+
+typedef struct {
+    uint8_t count;
+    i2c_bus_dev_stats_t devs[I2C_BUS_MAX_DEVICES];
+    uint64_t since_us; //start of the counting window
+} i2c_bus_stats_t;
+
 void i2c_bus_init(const i2c_bus_t *bus);
 
-int i2c_bus_scan();
\ No newline at end of file
+//probes every address 0x08..0x77 and prints what answers; a wiring diagnostic, ~112 probes
+int i2c_bus_scan(const i2c_bus_t *bus);
+
+//true if addr acks a 1-byte read within a short timeout; uncounted, and only before a queue is attached
+bool i2c_bus_probe(const i2c_bus_t *bus, uint8_t addr);
+
+//modelled time on the wire at bus->freq_hz: per transaction start + address + stop, 9 clocks per data byte
+uint32_t i2c_bus_wire_us(const i2c_bus_t *bus, uint32_t transactions, uint32_t bytes);
+
+//all driver transfers go through these; same arguments and return values as i2c_write/read_blocking.
+//with a queue attached they wait on a high priority queued transaction instead, and nostop is ignored
+int i2c_bus_write(i2c_inst_t *port, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+int i2c_bus_read(i2c_inst_t *port, uint8_t addr, uint8_t *dst, size_t len, bool nostop);
+
+//write then repeated start read (register reads); returns bytes read or negative
+int i2c_bus_write_read(i2c_inst_t *port, uint8_t addr, const uint8_t *src, size_t wlen, uint8_t *dst, size_t rlen);
+
+//hands port's transfers to q (set up with i2c_queue_rp2040_init); NULL goes back to blocking sdk calls
+void i2c_bus_attach_queue(i2c_inst_t *port, i2c_queue_t *q);
+
+//queue attached to port, or NULL
+i2c_queue_t *i2c_bus_queue(i2c_inst_t *port);
+
+//accounts a transfer that didn't go through the wrappers (e.g. dma); result as the sdk would return it
+void i2c_bus_record(i2c_inst_t *port, uint8_t addr, size_t len, int result, uint32_t us);
+
+//consistent copy of every device's counters; safe from either core
+void i2c_bus_stats_snapshot(i2c_bus_stats_t *out);
+
+void i2c_bus_stats_reset(void);
+
+//one line per device
+void i2c_bus_stats_dump(void);
+
+void i2c_reg_init(i2c_reg_dev_t *dev, i2c_inst_t *port, uint8_t addr, bool msb_first);
+
+//caches reg: reads come from the shadow once it holds a value, unchanged writes are skipped and
+//updates need no bus read; only for registers the chip never changes by itself. false if the table is full
+bool i2c_reg_shadow(i2c_reg_dev_t *dev, uint8_t reg);
+
+//forgets every cached value (e.g. after the part lost power), so the next access goes to the bus
+void i2c_reg_invalidate(i2c_reg_dev_t *dev);
+
+bool i2c_reg_read8(i2c_reg_dev_t *dev, uint8_t reg, uint8_t *val);
+bool i2c_reg_write8(i2c_reg_dev_t *dev, uint8_t reg, uint8_t val);
+bool i2c_reg_read16(i2c_reg_dev_t *dev, uint8_t reg, uint16_t *val);
+bool i2c_reg_write16(i2c_reg_dev_t *dev, uint8_t reg, uint16_t val);
+
+//read-modify-write of the bits in mask
+bool i2c_reg_update8(i2c_reg_dev_t *dev, uint8_t reg, uint8_t mask, uint8_t bits);
+bool i2c_reg_update16(i2c_reg_dev_t *dev, uint8_t reg, uint16_t mask, uint16_t bits);
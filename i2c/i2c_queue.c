@@ -0,0 +1,149 @@
+#include "i2c_queue.h"
+#include <stdio.h>
+#include <string.h>
+
+static void lock(i2c_queue_t *q){
+    if (q->ctrl.lock) q->ctrl.lock(q->ctrl.ctx);
+}
+
+static void unlock(i2c_queue_t *q){
+    if (q->ctrl.unlock) q->ctrl.unlock(q->ctrl.ctx);
+}
+
+static uint32_t now(const i2c_queue_t *q){
+    return q->ctrl.now_us ? q->ctrl.now_us() : 0;
+}
+
+void i2c_queue_init(i2c_queue_t *q, const i2c_queue_ctrl_t *ctrl){
+    memset(q, 0, sizeof(*q));
+    q->ctrl = *ctrl;
+}
+
+void i2c_txn_init(i2c_txn_t *t, uint8_t addr, i2c_prio_t prio, const uint8_t *wr, size_t wr_len,
+                  uint8_t *rd, size_t rd_len, i2c_txn_done_fn done, void *ctx){
+    memset(t, 0, sizeof(*t));
+    t->addr = addr;
+    t->prio = prio;
+    t->wr = wr;
+    t->wr_len = wr_len;
+    t->rd = rd;
+    t->rd_len = rd_len;
+    t->done = done;
+    t->ctx = ctx;
+}
+
+//helper; puts the next segment of the most urgent transaction on the bus. call with the lock held
+static void dispatch(i2c_queue_t *q){
+    if (q->active) return;
+
+    i2c_txn_t *t = NULL;
+    for (int p = 0; p < I2C_QUEUE_PRIORITIES && !t; p++) t = q->head[p];
+    if (!t) return;
+
+    const uint8_t *prefix = NULL;
+    size_t prefix_len = 0;
+    size_t len = t->wr_len - t->sent;
+    if (t->chunk && len > t->chunk) len = t->chunk;
+    if (t->sent == 0) { //first segment; nothing but the caller's own bytes
+        uint32_t wait = now(q) - t->queued_us;
+        if (wait > q->max_wait_us[t->prio]) q->max_wait_us[t->prio] = wait;
+    } else {
+        prefix = t->prefix;
+        prefix_len = t->prefix_len;
+    }
+
+    q->active = t;
+    q->active_len = len;
+    q->segments++;
+    q->ctrl.start(q->ctrl.ctx, t->addr, prefix, prefix_len, t->wr ? t->wr + t->sent : NULL, len, t->rd, t->rd_len);
+}
+
+bool i2c_queue_submit(i2c_queue_t *q, i2c_txn_t *t){
+    if (!q || !t || t->busy || t->prio >= I2C_QUEUE_PRIORITIES) return false;
+    if (t->wr_len + t->rd_len == 0 || t->prefix_len > I2C_QUEUE_MAX_PREFIX) return false;
+    if (t->chunk && t->rd_len) return false; //a repeated start can't be split
+
+    t->busy = true;
+    t->sent = 0;
+    t->next = NULL;
+
+    lock(q);
+    t->queued_us = now(q);
+    if (q->tail[t->prio]) {
+        q->tail[t->prio]->next = t;
+    } else {
+        q->head[t->prio] = t;
+    }
+    q->tail[t->prio] = t;
+    q->submitted++;
+    dispatch(q);
+    unlock(q);
+    return true;
+}
+
+void i2c_queue_segment_done(i2c_queue_t *q, int result){
+    lock(q);
+    i2c_txn_t *t = q->active;
+    if (!t) { //spurious; nothing was on the bus
+        unlock(q);
+        return;
+    }
+    q->active = NULL;
+
+    bool finished = true;
+    if (result >= 0) {
+        t->sent += q->active_len;
+        if (t->sent < t->wr_len) { //more chunks; stays at the head of its fifo
+            finished = false;
+            for (int p = 0; p < (int)t->prio; p++) {
+                if (q->head[p]) { q->yields++; break; }
+            }
+        } else {
+            result = (int)(t->wr_len + t->rd_len);
+        }
+    } else {
+        q->failed++; //remaining chunks are dropped with it
+    }
+
+    if (finished) {
+        q->head[t->prio] = t->next;
+        if (!q->head[t->prio]) q->tail[t->prio] = NULL;
+    }
+    dispatch(q);
+    unlock(q);
+
+    if (finished) { //after the lock, so the callback may submit again
+        i2c_txn_done_fn done = t->done;
+        void *ctx = t->ctx;
+        t->result = result;
+        t->busy = false; //t may be reused or go out of scope from here on
+        if (done) done(ctx, result);
+    }
+}
+
+bool i2c_queue_idle(i2c_queue_t *q){
+    lock(q);
+    bool idle = !q->active;
+    for (int p = 0; p < I2C_QUEUE_PRIORITIES; p++) {
+        if (q->head[p]) idle = false;
+    }
+    unlock(q);
+    return idle;
+}
+
+void i2c_queue_reset_stats(i2c_queue_t *q){
+    lock(q);
+    q->submitted = 0;
+    q->failed = 0;
+    q->segments = 0;
+    q->yields = 0;
+    memset(q->max_wait_us, 0, sizeof(q->max_wait_us));
+    unlock(q);
+}
+
+void i2c_queue_report(const i2c_queue_t *q){
+    printf("\ni2c queue: %lu txns, %lu failed, %lu segments, %lu yields, max wait us high/normal/low %lu/%lu/%lu\n",
+        (unsigned long)q->submitted, (unsigned long)q->failed, (unsigned long)q->segments, (unsigned long)q->yields,
+        (unsigned long)q->max_wait_us[I2C_PRIO_HIGH], (unsigned long)q->max_wait_us[I2C_PRIO_NORMAL],
+        (unsigned long)q->max_wait_us[I2C_PRIO_LOW]);
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+  Prioritised i2c transaction queue.
+  - Transactions are a write, a read, or a write then a read behind a repeated start; each carries
+    a priority and a completion callback and is moved by the controller's interrupt, not a spinning caller
+  - Long writes can be split into chunks, each its own start..stop with a prefix resent ahead of it
+    (e.g. the ssd1306 data control byte), so pending higher priority transactions run in between
+  - The bus is reached through an i2c_queue_ctrl_t, so the same code runs on the Pico
+    (i2c_queue_rp2040.h, i2c irq) or on a host against a simulated controller
+*/
+
+#define I2C_QUEUE_PRIORITIES 3
+#define I2C_QUEUE_MAX_PREFIX 2
+
+typedef enum {
+    I2C_PRIO_HIGH = 0, //someone is waiting on it (sensor reads)
+    I2C_PRIO_NORMAL = 1,
+    I2C_PRIO_LOW = 2 //bulk traffic (display flushes)
+} i2c_prio_t;
+
+//completion; runs in the controller's irq. result = bytes of wr + rd moved (prefixes not counted) or negative error
+typedef void (*i2c_txn_done_fn)(void *ctx, int result);
+
+typedef struct i2c_txn {
+    uint8_t addr;
+    i2c_prio_t prio;
+    const uint8_t *wr; //sent first; wr_len 0 for a plain read
+    size_t wr_len;
+    uint8_t *rd; //filled after a repeated start (or straight away without wr); rd_len 0 for a plain write
+    size_t rd_len;
+    size_t chunk; //most wr bytes per bus transaction, 0 = never split; writes without rd only
+    uint8_t prefix[I2C_QUEUE_MAX_PREFIX]; //sent ahead of every chunk after the first
+    uint8_t prefix_len;
+    i2c_txn_done_fn done; //optional
+    void *ctx;
+
+    //owned by the queue from submit until busy clears; the caller keeps the struct and buffers alive until then
+    volatile bool busy;
+    volatile int result; //as passed to done
+    size_t sent; //wr bytes already on the wire
+    uint32_t queued_us;
+    struct i2c_txn *next;
+} i2c_txn_t;
+
+//one start..stop: prefix, then wr, then (repeated start) rd. must not complete from inside the call;
+//the controller reports back later through i2c_queue_segment_done
+typedef void (*i2c_ctrl_start_fn)(void *ctx, uint8_t addr, const uint8_t *prefix, size_t prefix_len,
+                                  const uint8_t *wr, size_t wr_len, uint8_t *rd, size_t rd_len);
+
+typedef struct {
+    i2c_ctrl_start_fn start;
+    void (*lock)(void *ctx); //keeps out the completion irq and the other core; NULL when single threaded
+    void (*unlock)(void *ctx);
+    uint32_t (*now_us)(void); //for the wait stats; may be NULL
+    void *ctx;
+} i2c_queue_ctrl_t;
+
+typedef struct {
+    i2c_queue_ctrl_t ctrl;
+    i2c_txn_t *head[I2C_QUEUE_PRIORITIES]; //fifo per priority; a chunked write stays at its head between chunks
+    i2c_txn_t *tail[I2C_QUEUE_PRIORITIES];
+    i2c_txn_t *active; //transaction with a segment on the bus, NULL when idle
+    size_t active_len; //wr bytes in that segment
+
+    //stats
+    uint32_t submitted;
+    uint32_t failed;
+    uint32_t segments; //bus transactions started
+    uint32_t yields; //times a chunked write stepped aside for a higher priority transaction
+    uint32_t max_wait_us[I2C_QUEUE_PRIORITIES]; //submit to first byte on the bus
+} i2c_queue_t;
+
+void i2c_queue_init(i2c_queue_t *q, const i2c_queue_ctrl_t *ctrl);
+
+//fills in a transaction with no chunking, no prefix
+void i2c_txn_init(i2c_txn_t *t, uint8_t addr, i2c_prio_t prio, const uint8_t *wr, size_t wr_len,
+                  uint8_t *rd, size_t rd_len, i2c_txn_done_fn done, void *ctx);
+
+//queues t and starts it if the bus is idle; false if t is still busy or malformed
+bool i2c_queue_submit(i2c_queue_t *q, i2c_txn_t *t);
+
+//controller side: the segment from the last start finished; result = wr + rd bytes moved, or negative
+void i2c_queue_segment_done(i2c_queue_t *q, int result);
+
+//true when nothing is queued or on the bus
+bool i2c_queue_idle(i2c_queue_t *q);
+
+void i2c_queue_reset_stats(i2c_queue_t *q);
+
+//prints the stats to stdout
+void i2c_queue_report(const i2c_queue_t *q);
@@ -0,0 +1,149 @@
+#include "i2c_queue_rp2040.h"
+#include "i2c_bus.h"
+#include "pico/stdlib.h"
+#include "pico/critical_section.h"
+#include "hardware/irq.h"
+
+#define FIFO_DEPTH 16 //tx and rx fifos
+#define TX_REFILL_LEVEL 4 //tx empty irq fires once the fifo is down to this many commands
+
+//segment on the bus for one port; filled in by start, advanced by the irq
+typedef struct {
+    i2c_inst_t *port;
+    i2c_queue_t *q;
+    critical_section_t lock;
+
+    uint8_t addr;
+    const uint8_t *prefix;
+    size_t prefix_len;
+    const uint8_t *wr;
+    size_t wr_len;
+    uint8_t *rd;
+    size_t rd_len;
+    size_t pushed; //commands handed to the tx fifo, out of prefix_len + wr_len + rd_len
+    size_t received; //rd bytes taken out of the rx fifo
+    bool aborted;
+    uint32_t start_us;
+} port_state_t;
+
+static port_state_t ports[NUM_I2CS];
+
+//helper; tops up the tx fifo. read commands are limited so their bytes always fit in the rx fifo
+static void fill(port_state_t *s, i2c_hw_t *hw){
+    size_t head = s->prefix_len + s->wr_len; //index of the first read command
+    size_t total = head + s->rd_len;
+
+    while (s->pushed < total && hw->txflr < FIFO_DEPTH) {
+        size_t i = s->pushed;
+        uint32_t cmd;
+        if (i < s->prefix_len) {
+            cmd = s->prefix[i];
+        } else if (i < head) {
+            cmd = s->wr[i - s->prefix_len];
+        } else {
+            if (i - head - s->received >= FIFO_DEPTH) { //rx fifo would overflow; drain unmasks tx empty once there's room
+                hw_clear_bits(&hw->intr_mask, I2C_IC_INTR_MASK_M_TX_EMPTY_BITS); //else it fires nonstop with nothing to push
+                return;
+            }
+            cmd = I2C_IC_DATA_CMD_CMD_BITS;
+            if (i == head && head > 0) cmd |= I2C_IC_DATA_CMD_RESTART_BITS; //write -> read turnaround
+        }
+        if (i == total - 1) cmd |= I2C_IC_DATA_CMD_STOP_BITS;
+        hw->data_cmd = cmd;
+        s->pushed++;
+    }
+    if (s->pushed == total) hw_clear_bits(&hw->intr_mask, I2C_IC_INTR_MASK_M_TX_EMPTY_BITS);
+}
+
+static void drain(port_state_t *s, i2c_hw_t *hw){
+    while (hw->rxflr && s->received < s->rd_len) {
+        s->rd[s->received++] = (uint8_t)hw->data_cmd;
+    }
+
+    //read commands held back by fill fit in the rx fifo again
+    size_t head = s->prefix_len + s->wr_len;
+    if (!s->aborted && s->pushed >= head && s->pushed < head + s->rd_len && s->pushed - head - s->received < FIFO_DEPTH) {
+        hw_set_bits(&hw->intr_mask, I2C_IC_INTR_MASK_M_TX_EMPTY_BITS);
+    }
+}
+
+static void rp2040_start(void *ctx, uint8_t addr, const uint8_t *prefix, size_t prefix_len,
+                         const uint8_t *wr, size_t wr_len, uint8_t *rd, size_t rd_len){
+    port_state_t *s = (port_state_t *)ctx;
+    i2c_hw_t *hw = i2c_get_hw(s->port);
+
+    s->addr = addr;
+    s->prefix = prefix;
+    s->prefix_len = prefix_len;
+    s->wr = wr;
+    s->wr_len = wr_len;
+    s->rd = rd;
+    s->rd_len = rd_len;
+    s->pushed = 0;
+    s->received = 0;
+    s->aborted = false;
+    s->start_us = time_us_32();
+
+    //target address can only change while the controller is disabled; disabling also empties the fifos
+    hw->enable = 0;
+    hw->tar = addr;
+    hw->enable = 1;
+    (void)hw->clr_intr; //drop stop/abort flags left over from earlier transfers
+
+    hw->intr_mask = I2C_IC_INTR_MASK_M_TX_EMPTY_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS | I2C_IC_INTR_MASK_M_STOP_DET_BITS
+                  | (rd_len ? I2C_IC_INTR_MASK_M_RX_FULL_BITS : 0);
+    fill(s, hw);
+}
+
+static void service(port_state_t *s){
+    i2c_hw_t *hw = i2c_get_hw(s->port);
+    uint32_t stat = hw->intr_stat;
+
+    if (stat & I2C_IC_INTR_STAT_R_TX_ABRT_BITS) { //nack; the controller flushes the fifo and sends a stop
+        s->aborted = true;
+        (void)hw->clr_tx_abrt;
+        hw_clear_bits(&hw->intr_mask, I2C_IC_INTR_MASK_M_TX_EMPTY_BITS);
+    }
+    drain(s, hw);
+    if (!s->aborted && (hw->intr_mask & I2C_IC_INTR_MASK_M_TX_EMPTY_BITS)) fill(s, hw);
+
+    if (stat & I2C_IC_INTR_STAT_R_STOP_DET_BITS) { //segment over, one way or the other
+        (void)hw->clr_stop_det;
+        hw->intr_mask = 0;
+        size_t len = s->prefix_len + s->wr_len + s->rd_len;
+        i2c_bus_record(s->port, s->addr, len, s->aborted ? PICO_ERROR_GENERIC : (int)len, time_us_32() - s->start_us);
+        i2c_queue_segment_done(s->q, s->aborted ? PICO_ERROR_GENERIC : (int)(s->wr_len + s->rd_len));
+    }
+}
+
+static void i2c0_irq_handler(void){ service(&ports[0]); }
+static void i2c1_irq_handler(void){ service(&ports[1]); }
+
+static void rp2040_lock(void *ctx){ critical_section_enter_blocking(&((port_state_t *)ctx)->lock); }
+static void rp2040_unlock(void *ctx){ critical_section_exit(&((port_state_t *)ctx)->lock); }
+
+void i2c_queue_rp2040_init(i2c_queue_t *q, i2c_inst_t *port){
+    uint index = i2c_hw_index(port);
+    port_state_t *s = &ports[index];
+    s->port = port;
+    s->q = q;
+    critical_section_init(&s->lock);
+
+    const i2c_queue_ctrl_t ctrl = {
+        .start = rp2040_start,
+        .lock = rp2040_lock,
+        .unlock = rp2040_unlock,
+        .now_us = time_us_32,
+        .ctx = s
+    };
+    i2c_queue_init(q, &ctrl);
+
+    i2c_hw_t *hw = i2c_get_hw(port);
+    hw->intr_mask = 0;
+    hw->tx_tl = TX_REFILL_LEVEL;
+    hw->rx_tl = 0; //rx irq as soon as a byte arrives
+
+    uint irq = index ? I2C1_IRQ : I2C0_IRQ;
+    irq_set_exclusive_handler(irq, index ? i2c1_irq_handler : i2c0_irq_handler);
+    irq_set_enabled(irq, true);
+}
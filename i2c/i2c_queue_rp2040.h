@@ -0,0 +1,7 @@
+#pragma once
+#include "i2c_queue.h"
+#include "hardware/i2c.h"
+
+//runs q on port from the port's i2c irq, enabled on the calling core; call after i2c_bus_init.
+//from here on nothing else may touch the controller: route blocking transfers through i2c_bus_attach_queue
+void i2c_queue_rp2040_init(i2c_queue_t *q, i2c_inst_t *port);
@@ -1,36 +1,151 @@
 #include "aht20.h" //actual driver
 #include "hardware/i2c.h" //for i2c implementation
+#include "i2c_bus.h" //counted transfers
 #include "pico/stdlib.h" //for timing
 
-#define AHT20_ADDR 0x38
+//status byte bits
+#define STATUS_BUSY (1u<<7) //measurement in progress
+
+#define POWERUP_US 40000 //from power-on until commands are accepted, per datasheet; the sensor powers up with the board
+#define MEASURE_MIN_US 40000 //typical conversion is ~75 ms; don't bother polling before this
+#define MEASURE_TIMEOUT_US 200000 //give up on a conversion that never finishes
+#define FETCH_RETRIES 2 //re-reads of the same result after a CRC mismatch
 
 static const uint8_t AHT20_TRIGGER[3] = {0xAC, 0x33, 0x00};
 
+//CRC-8, polynomial x^8 + x^5 + x^4 + 1 (0x31), init 0xFF, per datasheet
+static uint8_t aht20_crc8(const uint8_t *data, size_t len){
+    uint8_t crc = 0xFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
 void aht20_init(aht20_t *dev, i2c_inst_t *port){
     dev->port = port; //sets i2c bus
     dev->addr = AHT20_ADDR; //sets address
+    dev->measuring = false;
+    dev->trigger_pending = false;
 }
 
-bool aht20_read(const aht20_t *dev, float *temp_c, float *humidity_perc){
-    int write = i2c_write_blocking(dev->port, dev->addr,AHT20_TRIGGER,3,false); //write command
+bool aht20_trigger(aht20_t *dev){
+    if(time_us_64() < POWERUP_US){ //too early after boot; aht20_poll sends it once the deadline passes, nobody sleeps
+        dev->trigger_pending = true;
+        dev->measuring = true;
+        return true;
+    }
+    dev->trigger_pending = false;
+
+    int write = i2c_bus_write(dev->port, dev->addr,AHT20_TRIGGER,3,false); //write command
     if(write != 3){ return false; } //error case (write)
 
-    sleep_ms(80);
+    dev->measuring = true;
+    dev->trigger_us = time_us_32();
+    return true;
+}
+
+aht20_status_t aht20_poll(aht20_t *dev){
+    if(!dev->measuring){ return AHT20_IDLE; }
+
+    if(dev->trigger_pending){
+        if(time_us_64() < POWERUP_US){ return AHT20_BUSY; }
+        if(!aht20_trigger(dev)){
+            dev->measuring = false;
+            return AHT20_ERROR;
+        }
+        return AHT20_BUSY; //conversion starts now
+    }
+
+    uint32_t elapsed = time_us_32() - dev->trigger_us;
+    if(elapsed < MEASURE_MIN_US){ return AHT20_BUSY; } //can't be done yet; skip the bus read
 
-    uint8_t data[6] = {0}; //buffer
-    int read = i2c_read_blocking(dev->port, dev->addr, data, 6, false); //read sensor data
-    if(read!=6){ return false; } //error case (read)
+    uint8_t status;
+    int read = i2c_bus_read(dev->port, dev->addr, &status, 1, false); //first byte of any read is status
+    if(read != 1){
+        dev->measuring = false;
+        return AHT20_ERROR;
+    }
 
-    uint32_t raw_h = //create raw data humidity reading from hex array
+    if(status & STATUS_BUSY){
+        if(elapsed > MEASURE_TIMEOUT_US){ //stuck; make the caller start over
+            dev->measuring = false;
+            return AHT20_ERROR;
+        }
+        return AHT20_BUSY;
+    }
+    return AHT20_READY;
+}
+
+//reads and CRC-checks a finished measurement into the 20-bit raw values
+static bool aht20_fetch_raw(aht20_t *dev, uint32_t *raw_h, uint32_t *raw_t){
+    uint8_t data[7] = {0}; //buffer: status, 5 data bytes, crc
+    bool valid = false;
+
+    //result stays in the sensor until the next trigger, so a corrupted frame can just be read again
+    for(int attempt = 0; attempt <= FETCH_RETRIES && !valid; attempt++){
+        int read = i2c_bus_read(dev->port, dev->addr, data, 7, false); //read sensor data
+        if(read != 7){ break; } //error case (read)
+        if(data[0] & STATUS_BUSY){ return false; } //fetched too early; measurement still running
+
+        valid = (aht20_crc8(data, 6) == data[6]);
+    }
+    dev->measuring = false;
+    if(!valid){ return false; }
+
+    *raw_h = //create raw data humidity reading from hex array
         ((uint32_t)data[1] << 12) |
         ((uint32_t)data[2] << 4) |
         ((data[3] >> 4) & 0x0F);
-    *humidity_perc = (raw_h * 100.0f) / 1048576.0f; //convert to human-readable humidity
 
-    uint32_t raw_t =  //create raw data temp reading from hex array
+    *raw_t =  //create raw data temp reading from hex array
         ((uint32_t)(data[3] & 0x0F) << 16) |
         ((uint32_t)data[4] << 8) |
         (uint32_t)data[5];
+
+    return true;
+}
+
+bool aht20_fetch(aht20_t *dev, float *temp_c, float *humidity_perc){
+    uint32_t raw_h, raw_t;
+    if(!aht20_fetch_raw(dev, &raw_h, &raw_t)){ return false; }
+
+    *humidity_perc = (raw_h * 100.0f) / 1048576.0f; //convert to human-readable humidity
     *temp_c = (raw_t * 200.0f) / 1048576.0f - 50.0f; //convert to human-readable temp (degree C)
+    return true;
+}
+
+bool aht20_fetch_fixed(aht20_t *dev, int32_t *temp_cc, int32_t *humidity_cp){
+    uint32_t raw_h, raw_t;
+    if(!aht20_fetch_raw(dev, &raw_h, &raw_t)){ return false; }
+
+    //raw * 10000 / 2^20 == raw * 625 / 2^16; raw is 20 bits so raw * 625 fits in 32, rounded to nearest
+    *humidity_cp = (int32_t)((raw_h * 625u + (1u << 15)) >> 16);
+    //raw * 20000 / 2^20 - 5000 == raw * 625 / 2^15 - 5000
+    *temp_cc = (int32_t)((raw_t * 625u + (1u << 14)) >> 15) - 5000;
+    return true;
+}
+
+//triggers and waits out a measurement; shared by the blocking reads
+static bool aht20_wait_ready(aht20_t *dev){
+    if(!aht20_trigger(dev)){ return false; }
+
+    aht20_status_t status;
+    while((status = aht20_poll(dev)) == AHT20_BUSY){
+        sleep_ms(5);
+    }
+    return (status == AHT20_READY);
+}
 
-}
\ No newline at end of file
+bool aht20_read(aht20_t *dev, float *temp_c, float *humidity_perc){
+    if(!aht20_wait_ready(dev)){ return false; }
+    return aht20_fetch(dev, temp_c, humidity_perc);
+}
+
+bool aht20_read_fixed(aht20_t *dev, int32_t *temp_cc, int32_t *humidity_cp){
+    if(!aht20_wait_ready(dev)){ return false; }
+    return aht20_fetch_fixed(dev, temp_cc, humidity_cp);
+}
@@ -3,14 +3,42 @@
 #include <stdbool.h>
 #include "hardware/i2c.h"
 
+#define AHT20_ADDR 0x38
+
 typedef struct {
     i2c_inst_t *port;
     uint8_t addr;
+
+    bool measuring; //trigger sent, result not fetched yet
+    bool trigger_pending; //trigger asked for during power-up; the first poll after it sends it
+    uint32_t trigger_us; //time_us_32() when the last measurement was triggered
 } aht20_t;
 
+//result of polling a measurement in progress
+typedef enum {
+    AHT20_IDLE = 0, //nothing triggered
+    AHT20_BUSY = 1, //conversion still running
+    AHT20_READY = 2, //result can be fetched
+    AHT20_ERROR = 3 //bus error; trigger again
+} aht20_status_t;
+
 //initialize port and address
 void aht20_init(aht20_t *dev, i2c_inst_t *port);
 
-//read value from sensor; return human-readable info
-bool aht20_read(const aht20_t *dev, float *temp_c, float *humidity_perc);
+//starts a measurement and returns immediately; during the sensor's power-up time it is queued for aht20_poll instead
+bool aht20_trigger(aht20_t *dev);
+
+//checks the status byte's busy bit; no bus traffic until the conversion could plausibly be done
+aht20_status_t aht20_poll(aht20_t *dev);
+
+//reads and CRC-checks a finished measurement; return human-readable info
+bool aht20_fetch(aht20_t *dev, float *temp_c, float *humidity_perc);
+
+//same as aht20_fetch in integer hundredths: centi-degrees C and centi-percent RH; no float math
+bool aht20_fetch_fixed(aht20_t *dev, int32_t *temp_cc, int32_t *humidity_cp);
+
+//read value from sensor; return human-readable info (trigger + wait + fetch, blocks ~80 ms)
+bool aht20_read(aht20_t *dev, float *temp_c, float *humidity_perc);
 
+//blocking read in centi-degrees C and centi-percent RH
+bool aht20_read_fixed(aht20_t *dev, int32_t *temp_cc, int32_t *humidity_cp);
@@ -1,16 +1,22 @@
 #include "veml7700.h"
 #include "hardware/i2c.h" //for i2c implementation
+#include "i2c_bus.h" //counted transfers
 #include "pico/stdlib.h" //for timing
 
-#define VEML7700_ADDR 0x10
-
 //to later clear gain and itime config bits before writing new ones
 #define GAIN_MASK (3u<<11)
 #define ITIME_MASK (15u<<6)
+#define SHUTDOWN_BIT (1u<<0) //ALS_SD; cleared by every config so the sensor is powered on
 
 //define autorange values
 #define SATURATION 60000
 #define NOISE_FLOOR 2000
+#define AUTORANGE_TARGET 40000 //predicted counts to aim for; headroom below SATURATION for light changes
+#define COUNTS_CLIPPED 65535 //true counts unknown, could be anything above this
+#define SETTLE_MARGIN_US 5000 //slack on top of one integration time after a reconfigure
+
+//milli-lux per count is 53760 / sensitivity (0.0042 lux/count at 2x, 800 ms == 16 * 800 sensitivity)
+#define MLUX_PER_COUNT_NUM 53760u
 
 //define range of settings for auto adjustment 
 veml7700_mode_t AUTORANGE_SETTINGS[] = {
@@ -52,42 +58,57 @@ static uint16_t itime_to_bits(veml7700_itime_t itime_ms){
 }
 
 
+//helper; relative sensitivity (counts per lux) of a setting, gain in eighths times itime in ms
+static uint32_t veml7700_sensitivity(veml7700_gain_t gain, veml7700_itime_t itime_ms){
+    uint32_t gain8;
+    switch(gain){
+        case GAIN_2x: gain8 = 16; break;
+        case GAIN_1x: gain8 = 8; break;
+        case GAIN_1_04x: gain8 = 2; break;
+        case GAIN_1_08x: gain8 = 1; break;
+        default: gain8 = 8; break;
+    }
+    return gain8 * (uint32_t)itime_ms;
+}
+
 //initialize veml port and address
 void veml7700_init(veml7700_t *dev, i2c_inst_t *port){
     dev->port = port;
     dev->addr = VEML7700_ADDR;
+    dev->settling = false;
+    dev->gain = (veml7700_gain_t)0; //no setting yet, so the first config always starts a settle window
+    dev->itime_ms = (veml7700_itime_t)0;
+    i2c_reg_init(&dev->regs, port, VEML7700_ADDR, false); //16-bit registers, low byte first
+    i2c_reg_shadow(&dev->regs, VEML7700_CONFIG_REG); //only ever changed by us
 }
 
 //configure initial gain and integration time settings
 bool veml7700_config(veml7700_t *dev, veml7700_gain_t gain, veml7700_itime_t itime_ms){
-    dev->gain = gain;
-    dev->itime_ms = itime_ms;
+    bool changed = (gain != dev->gain || itime_ms != dev->itime_ms);
+    //one divide per reconfigure; each reading is then a multiply and a shift
+    uint32_t sens = veml7700_sensitivity(gain, itime_ms);
+    uint32_t mlux_per_count_q16 = (uint32_t)((((uint64_t)MLUX_PER_COUNT_NUM << 16) + sens / 2) / sens); //rounded, so full scale stays within 1 mlux
 
-    //create bitwise configuration
+    //only the gain/itime fields and the power bit; after the first call the rest of the register comes from the shadow,
+    //not a bus read, and a setting that is already active isn't sent at all
     uint16_t config = gain_to_bits(gain) | itime_to_bits(itime_ms);
-    //create message to send over I2C: write to config register 0, low byte, high byte
-    uint8_t buffer[3] = {VEML7700_CONFIG_REG, (uint8_t)(config & 0xFF), (uint8_t)((config>>8) & 0xFF)};
-    //send the message; save number of bits successfully written
-    int write = i2c_write_blocking(dev->port,dev->addr,buffer,3,false);
-    //return success
-    return (write == 3);
+    if(!i2c_reg_update16(&dev->regs, VEML7700_CONFIG_REG, GAIN_MASK | ITIME_MASK | SHUTDOWN_BIT, config)){
+        return false; //chip still runs the old setting, so readings keep being scaled for it
+    }
+
+    dev->gain = gain;
+    dev->itime_ms = itime_ms;
+    dev->mlux_per_count_q16 = mlux_per_count_q16;
+    if(changed){ //first full integration at the new setting is valid once this deadline passes
+        dev->settling = true;
+        dev->settle_until_us = time_us_32() + (uint32_t)itime_ms * 1000u + SETTLE_MARGIN_US;
+    }
+    return true;
 }
 
 //reads raw data from sensor
-bool veml7700_read_counts(const veml7700_t *dev, uint16_t *counts){
-    //request register
-    uint8_t reg_buffer = VEML7700_OUTPUT_REG;
-    int write = i2c_write_blocking(dev->port, dev->addr, &reg_buffer, 1, true);
-    if(write != 1){return false;}
-
-    //read register's data
-    uint8_t buffer[2];
-    int data = i2c_read_blocking(dev->port,dev->addr, buffer,2,false);
-    if(data != 2){return false;}
-
-    //change counts to reflect read data
-    *counts = ((uint16_t)(buffer[1]) << 8)|(uint16_t)(buffer[0]);
-    return true; //return success
+bool veml7700_read_counts(veml7700_t *dev, uint16_t *counts){
+    return i2c_reg_read16(&dev->regs, VEML7700_OUTPUT_REG, counts); //output register isn't shadowed; always a bus read
 }
 
 //helper function; calculates lux per count based on gain
@@ -115,8 +136,23 @@ static float veml7700_lux_per_count(const veml7700_t *dev){
     return 0.0042f * (800.0f / itime_val) * (2.0f / gain_val);
 }
 
+//helper; counts -> milli-lux with the constant for the current setting, rounded to nearest
+static int32_t veml7700_counts_to_mlux(const veml7700_t *dev, uint16_t counts){
+    return (int32_t)(((uint64_t)counts * dev->mlux_per_count_q16 + (1u << 15)) >> 16);
+}
+
+bool veml7700_read_mlux(veml7700_t *dev, int32_t *mlux){
+    uint16_t counts;
+    if(!veml7700_read_counts(dev, &counts)){
+        return false;
+    }
+
+    *mlux = veml7700_counts_to_mlux(dev, counts);
+    return true;
+}
+
 //reads and returns lux using internal helper functions
-bool veml7700_read_lux(const veml7700_t *dev, float *lux){
+bool veml7700_read_lux(veml7700_t *dev, float *lux){
     uint16_t counts;
     if(!veml7700_read_counts(dev, &counts)){
         return false;
@@ -127,40 +163,75 @@ bool veml7700_read_lux(const veml7700_t *dev, float *lux){
 }
 
 //helper function; updates gain and integration time settings for maximum accuracy
+//predicts counts at every setting from the current reading and jumps straight to the best one
 static bool veml7700_autorange_update(veml7700_t *dev, uint16_t counts){
-    veml7700_mode_t curr_mode = {dev->gain, dev->itime_ms};
+    if(counts >= NOISE_FLOOR && counts <= SATURATION){ return false; } //current setting is fine
+
     int len = sizeof(AUTORANGE_SETTINGS)/sizeof(AUTORANGE_SETTINGS[0]);
-    for(int i = 0; i < len; i++){
-        if(curr_mode.gain == AUTORANGE_SETTINGS[i].gain && curr_mode.itime_ms == AUTORANGE_SETTINGS[i].itime_ms){
-            if(counts > SATURATION && i+1 < len){
-                return veml7700_config(dev, AUTORANGE_SETTINGS[i+1].gain, AUTORANGE_SETTINGS[i+1].itime_ms);
-            }
-            else if (counts < NOISE_FLOOR && i > 0){
-                return veml7700_config(dev, AUTORANGE_SETTINGS[i-1].gain, AUTORANGE_SETTINGS[i-1].itime_ms);
+    int best = len - 1; //clipped reading: true level unknown, go least sensitive and refine next read
+
+    if(counts < COUNTS_CLIPPED){
+        //counts scale linearly with sensitivity, so predicted = counts * sens_new / sens_curr
+        uint32_t sens_curr = veml7700_sensitivity(dev->gain, dev->itime_ms);
+        for(int i = 0; i < len; i++){ //table runs most to least sensitive; first that fits wins
+            uint32_t predicted = (uint32_t)counts * veml7700_sensitivity(AUTORANGE_SETTINGS[i].gain, AUTORANGE_SETTINGS[i].itime_ms) / sens_curr;
+            if(predicted <= AUTORANGE_TARGET){
+                best = i;
+                break;
             }
-            return false;
         }
     }
-    return false;
+
+    if(AUTORANGE_SETTINGS[best].gain == dev->gain && AUTORANGE_SETTINGS[best].itime_ms == dev->itime_ms){
+        return false; //already at the end of the table
+    }
+    return veml7700_config(dev, AUTORANGE_SETTINGS[best].gain, AUTORANGE_SETTINGS[best].itime_ms);
 }
 
-//wrapper for reading lux and adjusting gain/IT accordingly
-bool veml7700_read_lux_autorange(veml7700_t *dev, float *lux){
+//autorange state machine shared by the float and integer polls; counts valid on READY
+static veml7700_ar_status_t veml7700_autorange_step(veml7700_t *dev, uint16_t *counts_out){
+    if(dev->settling){
+        if((int32_t)(time_us_32() - dev->settle_until_us) < 0){ return VEML7700_AR_SETTLING; } //no bus traffic while waiting
+        dev->settling = false;
+    }
+
     uint16_t counts;
     if(!veml7700_read_counts(dev, &counts)){
-        return false;
+        return VEML7700_AR_ERROR;
     }
 
     if(veml7700_autorange_update(dev, counts)){
-        uint16_t throwaway;
-        sleep_ms(dev->itime_ms);
-        veml7700_read_counts(dev, &throwaway);
-        if(!veml7700_read_counts(dev, &counts)){
-            return false;
-        }
+        return VEML7700_AR_SETTLING; //veml7700_config started the settle window
+    }
+
+    *counts_out = counts;
+    return VEML7700_AR_READY;
+}
+
+veml7700_ar_status_t veml7700_autorange_poll(veml7700_t *dev, float *lux){
+    uint16_t counts;
+    veml7700_ar_status_t status = veml7700_autorange_step(dev, &counts);
+    if(status == VEML7700_AR_READY){
+        *lux = (float)counts * veml7700_lux_per_count(dev);
     }
+    return status;
+}
 
-    *lux = (float)counts * veml7700_lux_per_count(dev);;
+veml7700_ar_status_t veml7700_autorange_poll_mlux(veml7700_t *dev, int32_t *mlux){
+    uint16_t counts;
+    veml7700_ar_status_t status = veml7700_autorange_step(dev, &counts);
+    if(status == VEML7700_AR_READY){
+        *mlux = veml7700_counts_to_mlux(dev, counts);
+    }
+    return status;
+}
 
-    return true;
+//wrapper for reading lux and adjusting gain/IT accordingly; blocks until the reading is valid
+bool veml7700_read_lux_autorange(veml7700_t *dev, float *lux){
+    veml7700_ar_status_t status;
+    while((status = veml7700_autorange_poll(dev, lux)) == VEML7700_AR_SETTLING){
+        int32_t wait_us = (int32_t)(dev->settle_until_us - time_us_32());
+        if(wait_us > 0){ sleep_us((uint64_t)wait_us); }
+    }
+    return (status == VEML7700_AR_READY);
 }
@@ -2,6 +2,9 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "hardware/i2c.h"
+#include "i2c_bus.h"
+
+#define VEML7700_ADDR 0x10
 
 typedef enum { //gain
     GAIN_1x = 1, //1x gain
@@ -22,12 +25,24 @@ typedef enum{ //integration time
 typedef struct { //veml struct
     i2c_inst_t *port;
     uint8_t addr;
+    i2c_reg_dev_t regs; //register access; the config register is shadowed
 
     veml7700_gain_t gain;
     veml7700_itime_t itime_ms;
+
+    bool settling; //reconfigured; readings invalid until settle_until_us
+    uint32_t settle_until_us; //time_us_32() deadline for the first valid reading
+
+    uint32_t mlux_per_count_q16; //milli-lux per count at the current setting, 16.16; set by veml7700_config
     
 } veml7700_t;
 
+typedef enum { //result of one autorange poll
+    VEML7700_AR_READY = 0, //lux is valid
+    VEML7700_AR_SETTLING = 1, //setting just changed; poll again after settle_until_us
+    VEML7700_AR_ERROR = 2 //bus error
+} veml7700_ar_status_t;
+
 typedef struct { //holds gain and integration time
     veml7700_gain_t gain;
     veml7700_itime_t itime_ms;
@@ -36,21 +51,25 @@ typedef struct { //holds gain and integration time
 //initialize veml port and address
 void veml7700_init(veml7700_t *dev, i2c_inst_t *port);
 
-//configure initial gain and integration time settings
+//configure gain and integration time; only the changed fields go out, and an unchanged setting costs no transaction.
+//a new setting starts a settle window: readings are invalid until settle_until_us
 bool veml7700_config(veml7700_t *dev, veml7700_gain_t gain, veml7700_itime_t itime_ms);
 
-//helper function; calculates lux per count based on gain
-static float veml7700_lux_per_count(const veml7700_t *dev);
-
 //reads raw data from sensor
-bool veml7700_read_counts(const veml7700_t *dev, uint16_t *counts);
+bool veml7700_read_counts(veml7700_t *dev, uint16_t *counts);
 
 //reads and outputs lux using internal helper functions
-bool veml7700_read_lux(const veml7700_t *dev, float *lux);
+bool veml7700_read_lux(veml7700_t *dev, float *lux);
+
+//reads lux as integer milli-lux; no float math
+bool veml7700_read_mlux(veml7700_t *dev, int32_t *mlux);
+
+//non-blocking autorange; jumps straight to the best setting and reports SETTLING for one integration time
+veml7700_ar_status_t veml7700_autorange_poll(veml7700_t *dev, float *lux);
 
-//helper function; updates gain and integration time settings for maximum accuracy
-static bool veml7700_autorange_update(veml7700_t *dev, uint16_t counts);
+//same as veml7700_autorange_poll with the result in milli-lux
+veml7700_ar_status_t veml7700_autorange_poll_mlux(veml7700_t *dev, int32_t *mlux);
 
-//adjusts gain and integration time settings based on read lux
+//adjusts gain and integration time settings based on read lux; blocks until a valid reading
 bool veml7700_read_lux_autorange(veml7700_t *dev, float *lux);
 
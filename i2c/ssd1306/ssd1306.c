@@ -1,10 +1,17 @@
 #include "ssd1306.h"
 #include <string.h>
 #include "font_table.h"
+#include "font_atlas.h"
+#include "ssd1306_gfx.h"
+#include "i2c_bus.h"
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
 
 //screen control codes
 #define COMMAND 0x00 //control byte; tells device next info is command info
 #define DATA 0x40 //control byte; tells device next info is to be displayed
+#define COMMAND_CONT 0x80 //control byte with Co set; exactly one command byte follows, then another control byte
 
 #define DISPLAY_OFF 0xAE
 #define DISPLAY_ON 0xAF
@@ -14,6 +21,8 @@
 #define START_LINE_0 0x40
 #define SET_CHARGE_PUMP 0x8D
 #define SET_MEMORY_MODE 0x20
+#define SET_COLUMN_RANGE 0x21 //start col, end col; horizontal/vertical modes only
+#define SET_PAGE_RANGE 0x22 //start page, end page; horizontal/vertical modes only
 #define OUTPUT_FROM_RAM 0xA4
 #define NORMAL_DISPLAY_MODE 0xA6
 
@@ -22,9 +31,24 @@
 #define DEFAULT_SCAN_H_DIR 0xA0 //right to left
 #define INVERTED_SCAN_H_DIR 0xA1 //left to right
 
+//approximate cost of a transaction beyond its payload (start + address byte + stop), in bytes
+#define TRANSACTION_OVERHEAD 2
+
+//one full-frame burst, static to keep it off the stack; blocking and dma flushes are done with it before they return
+static uint8_t tx_buf[WINDOW_HEADER_SIZE + BUFFER_SIZE];
+
+//helper function for every write to the screen; keeps transaction/byte counts
+static bool ssd1306_write(ssd1306_t *dev, const uint8_t *src, size_t len){
+    ssd1306_flush_wait(dev); //an async flush owns the controller until it drains
+
+    int write = i2c_bus_write(dev->port, dev->addr, src, len, false);
+    dev->stats.transactions++;
+    dev->stats.bytes += (uint32_t)len;
+    return (write == (int)len);
+}
 
 //helper function to write a list of commands to the screen
-static bool ssd1306_write_commands(const ssd1306_t *dev, const uint8_t *commands, size_t n){
+static bool ssd1306_write_commands(ssd1306_t *dev, const uint8_t *commands, size_t n){
 
     uint8_t temp[32]; //temporary buffer to hold commands
     if(n+1 > sizeof(temp) || !dev || !commands){ return false; } //if there are too many (or invalid input), don't get tied up
@@ -34,14 +58,22 @@ static bool ssd1306_write_commands(const ssd1306_t *dev, const uint8_t *commands
         temp[i+1] = commands[i]; //shift commands over one to make room for control byte
     }
 
-    int write = i2c_write_blocking(dev->port, dev->addr, temp, (int)(n+1), false);
-
-    return (write == (int)(n+1));
+    return ssd1306_write(dev, temp, n+1);
 }
 
-bool ssd1306_init(ssd1306_t *dev, i2c_inst_t *port, uint8_t addr){
+bool ssd1306_init(ssd1306_t *dev, i2c_inst_t *port, uint8_t addr, uint32_t flash_ms){
     dev->port = port;
     dev->addr = addr;
+    dev->dirty_pages = 0;
+    ssd1306_reset_stats(dev);
+
+    dev->dma_chan = -1; //claimed on first async flush
+    dev->flush_busy = false;
+    dev->flush_cb = NULL;
+    dev->flush_ctx = NULL;
+    dev->flush_len = 0;
+    dev->flush_dma = false;
+    dev->flush_failed = false;
 
     const uint8_t init_commands[] = {
         DISPLAY_OFF,            
@@ -51,7 +83,7 @@ bool ssd1306_init(ssd1306_t *dev, i2c_inst_t *port, uint8_t addr){
         START_LINE_0,             // start line = 0
 
         SET_CHARGE_PUMP, 0x14,       // charge pump enable
-        SET_MEMORY_MODE, PAGE,       // memory mode = page
+        SET_MEMORY_MODE, HORIZONTAL,       // memory mode = horizontal; pointer wraps across pages inside the window
 
         OUTPUT_FROM_RAM,             // output from RAM, not overridden
         NORMAL_DISPLAY_MODE,             // normal display (not inverted)
@@ -60,48 +92,297 @@ bool ssd1306_init(ssd1306_t *dev, i2c_inst_t *port, uint8_t addr){
 
         DISPLAY_ON             
     };
-    ssd1306_write_commands(dev, init_commands, sizeof(init_commands));
+    bool ok = ssd1306_write_commands(dev, init_commands, sizeof(init_commands));
 
-    ssd1306_fill_buffer(dev);
-    ssd1306_show(dev);
-    sleep_ms(500);
-    ssd1306_clear_buffer(dev);
-    ssd1306_show(dev);
+    if (flash_ms) {
+        ssd1306_fill_buffer(dev);
+        ssd1306_show(dev);
+        sleep_ms(flash_ms);
+    }
+    memset(dev->buffer, 0x00, BUFFER_SIZE); //ram is random at power-on, so the whole frame goes out once
+    ok = ssd1306_show(dev) && ok;
 
-    return true;
+    return ok;
 
 }
 
 void ssd1306_clear_buffer(ssd1306_t *dev){
     if (!dev) return;
+    for (int page = 0; page < DISPLAY_PAGES; page++) { //only columns that had something lit need resending
+        const uint8_t *row = &dev->buffer[page * DISPLAY_WIDTH];
+        int x0 = 0, x1 = DISPLAY_WIDTH - 1;
+        while (x0 <= x1 && row[x0] == 0x00) x0++;
+        while (x1 >= x0 && row[x1] == 0x00) x1--;
+        ssd1306_mark_dirty(dev, page, x0, x1); //no-op if page was already blank
+    }
     memset(dev->buffer, 0x00, BUFFER_SIZE);
 }
 
 void ssd1306_fill_buffer(ssd1306_t *dev){
     if (!dev) return;
     memset(dev->buffer, 0xFF, BUFFER_SIZE);
+    ssd1306_mark_all_dirty(dev);
+}
+
+//helper function to lay out one window transaction in out; returns its length
+static size_t ssd1306_build_window(const ssd1306_t *dev, uint8_t *out, uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1){
+    //window setup and pixel data in one transaction: every command byte rides behind a Co control byte
+    uint8_t *p = out;
+    const uint8_t window[] = { SET_COLUMN_RANGE, x0, x1, SET_PAGE_RANGE, page0, page1 };
+    for (size_t i = 0; i < sizeof(window); i++) {
+        *p++ = COMMAND_CONT;
+        *p++ = window[i];
+    }
+    *p++ = DATA; //everything after this is display data until stop
+
+    size_t w = (size_t)(x1 - x0) + 1;
+    for (uint8_t page = page0; page <= page1; page++) { //horizontal mode walks the window row by row
+        memcpy(p, &dev->buffer[page * DISPLAY_WIDTH + x0], w);
+        p += w;
+    }
+    return (size_t)(p - out);
+}
+
+//helper function to find the smallest window holding every dirty page; false if nothing is dirty
+static bool ssd1306_dirty_bounds(const ssd1306_t *dev, uint8_t *x0, uint8_t *x1, uint8_t *page0, uint8_t *page1){
+    if (dev->dirty_pages == 0){ return false; }
+
+    *x0 = DISPLAY_WIDTH - 1; *x1 = 0; *page0 = DISPLAY_PAGES; *page1 = 0;
+    for (uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+        if (!(dev->dirty_pages & (1u << page))){ continue; }
+        if (dev->dirty_x0[page] < *x0) *x0 = dev->dirty_x0[page];
+        if (dev->dirty_x1[page] > *x1) *x1 = dev->dirty_x1[page];
+        if (page < *page0) *page0 = page;
+        *page1 = page;
+    }
+    return true;
+}
+
+bool ssd1306_show_window(ssd1306_t *dev, uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1){
+    if (!dev || x0 > x1 || x1 >= DISPLAY_WIDTH || page0 > page1 || page1 >= DISPLAY_PAGES){ return false; }
+
+    size_t len = ssd1306_build_window(dev, tx_buf, x0, x1, page0, page1);
+    return ssd1306_write(dev, tx_buf, len);
 }
 
 bool ssd1306_show(ssd1306_t *dev){ //directly replaces screen's RAM with buffer
-    for (uint8_t page = 0; page < (DISPLAY_HEIGHT/8); page++) { //a page is a rectangle that spans the display horizontally and is 8 pixels high
-        uint8_t set_page[] = { (uint8_t)(0xB0 | page) }; //0xB_ chooses a page; 0xB0 | page sets it to current page
-        if (!ssd1306_write_commands(dev, set_page, sizeof(set_page))){ return false; } //moves "cursor" to current page
+    if (!ssd1306_show_window(dev, 0, DISPLAY_WIDTH - 1, 0, DISPLAY_PAGES - 1)){ return false; } //whole frame as one burst
+    dev->dirty_pages = 0; //screen now matches buffer
+    return true;
+}
+
+bool ssd1306_show_dirty(ssd1306_t *dev, uint32_t *skipped_bytes){ //only sends what changed since last flush
+    if (dev->dirty_pages == 0) {
+        if (skipped_bytes){ *skipped_bytes = BUFFER_SIZE; }
+        return true;
+    }
+
+    //compare one window per dirty page against a single bounding rectangle and send whichever is fewer bytes
+    uint32_t per_page_cost = 0, per_page_data = 0;
+    for (uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+        if (!(dev->dirty_pages & (1u << page))){ continue; }
+        uint32_t w = (uint32_t)(dev->dirty_x1[page] - dev->dirty_x0[page]) + 1;
+        per_page_data += w;
+        per_page_cost += WINDOW_HEADER_SIZE + TRANSACTION_OVERHEAD + w;
+    }
+    uint8_t x0, x1, page0, page1;
+    ssd1306_dirty_bounds(dev, &x0, &x1, &page0, &page1);
+    uint32_t rect_data = (uint32_t)(x1 - x0 + 1) * (uint32_t)(page1 - page0 + 1);
+    uint32_t rect_cost = WINDOW_HEADER_SIZE + TRANSACTION_OVERHEAD + rect_data;
+
+    uint32_t sent;
+    if (rect_cost <= per_page_cost) {
+        if (!ssd1306_show_window(dev, x0, x1, page0, page1)){ return false; }
+        dev->dirty_pages = 0;
+        sent = rect_data;
+    }
+    else {
+        for (uint8_t page = page0; page <= page1; page++) {
+            if (!(dev->dirty_pages & (1u << page))){ continue; } //page untouched, nothing to send
+
+            if (!ssd1306_show_window(dev, dev->dirty_x0[page], dev->dirty_x1[page], page, page)){ return false; }
+            dev->dirty_pages &= (uint8_t)~(1u << page); //clear as we go so a failed flush only resends what's left
+        }
+        sent = per_page_data;
+    }
+
+    if (skipped_bytes){ *skipped_bytes = BUFFER_SIZE - sent; }
+    return true;
+}
+
+void ssd1306_reset_stats(ssd1306_t *dev){
+    if (!dev) return;
+    dev->stats.transactions = 0;
+    dev->stats.bytes = 0;
+}
+
+//devices with a flush in flight, by dma channel, so the shared irq handler can find them
+static ssd1306_t *dma_owner[NUM_DMA_CHANNELS];
+static bool dma_irq_installed = false;
+
+static void ssd1306_dma_irq_handler(void){
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ch++) {
+        ssd1306_t *dev = dma_owner[ch];
+        if (!dev || !dma_channel_get_irq0_status(ch)){ continue; }
+
+        dma_channel_acknowledge_irq0(ch);
+        dma_owner[ch] = NULL;
+        dev->flush_busy = false; //last word is in the i2c fifo; ssd1306_flush_done also waits for the bus
+        if (dev->flush_cb){ dev->flush_cb(dev->flush_ctx); }
+    }
+}
 
-        uint8_t set_col[] = { 0x00, 0x10 }; //0x0_ is lower column register (lowest 4 bits), 0x1_ is upper column register (highest 3 bits) for 7 bit address
-        if (!ssd1306_write_commands(dev, set_col, sizeof(set_col))){ return false; } //moves "cursor" to first column (col 0) in the page
+bool ssd1306_show_async(ssd1306_t *dev, ssd1306_flush_cb_t cb, void *ctx){
+    if (!dev || !ssd1306_flush_done(dev)){ return false; } //previous frame still in flight
+    if (i2c_bus_queue(dev->port)){ return false; } //the queue owns the controller; use ssd1306_show_queued
 
-        const uint8_t *src = &dev->buffer[page * DISPLAY_WIDTH]; //pointer to buffer array
+    uint8_t x0, x1, page0, page1;
+    if (!ssd1306_dirty_bounds(dev, &x0, &x1, &page0, &page1)) { //screen already matches buffer
+        if (cb){ cb(ctx); }
+        return true;
+    }
 
-        uint8_t data[1 + DISPLAY_WIDTH]; //1 control byte, DISPLAY_WIDTH (128) bytes of data per page
-        data[0] = DATA; //first byte is control byte that says display data is coming
-        for (int i = 0; i < DISPLAY_WIDTH; i++) { data[i+1] = src[i]; } // fill the rest with buffer data
+    if (dev->dma_chan < 0) {
+        dev->dma_chan = dma_claim_unused_channel(false);
+        if (dev->dma_chan < 0){ return false; } //no free channel; caller can fall back to ssd1306_show_dirty
+    }
+    if (!dma_irq_installed) {
+        irq_add_shared_handler(DMA_IRQ_0, ssd1306_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_0, true);
+        dma_irq_installed = true;
+    }
 
-        int write = i2c_write_blocking(dev->port, dev->addr, data, (int)sizeof(data), false); //write all 0s to screen
-        if(write != (int)(sizeof(data))){ return false; }
+    //copy the window into the front buffer as data_cmd words; stop after the last byte ends the transaction
+    size_t len = ssd1306_build_window(dev, tx_buf, x0, x1, page0, page1);
+    for (size_t i = 0; i < len; i++) {
+        dev->front[i] = tx_buf[i];
     }
+    dev->front[len - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+    dev->dirty_pages = 0; //back buffer is free to draw the next frame from here on
+
+    //target address can only change while the controller is disabled
+    i2c_hw_t *hw = i2c_get_hw(dev->port);
+    hw->enable = 0;
+    hw->tar = dev->addr;
+    hw->enable = 1;
+
+    dma_channel_config cfg = dma_channel_get_default_config((uint)dev->dma_chan);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+    channel_config_set_read_increment(&cfg, true);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_dreq(&cfg, i2c_get_dreq(dev->port, true)); //paced by i2c tx fifo space
+
+    dev->flush_cb = cb;
+    dev->flush_ctx = ctx;
+    dev->flush_busy = true;
+    dev->flush_dma = true;
+    dev->flush_len = (uint32_t)len;
+    dev->flush_start_us = time_us_32();
+    dma_owner[dev->dma_chan] = dev;
+    dma_channel_set_irq0_enabled((uint)dev->dma_chan, true);
+
+    dev->stats.transactions++;
+    dev->stats.bytes += (uint32_t)len;
+    dma_channel_configure((uint)dev->dma_chan, &cfg, &hw->data_cmd, dev->front, (uint)len, true);
     return true;
 }
 
+//queue completion; i2c irq context, so drawing state is left for ssd1306_flush_done to fix up
+static void ssd1306_queued_done(void *ctx, int result){
+    ssd1306_t *dev = (ssd1306_t *)ctx;
+    if (result < 0){ dev->flush_failed = true; }
+    dev->flush_busy = false;
+    if (dev->flush_cb){ dev->flush_cb(dev->flush_ctx); }
+}
+
+bool ssd1306_show_queued(ssd1306_t *dev, i2c_queue_t *q, ssd1306_flush_cb_t cb, void *ctx){
+    if (!dev || !q || !ssd1306_flush_done(dev)){ return false; } //previous frame still in flight
+
+    uint8_t x0, x1, page0, page1;
+    if (!ssd1306_dirty_bounds(dev, &x0, &x1, &page0, &page1)) { //screen already matches buffer
+        if (cb){ cb(ctx); }
+        return true;
+    }
+
+    //the window header rides in the first chunk; every later chunk restarts with the DATA control byte,
+    //and the controller's column/page pointer carries on across the stop. the queue reads the frame from
+    //this device's own front buffer, so other panels can build and send windows while it waits its turn
+    size_t len = ssd1306_build_window(dev, dev->front_bytes, x0, x1, page0, page1);
+    i2c_txn_init(&dev->flush_txn, dev->addr, I2C_PRIO_LOW, dev->front_bytes, len, NULL, 0, ssd1306_queued_done, dev);
+    dev->flush_txn.chunk = SSD1306_QUEUE_CHUNK;
+    dev->flush_txn.prefix[0] = DATA;
+    dev->flush_txn.prefix_len = 1;
+
+    dev->flush_cb = cb;
+    dev->flush_ctx = ctx;
+    dev->flush_busy = true;
+    dev->flush_dma = false;
+    if (!i2c_queue_submit(q, &dev->flush_txn)) {
+        dev->flush_busy = false;
+        return false; //still dirty; the next flush picks it up
+    }
+    dev->dirty_pages = 0; //back buffer is free to draw the next frame from here on
+
+    uint32_t chunks = (uint32_t)((len + SSD1306_QUEUE_CHUNK - 1) / SSD1306_QUEUE_CHUNK);
+    dev->stats.transactions += chunks;
+    dev->stats.bytes += (uint32_t)len + (chunks - 1); //one prefix byte per extra chunk
+    return true;
+}
+
+bool ssd1306_flush_done(ssd1306_t *dev){
+    if (!dev || dev->flush_busy){ return false; }
+    if (dev->flush_failed) { //queued flush nacked part way; panel contents unknown, resend everything next time
+        dev->flush_failed = false;
+        ssd1306_mark_all_dirty(dev);
+    }
+    if (!dev->flush_dma){ return true; } //never flushed over dma, or the queue already saw the bus go idle
+
+    //dma finishing only means the fifo has the last byte; the bus is free once it has drained and stopped
+    i2c_hw_t *hw = i2c_get_hw(dev->port);
+    if (!(hw->status & I2C_IC_STATUS_TFE_BITS) || (hw->status & I2C_IC_STATUS_ACTIVITY_BITS)){ return false; }
+    bool aborted = (hw->raw_intr_stat & I2C_IC_INTR_STAT_R_TX_ABRT_BITS);
+    if (aborted) { //nack mid-frame; clear the abort so the next transfer can run
+        (void)hw->clr_tx_abrt;
+        ssd1306_mark_all_dirty(dev); //panel contents unknown, resend everything next time
+    }
+    if (dev->flush_len) { //first time we see this flush finished; the bus layer counts it like a blocking write
+        i2c_bus_record(dev->port, dev->addr, dev->flush_len, aborted ? PICO_ERROR_GENERIC : (int)dev->flush_len,
+                       time_us_32() - dev->flush_start_us);
+        dev->flush_len = 0;
+    }
+    return true;
+}
+
+void ssd1306_flush_wait(ssd1306_t *dev){
+    while (!ssd1306_flush_done(dev)) {
+        tight_loop_contents();
+    }
+}
+
+void ssd1306_mark_dirty(ssd1306_t *dev, int page, int x0, int x1){
+    if (!dev || page < 0 || page >= DISPLAY_PAGES) return;
+    if (x0 < 0) x0 = 0;
+    if (x1 >= DISPLAY_WIDTH) x1 = DISPLAY_WIDTH - 1;
+    if (x0 > x1) return;
+
+    uint8_t bit = (uint8_t)(1u << page);
+    if (!(dev->dirty_pages & bit)) { //first change in this page; window is just this range
+        dev->dirty_pages |= bit;
+        dev->dirty_x0[page] = (uint8_t)x0;
+        dev->dirty_x1[page] = (uint8_t)x1;
+        return;
+    }
+    if (x0 < dev->dirty_x0[page]) dev->dirty_x0[page] = (uint8_t)x0; //otherwise grow window to cover both
+    if (x1 > dev->dirty_x1[page]) dev->dirty_x1[page] = (uint8_t)x1;
+}
+
+void ssd1306_mark_all_dirty(ssd1306_t *dev){
+    if (!dev) return;
+    for (int page = 0; page < DISPLAY_PAGES; page++) {
+        ssd1306_mark_dirty(dev, page, 0, DISPLAY_WIDTH - 1);
+    }
+}
+
 //draws pixel IN THE BUFFER; still needs to be shown to send to OLED's RAM
 void ssd1306_draw_pixel(ssd1306_t *dev, int x, int y, bool on){ 
     if( x<0 || x>= DISPLAY_WIDTH || y<0 || y>=DISPLAY_HEIGHT ){ return; } //check valid bounds
@@ -112,6 +393,7 @@ void ssd1306_draw_pixel(ssd1306_t *dev, int x, int y, bool on){
     int index = (page * DISPLAY_WIDTH) + x; //finds position of byte that pixel is located in
 
     uint8_t mask = (uint8_t) 1u << bit;
+    uint8_t prev = dev->buffer[index];
 
     if (on) { 
         dev->buffer[index] |=  mask; // set bit
@@ -119,6 +401,8 @@ void ssd1306_draw_pixel(ssd1306_t *dev, int x, int y, bool on){
     else {
         dev->buffer[index] &= (uint8_t)~mask; // clear bit
     }
+
+    if (dev->buffer[index] != prev) { ssd1306_mark_dirty(dev, page, x, x); } //only real changes need flushing
 }
 
 //helper function to write a letter to the screen
@@ -136,10 +420,44 @@ void ssd1306_draw_glyph(ssd1306_t *dev, int x, int y, const uint8_t c[], int row
     }
 }
 
+#define GLYPH_MAX_BLIT_SCALE 8 //largest scale expanded into a stack bitmap; bigger falls back to per pixel
+
 void ssd1306_draw_ascii(ssd1306_t *dev, int x, int y, char c, int scale){
     if ((unsigned char)c < 0x20 || (unsigned char)c > 0x7F) c = '?'; //if not in table, make ?
     const uint8_t *target = BASIC_ASCII[(uint8_t)c - 0x20]; //select target char from table
 
+    if (scale == 1) { //font columns are already one page tall in framebuffer layout
+        ssd1306_blit(dev, x, y, target, 5, 7, GFX_SET);
+        return;
+    }
+
+    const font_t *prescaled = (scale == 2) ? &FONT_5X7_X2 : (scale == 3) ? &FONT_5X7_X3 : NULL;
+    if (prescaled) { //generated at build time, already page-major
+        uint8_t w;
+        const uint8_t *glyph = font_glyph(prescaled, c, &w);
+        ssd1306_blit(dev, x, y, glyph, w, prescaled->height, GFX_SET);
+        return;
+    }
+
+    if (scale > 1 && scale <= GLYPH_MAX_BLIT_SCALE) { //stretch each column vertically, repeat it scale times, then blit
+        uint8_t scaled[((7 * GLYPH_MAX_BLIT_SCALE + 7) / 8) * (5 * GLYPH_MAX_BLIT_SCALE)];
+        int w = 5 * scale, h = 7 * scale;
+        int pages = (h + 7) / 8;
+
+        for (int col = 0; col < 5; col++) {
+            uint64_t tall = 0; //one scaled column, bit n = row n
+            for (int row = 0; row < 7; row++) {
+                if ((target[col] >> row) & 1u) { tall |= ((1ull << scale) - 1) << (row * scale); }
+            }
+            for (int page = 0; page < pages; page++) {
+                uint8_t bits = (uint8_t)(tall >> (page * 8));
+                memset(&scaled[page * w + col * scale], bits, (size_t)scale);
+            }
+        }
+        ssd1306_blit(dev, x, y, scaled, w, h, GFX_SET);
+        return;
+    }
+
     for (int col = 0; col < 5; col++) {
         uint8_t bits = target[col];
 
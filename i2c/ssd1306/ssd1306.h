@@ -3,6 +3,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "hardware/i2c.h"
+#include "i2c_queue.h"
 
 /*
   Module target: GME12864-13 family (0.96", 128x64, I2C, addr 0x3C or 0x3D).
@@ -15,6 +16,10 @@
 #define DISPLAY_WIDTH 128
 #define DISPLAY_HEIGHT 64
 #define BUFFER_SIZE ((DISPLAY_WIDTH * DISPLAY_HEIGHT) / 8) //1 pixel per bit, 8 pixels per byte
+#define DISPLAY_PAGES (DISPLAY_HEIGHT / 8) //8 pixel tall rows the controller addresses as a unit
+
+//window commands are sent ahead of the data in the same transaction, each behind its own control byte
+#define WINDOW_HEADER_SIZE 13 //6 x (control + command) + DATA control byte
 
 //typical addresses for ssd1306 modules
 //put in header file for public access and readability when passing
@@ -32,6 +37,18 @@ typedef enum {
   PAGE = 2
 } ssd1306_addrmode_t;
 
+//i2c traffic generated by the driver, for comparing flush strategies
+typedef struct {
+  uint32_t transactions; //start..stop sequences sent
+  uint32_t bytes; //bytes after the address byte, control bytes included
+} ssd1306_stats_t;
+
+//most data bytes per bus transaction in a queued flush; sensor reads can get in between chunks (~6 ms each at 100 kHz)
+#define SSD1306_QUEUE_CHUNK 64
+
+//called from the DMA irq once an async flush has handed its last byte to the i2c controller (i2c irq for a queued flush)
+typedef void (*ssd1306_flush_cb_t)(void *ctx);
+
 typedef struct {
   i2c_inst_t *port;
   uint8_t addr;
@@ -40,7 +57,7 @@ typedef struct {
   uint16_t height;
   uint8_t offset; //optional column offset to shift image horizontally
 
-  uint8_t buffer[BUFFER_SIZE];
+  uint8_t buffer[BUFFER_SIZE]; //back buffer; all drawing happens here
   
   //for writing text to screen
   uint8_t x_pos;
@@ -48,9 +65,35 @@ typedef struct {
   bool text_wrap;
   bool invert;
 
+  //dirty region tracking; one column window per page, cleared on flush
+  uint8_t dirty_pages; //bit n set = page n changed since last flush
+  uint8_t dirty_x0[DISPLAY_PAGES]; //first changed column in each dirty page
+  uint8_t dirty_x1[DISPLAY_PAGES]; //last changed column in each dirty page (inclusive)
+
+  ssd1306_stats_t stats;
+
+  //async flush; front holds the frame in flight so drawing can continue in buffer: i2c data_cmd words
+  //for a dma flush, plain bytes for a queued one
+  union {
+    uint16_t front[WINDOW_HEADER_SIZE + BUFFER_SIZE];
+    uint8_t front_bytes[WINDOW_HEADER_SIZE + BUFFER_SIZE];
+  };
+  int dma_chan; //-1 until the first async flush claims one
+  volatile bool flush_busy;
+  ssd1306_flush_cb_t flush_cb;
+  void *flush_ctx;
+  uint32_t flush_len; //bytes of the async flush not yet accounted to the bus stats, 0 if none
+  uint32_t flush_start_us;
+  bool flush_dma; //last async flush went over dma, so the bus has to drain before the next transfer
+
+  //queued flush; sends from front_bytes, which only this device's next flush touches, after it completes
+  i2c_txn_t flush_txn;
+  volatile bool flush_failed; //set from the i2c irq, picked up by ssd1306_flush_done
+
 } ssd1306_t;
 
-bool ssd1306_init(ssd1306_t *dev, i2c_inst_t *port, uint8_t addr);
+//sets up the controller and clears the panel; flash_ms > 0 first holds it all white that long as a lamp test
+bool ssd1306_init(ssd1306_t *dev, i2c_inst_t *port, uint8_t addr, uint32_t flash_ms);
 
 void ssd1306_clear_buffer(ssd1306_t *dev);
 
@@ -58,6 +101,34 @@ void ssd1306_fill_buffer(ssd1306_t *dev);
 
 bool ssd1306_show(ssd1306_t *dev);
 
+//sends columns x0..x1 of pages page0..page1 (inclusive) as one i2c transaction
+bool ssd1306_show_window(ssd1306_t *dev, uint8_t x0, uint8_t x1, uint8_t page0, uint8_t page1);
+
+//sends only what changed, as one window per dirty page or one bounding window, whichever is smaller; skipped_bytes (optional) gets the data bytes not sent
+bool ssd1306_show_dirty(ssd1306_t *dev, uint32_t *skipped_bytes);
+
+//starts sending the dirty window over dma and returns immediately; false if the previous flush hasn't finished
+bool ssd1306_show_async(ssd1306_t *dev, ssd1306_flush_cb_t cb, void *ctx);
+
+//queues the dirty window on q as a low priority write in SSD1306_QUEUE_CHUNK pieces and returns immediately;
+//false if the previous flush hasn't finished. use this instead of ssd1306_show_async once the port has a queue
+bool ssd1306_show_queued(ssd1306_t *dev, i2c_queue_t *q, ssd1306_flush_cb_t cb, void *ctx);
+
+//true once the last async flush is fully on the wire and the bus is idle
+bool ssd1306_flush_done(ssd1306_t *dev);
+
+//blocks until ssd1306_flush_done; every blocking write calls this first
+void ssd1306_flush_wait(ssd1306_t *dev);
+
+//grows the dirty window of a page to include columns x0..x1
+void ssd1306_mark_dirty(ssd1306_t *dev, int page, int x0, int x1);
+
+//forces the next ssd1306_show_dirty to resend the whole frame
+void ssd1306_mark_all_dirty(ssd1306_t *dev);
+
+//zeroes the transaction/byte counters in dev->stats
+void ssd1306_reset_stats(ssd1306_t *dev);
+
 void ssd1306_draw_pixel(ssd1306_t *dev, int x, int y, bool on);
 
 void ssd1306_draw_glyph(ssd1306_t *dev, int x, int y, const uint8_t c[], int rows, int cols);
@@ -0,0 +1,125 @@
+#include "ssd1306_gfx.h"
+#include <string.h>
+
+//helper function to apply a raster op to one framebuffer byte; mask limits which bits the op may touch
+static inline uint8_t gfx_apply(uint8_t dst, uint8_t bits, uint8_t mask, ssd1306_rop_t op){
+    switch (op) {
+        case GFX_SET: return (uint8_t)(dst | (bits & mask));
+        case GFX_CLEAR: return (uint8_t)(dst & ~(bits & mask));
+        case GFX_INVERT: return (uint8_t)(dst ^ (bits & mask));
+        case GFX_COPY: return (uint8_t)((dst & ~mask) | (bits & mask));
+        default: return dst;
+    }
+}
+
+//helper function to clip a rectangle to the screen; false if nothing is left
+static bool gfx_clip(int *x, int *y, int *w, int *h){
+    if (*x < 0) { *w += *x; *x = 0; }
+    if (*y < 0) { *h += *y; *y = 0; }
+    if (*x + *w > DISPLAY_WIDTH) *w = DISPLAY_WIDTH - *x;
+    if (*y + *h > DISPLAY_HEIGHT) *h = DISPLAY_HEIGHT - *y;
+    return (*w > 0 && *h > 0);
+}
+
+//helper function for every solid rectangle op; one mask per page, then a straight run of bytes
+static void gfx_rect(ssd1306_t *dev, int x, int y, int w, int h, ssd1306_rop_t op){
+    if (!dev || !gfx_clip(&x, &y, &w, &h)) return;
+
+    int y_end = y + h; //exclusive
+    for (int page = y >> 3; page <= (y_end - 1) >> 3; page++) {
+        int top = (y > page * 8) ? y - page * 8 : 0; //first row inside this page
+        int bot = (y_end < page * 8 + 8) ? y_end - page * 8 : 8; //one past last row
+        uint8_t mask = (uint8_t)((0xFFu << top) & (0xFFu >> (8 - bot)));
+
+        uint8_t *row = &dev->buffer[page * DISPLAY_WIDTH + x];
+        if (mask == 0xFF && op != GFX_INVERT) { //whole page column set or cleared: plain memset
+            memset(row, (op == GFX_CLEAR) ? 0x00 : 0xFF, (size_t)w);
+        }
+        else {
+            for (int i = 0; i < w; i++) { row[i] = gfx_apply(row[i], 0xFF, mask, op); }
+        }
+        ssd1306_mark_dirty(dev, page, x, x + w - 1);
+    }
+}
+
+void ssd1306_fill_rect(ssd1306_t *dev, int x, int y, int w, int h, bool on){
+    gfx_rect(dev, x, y, w, h, on ? GFX_SET : GFX_CLEAR);
+}
+
+void ssd1306_invert_rect(ssd1306_t *dev, int x, int y, int w, int h){
+    gfx_rect(dev, x, y, w, h, GFX_INVERT);
+}
+
+void ssd1306_hline(ssd1306_t *dev, int x, int y, int w, bool on){
+    gfx_rect(dev, x, y, w, 1, on ? GFX_SET : GFX_CLEAR);
+}
+
+void ssd1306_vline(ssd1306_t *dev, int x, int y, int h, bool on){
+    gfx_rect(dev, x, y, 1, h, on ? GFX_SET : GFX_CLEAR);
+}
+
+void ssd1306_blit(ssd1306_t *dev, int x, int y, const uint8_t *src, int w, int h, ssd1306_rop_t op){
+    if (!dev || !src || w <= 0 || h <= 0) return;
+
+    //horizontal clip: skip source columns that land off screen
+    int sx0 = (x < 0) ? -x : 0;
+    int sx1 = (x + w > DISPLAY_WIDTH) ? DISPLAY_WIDTH - x : w; //exclusive
+    if (sx0 >= sx1 || y >= DISPLAY_HEIGHT || y + h <= 0) return;
+    int n = sx1 - sx0;
+    int dx = x + sx0;
+
+    //each source page lands on dest page dp (shifted down by s) and, if unaligned, spills into dp + 1
+    int shift = y & 7; //works for negative y too (two's complement)
+    int dp0 = (y - shift) / 8;
+    int src_pages = (h + 7) / 8;
+
+    for (int sp = 0; sp < src_pages; sp++) {
+        const uint8_t *col = &src[sp * w + sx0];
+        int rows = h - sp * 8;
+        uint8_t valid = (rows >= 8) ? 0xFF : (uint8_t)((1u << rows) - 1); //last page may be partial
+        int dp = dp0 + sp;
+
+        if (shift == 0) { //page-aligned: one dest byte per source byte
+            if (dp < 0 || dp >= DISPLAY_PAGES) continue;
+            uint8_t *dst = &dev->buffer[dp * DISPLAY_WIDTH + dx];
+            if (valid == 0xFF && op == GFX_COPY) {
+                memcpy(dst, col, (size_t)n);
+            }
+            else {
+                for (int i = 0; i < n; i++) { dst[i] = gfx_apply(dst[i], col[i], valid, op); }
+            }
+            ssd1306_mark_dirty(dev, dp, dx, dx + n - 1);
+            continue;
+        }
+
+        uint8_t lo_mask = (uint8_t)(valid << shift);
+        uint8_t hi_mask = (uint8_t)(valid >> (8 - shift));
+        if (dp >= 0 && dp < DISPLAY_PAGES && lo_mask) { //low bits of each source byte into the upper page
+            uint8_t *dst = &dev->buffer[dp * DISPLAY_WIDTH + dx];
+            for (int i = 0; i < n; i++) { dst[i] = gfx_apply(dst[i], (uint8_t)(col[i] << shift), lo_mask, op); }
+            ssd1306_mark_dirty(dev, dp, dx, dx + n - 1);
+        }
+        if (dp + 1 >= 0 && dp + 1 < DISPLAY_PAGES && hi_mask) { //high bits into the page below
+            uint8_t *dst = &dev->buffer[(dp + 1) * DISPLAY_WIDTH + dx];
+            for (int i = 0; i < n; i++) { dst[i] = gfx_apply(dst[i], (uint8_t)(col[i] >> (8 - shift)), hi_mask, op); }
+            ssd1306_mark_dirty(dev, dp + 1, dx, dx + n - 1);
+        }
+    }
+}
+
+int ssd1306_draw_text(ssd1306_t *dev, int x, int y, const char *s, const font_t *font, ssd1306_rop_t op){
+    if (!dev || !s || !font) return x;
+
+    int cursor = x;
+    for (const char *p = s; *p && cursor < DISPLAY_WIDTH; p++) {
+        uint8_t w;
+        const uint8_t *glyph = font_glyph(font, *p, &w);
+        ssd1306_blit(dev, cursor, y, glyph, w, font->height, op); //page-aligned y makes this straight byte copies
+
+        if (op == GFX_COPY && p[1]) { //gap belongs to the text too
+            ssd1306_fill_rect(dev, cursor + w, y, font->spacing, font->height, false);
+        }
+        cursor += w + font->spacing;
+    }
+    return cursor;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ssd1306.h"
+#include "font.h"
+
+/*
+  Raster layer on top of ssd1306_t::buffer.
+  - Works a whole byte (one column of one page, 8 pixels) at a time instead of per pixel
+  - Everything is clipped once up front; off-screen parts are dropped, not wrapped
+  - Touched columns are marked dirty for ssd1306_show_dirty / ssd1306_show_async
+*/
+
+//how source bits combine with the framebuffer
+typedef enum {
+  GFX_SET = 0, //OR: 1 bits light pixels, 0 bits leave them alone
+  GFX_CLEAR = 1, //AND-NOT: 1 bits turn pixels off
+  GFX_INVERT = 2, //XOR: 1 bits flip pixels
+  GFX_COPY = 3 //replace: every pixel in the rectangle takes the source value
+} ssd1306_rop_t;
+
+//fills (on) or clears (off) a w x h rectangle with its top left corner at x,y
+void ssd1306_fill_rect(ssd1306_t *dev, int x, int y, int w, int h, bool on);
+
+//flips every pixel in a w x h rectangle
+void ssd1306_invert_rect(ssd1306_t *dev, int x, int y, int w, int h);
+
+//horizontal line w pixels long starting at x,y
+void ssd1306_hline(ssd1306_t *dev, int x, int y, int w, bool on);
+
+//vertical line h pixels long starting at x,y
+void ssd1306_vline(ssd1306_t *dev, int x, int y, int h, bool on);
+
+//draws a w x h 1-bpp bitmap at x,y
+//src uses the framebuffer's own layout: (h+7)/8 pages of w bytes each, bit 0 = top row of the page
+void ssd1306_blit(ssd1306_t *dev, int x, int y, const uint8_t *src, int w, int h, ssd1306_rop_t op);
+
+//draws s with a generated font at x,y; no wrapping, anything past the edge is clipped
+//GFX_COPY also clears the gaps between glyphs, so new text fully replaces what was under it
+//returns the x just past the last glyph's spacing, for placing the next piece of text
+int ssd1306_draw_text(ssd1306_t *dev, int x, int y, const char *s, const font_t *font, ssd1306_rop_t op);
@@ -0,0 +1,160 @@
+#include "led_anim.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//16.16 step that gets from the current value to the target in frames steps
+static void start_fade(led_anim_px_t *p, const uint8_t to[3], uint32_t frames) {
+    for (int c = 0; c < 3; c++) {
+        p->to[c] = to[c];
+        p->step[c] = (((int32_t)to[c] << 16) - p->cur[c]) / (int32_t)frames;
+    }
+    p->frames = frames;
+    p->frames_left = frames;
+}
+
+static uint32_t ms_to_frames(const led_anim_t *a, uint32_t ms) {
+    uint32_t frames = ms * 1000 / a->period_us;
+    return frames ? frames : 1;
+}
+
+//advances one pixel by a frame; true if its color changed
+static bool step_px(led_anim_px_t *p) {
+    if (!p->frames_left) return false;
+
+    for (int c = 0; c < 3; c++) {
+        p->cur[c] += p->step[c];
+    }
+    if (--p->frames_left) return true;
+
+    //landed; snap off the rounding left in the step
+    for (int c = 0; c < 3; c++) {
+        p->cur[c] = (int32_t)p->to[c] << 16;
+    }
+    if (p->pulse) { //turn around; one divide per half cycle, the frames in between are still adds
+        uint8_t back[3];
+        memcpy(back, p->from, 3);
+        memcpy(p->from, p->to, 3);
+        start_fade(p, back, p->frames);
+    }
+    return true;
+}
+
+static bool led_anim_frame(struct repeating_timer *t) {
+    led_anim_t *a = (led_anim_t *)t->user_data;
+    uint32_t start = time_us_32();
+
+    if (!led_strip_ready(a->strip)) { //last frame still going out; try again next tick
+        a->dropped++;
+        return true;
+    }
+
+    bool changed = false;
+    critical_section_enter_blocking(&a->lock);
+    for (uint32_t i = 0; i < a->num_px; i++) {
+        led_anim_px_t *p = &a->px[i];
+        if (!step_px(p)) continue;
+        led_strip_set_rgb(a->strip, i, (uint8_t)(p->cur[0] >> 16), (uint8_t)(p->cur[1] >> 16), (uint8_t)(p->cur[2] >> 16));
+        changed = true;
+    }
+    critical_section_exit(&a->lock);
+
+    if (changed) led_strip_show_async(a->strip); //nothing moving, nothing to send
+
+    uint32_t used = time_us_32() - start;
+    a->frames++;
+    a->last_frame_us = used;
+    a->total_frame_us += used;
+    if (used > a->max_frame_us) a->max_frame_us = used;
+    return true; //keep repeating
+}
+
+bool led_anim_init(led_anim_t *a, led_strip_t *strip, uint32_t fps) {
+    if (!a || !strip || !strip->num_px || fps == 0) return false;
+
+    memset(a, 0, sizeof(*a));
+    a->strip = strip;
+    a->px = calloc(strip->num_px, sizeof(led_anim_px_t));
+    if (!a->px) return false; //num_px stays 0, so the setters stay no-ops
+    a->num_px = strip->num_px;
+    a->period_us = 1000000 / fps;
+    critical_section_init(&a->lock);
+
+    a->pool = alarm_pool_create_with_unused_hardware_alarm(4);
+    if (!a->pool) return false;
+    //negative delay: period measured start to start, so render time doesn't stretch it
+    return alarm_pool_add_repeating_timer_us(a->pool, -(int64_t)a->period_us, led_anim_frame, a, &a->timer);
+}
+
+void led_anim_fade_to(led_anim_t *a, uint32_t index, uint8_t r, uint8_t g, uint8_t b, uint32_t ms) {
+    if (!a || index >= a->num_px) return;
+    const uint8_t to[3] = {r, g, b};
+    led_anim_px_t *p = &a->px[index];
+
+    critical_section_enter_blocking(&a->lock);
+    bool same = !p->pulse && memcmp(p->to, to, 3) == 0;
+    if (!same) { //already there or on the way; restarting would just slow it down
+        p->pulse = false;
+        start_fade(p, to, ms_to_frames(a, ms));
+    }
+    critical_section_exit(&a->lock);
+}
+
+void led_anim_fade_all(led_anim_t *a, uint8_t r, uint8_t g, uint8_t b, uint32_t ms) {
+    if (!a) return;
+    for (uint32_t i = 0; i < a->num_px; i++) {
+        led_anim_fade_to(a, i, r, g, b, ms);
+    }
+}
+
+void led_anim_pulse(led_anim_t *a, uint32_t index, uint8_t r, uint8_t g, uint8_t b, uint32_t period_ms) {
+    if (!a || index >= a->num_px) return;
+    const uint8_t hi[3] = {r, g, b};
+    const uint8_t lo[3] = {r >> 2, g >> 2, b >> 2};
+    led_anim_px_t *p = &a->px[index];
+
+    critical_section_enter_blocking(&a->lock);
+    bool same = p->pulse && ((memcmp(p->to, hi, 3) == 0 && memcmp(p->from, lo, 3) == 0) ||
+                             (memcmp(p->to, lo, 3) == 0 && memcmp(p->from, hi, 3) == 0));
+    if (!same) { //if already breathing this color, leave it mid-cycle
+        p->pulse = true;
+        memcpy(p->from, lo, 3);
+        start_fade(p, hi, ms_to_frames(a, period_ms / 2));
+    }
+    critical_section_exit(&a->lock);
+}
+
+void led_anim_bar(led_anim_t *a, uint32_t lit, uint8_t r, uint8_t g, uint8_t b, uint32_t ms, bool pulse) {
+    if (!a) return;
+    for (uint32_t i = 0; i < a->num_px; i++) {
+        if (i >= lit) {
+            led_anim_fade_to(a, i, 0, 0, 0, ms);
+        } else if (pulse) {
+            led_anim_pulse(a, i, r, g, b, 2 * ms);
+        } else {
+            led_anim_fade_to(a, i, r, g, b, ms);
+        }
+    }
+}
+
+bool led_anim_idle(const led_anim_t *a) {
+    for (uint32_t i = 0; i < a->num_px; i++) {
+        if (a->px[i].frames_left) return false;
+    }
+    return true;
+}
+
+void led_anim_report(const led_anim_t *a) {
+    if (!a->period_us) return; //not started yet
+    unsigned long avg = a->frames ? (unsigned long)(a->total_frame_us / a->frames) : 0;
+    printf("\nleds: %lu frames, avg %lu us, max %lu us of %lu us budget (%lu%%), %lu dropped\n",
+        (unsigned long)a->frames, avg, (unsigned long)a->max_frame_us, (unsigned long)a->period_us,
+        (unsigned long)(a->max_frame_us * 100 / a->period_us), (unsigned long)a->dropped);
+}
+
+void led_anim_reset_stats(led_anim_t *a) {
+    a->frames = 0;
+    a->dropped = 0;
+    a->max_frame_us = 0;
+    a->total_frame_us = 0;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pico/stdlib.h"
+#include "pico/critical_section.h"
+#include "ws2812.h"
+
+#define LED_ANIM_FPS 60
+
+//one pixel's fade; colors are 16.16 fixed point so a step is one add per channel per frame
+typedef struct {
+    int32_t cur[3];
+    int32_t step[3];
+    uint8_t to[3];
+    uint8_t from[3]; //other end of a pulse
+    uint32_t frames; //fade length, kept for pulses
+    uint32_t frames_left;
+    bool pulse; //when the fade lands, turn around and head back
+} led_anim_px_t;
+
+typedef struct {
+    led_strip_t *strip;
+    uint32_t num_px; //same as the strip
+    led_anim_px_t *px; //one per strip pixel, allocated in led_anim_init like the strip's own buffers
+    uint32_t period_us;
+
+    alarm_pool_t *pool; //own pool, so frames render on the core that called led_anim_init
+    struct repeating_timer timer;
+    critical_section_t lock; //targets are set from task context, stepped from the timer irq
+
+    //frame budget; read without the lock, fine for a report
+    uint32_t frames;
+    uint32_t dropped; //strip still busy with the last frame
+    uint32_t last_frame_us;
+    uint32_t max_frame_us;
+    uint64_t total_frame_us;
+} led_anim_t;
+
+//starts rendering frames at fps from a hardware alarm; the irq runs on the calling core.
+//animates every pixel of the strip; false if the per-pixel state can't be allocated
+bool led_anim_init(led_anim_t *a, led_strip_t *strip, uint32_t fps);
+
+//fade one pixel from wherever it is now to a color
+void led_anim_fade_to(led_anim_t *a, uint32_t index, uint8_t r, uint8_t g, uint8_t b, uint32_t ms);
+
+void led_anim_fade_all(led_anim_t *a, uint8_t r, uint8_t g, uint8_t b, uint32_t ms);
+
+//breathe one pixel between a color and a quarter of it; period is one full cycle
+void led_anim_pulse(led_anim_t *a, uint32_t index, uint8_t r, uint8_t g, uint8_t b, uint32_t period_ms);
+
+//bar graph: first lit pixels go to the color, the rest fade out; optionally pulse the lit ones
+void led_anim_bar(led_anim_t *a, uint32_t lit, uint8_t r, uint8_t g, uint8_t b, uint32_t ms, bool pulse);
+
+bool led_anim_idle(const led_anim_t *a);
+
+//frame time used vs the budget at this frame rate
+void led_anim_report(const led_anim_t *a);
+
+void led_anim_reset_stats(led_anim_t *a);
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LED_DEFAULT_BRIGHTNESS 13 //~5% of full; these strips are painfully bright otherwise
+#define LED_COLOR_NO_DITHER 0xFFFFFFFFu //phase for a plain rounded conversion
+
+//builds the lut at LED_DEFAULT_BRIGHTNESS the first time; later calls do nothing
+void led_color_init(void);
+
+//rebuilds the gamma+brightness lut; 255 = full
+void led_color_set_brightness(uint8_t level);
+
+uint8_t led_color_brightness(void);
+
+//rgb -> 0x00GGRRBB through the lut; phase picks the temporal dither step (frame + pixel index works)
+uint32_t led_color_to_grb(uint8_t r, uint8_t g, uint8_t b, uint32_t phase);
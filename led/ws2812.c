@@ -1,25 +1,62 @@
 #include "ws2812.h"
 #include "ws2812.pio.h"
+#include "led_color.h"
 #include <stdlib.h>
+#include <string.h>
 #include "pico/stdlib.h"
-
-#define MAX_BRIGHTNESS 0.05 //5% brightness max
-#define BRIGHTNESS_SCALE MAX_BRIGHTNESS*255
+#include "hardware/dma.h"
+#include "hardware/irq.h"
 
 static PIO ws2812_pio = pio0;
 
-//humans think in rgb, ws2812 wants grb
-static inline uint32_t rgb_to_grb(uint8_t r, uint8_t g, uint8_t b) {
-    r = (uint8_t)((r*BRIGHTNESS_SCALE)/255);
-    g = (uint8_t)((g*BRIGHTNESS_SCALE)/255);
-    b = (uint8_t)((b*BRIGHTNESS_SCALE)/255);
+//humans think in rgb, ws2812 wants grb; the lut does gamma and brightness, the shift is
+//because pio expects 32 bit words but each pixel consumes just the top 24 bits
+static inline uint32_t render(uint32_t rgb, uint32_t phase) {
+    return led_color_to_grb((uint8_t)(rgb >> 16), (uint8_t)(rgb >> 8), (uint8_t)rgb, phase) << 8u;
+}
 
-    return (((uint32_t)g << 16) | ((uint32_t)r << 8) | (uint32_t)b);
+static inline uint32_t pack_rgb(uint8_t r, uint8_t g, uint8_t b) {
+    return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+}
+
+//re-renders every pixel from the rgb source; dithered strips step the phase per pixel and per frame
+static void render_all(led_strip_t *dev) {
+    for (uint32_t i = 0; i < dev->num_px; i++) {
+        dev->pixels[i] = render(dev->rgb[i], dev->dither ? dev->frame + i : LED_COLOR_NO_DITHER);
+    }
 }
 
 //directly writes to LED strip; no buffer
-static inline void put_pixel(const led_strip_t *dev, uint32_t grb) {
-    pio_sm_put_blocking(dev->pio, dev->sm, grb << 8u); //leftshift is because pio expects 32 bit words, but each pixel consumes just top 24 bits
+static inline void put_pixel(const led_strip_t *dev, uint32_t word) {
+    pio_sm_put_blocking(dev->pio, dev->sm, word);
+}
+
+//strips with a frame in flight, by dma channel, so the shared irq handler can find them
+static led_strip_t *dma_owner[NUM_DMA_CHANNELS];
+static bool dma_irq_installed = false;
+
+//alarm callback; frame has fully left the pio and the line has been low long enough to latch
+static int64_t led_strip_latch_done(alarm_id_t id, void *user_data) {
+    led_strip_t *dev = (led_strip_t *)user_data;
+    dev->busy = false;
+    return 0; //one shot
+}
+
+static void led_strip_dma_irq_handler(void) {
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ch++) {
+        led_strip_t *dev = dma_owner[ch];
+        if (!dev || !dma_channel_get_irq0_status(ch)) continue;
+
+        dma_channel_acknowledge_irq0(ch);
+        dma_owner[ch] = NULL;
+
+        //dma is done once the last word is queued; the fifo and osr still have to shift out before the latch
+        uint32_t words_left = pio_sm_get_tx_fifo_level(dev->pio, dev->sm) + 1;
+        uint32_t wait_us = words_left * WS2812_WORD_US + WS2812_RESET_US;
+        if (add_alarm_in_us(wait_us, led_strip_latch_done, dev, true) < 0) {
+            dev->busy = false; //no alarm available; worst case the next frame latches slightly early
+        }
+    }
 }
 
 bool led_strip_init(led_strip_t *dev, PIO pio, uint32_t sm, uint32_t pin, uint32_t num_px) {
@@ -30,8 +67,15 @@ bool led_strip_init(led_strip_t *dev, PIO pio, uint32_t sm, uint32_t pin, uint32
     dev->pin = pin;
     dev->num_px = num_px;
 
+    dev->rgb = calloc(num_px, sizeof(uint32_t));
     dev->pixels = calloc(num_px, sizeof(uint32_t));
-    if(!dev->pixels){ return false; } //in case buffer not allocated
+    dev->tx = calloc(num_px, sizeof(uint32_t));
+    if(!dev->rgb || !dev->pixels || !dev->tx){ return false; } //in case buffer not allocated
+    dev->dither = false;
+    dev->frame = 0;
+    dev->dma_chan = -1;
+    dev->busy = false;
+    led_color_init();
 
     uint32_t offset = pio_add_program(pio, &ws2812_program);
 
@@ -44,44 +88,111 @@ bool led_strip_init(led_strip_t *dev, PIO pio, uint32_t sm, uint32_t pin, uint32
         false    // RGB (not RGBW)
     );
 
+    //dma completion irq goes on this core, once; show_async may then run on either core (led_anim's alarm is on core1)
+    if (!dma_irq_installed) {
+        irq_add_shared_handler(DMA_IRQ_0, led_strip_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_0, true);
+        dma_irq_installed = true;
+    }
+
     // Start with LEDs off
     led_strip_fill_rgb(dev, 0, 0, 0);
     return true;
 }
 
-void led_strip_fill_rgb(const led_strip_t *dev, uint8_t r, uint8_t g, uint8_t b) {
+void led_strip_fill_rgb(led_strip_t *dev, uint8_t r, uint8_t g, uint8_t b) {
     if (!dev) return;
-    uint32_t grb = rgb_to_grb(r, g, b);
+    uint32_t rgb = pack_rgb(r, g, b);
+    uint32_t word = render(rgb, LED_COLOR_NO_DITHER);
     for (uint32_t i = 0; i < dev->num_px; i++) {
-        dev->pixels[i] = grb;
+        dev->rgb[i] = rgb;
+        dev->pixels[i] = word;
     }
 }
 
 void led_strip_set_rgb(led_strip_t *dev, uint index, uint8_t r, uint8_t g, uint8_t b){
     if (!dev || index >= dev->num_px) return;
-    dev->pixels[index] = rgb_to_grb(r, g, b);
+    dev->rgb[index] = pack_rgb(r, g, b);
+    dev->pixels[index] = render(dev->rgb[index], LED_COLOR_NO_DITHER);
 }
 
-void led_strip_set_buffer_rgb(const led_strip_t *dev, uint32_t (*buffer)[3], uint32_t len){
-    if (!dev || sizeof(buffer)/sizeof(buffer[0]) >= dev->num_px) return;
+void led_strip_set_buffer_rgb(led_strip_t *dev, uint32_t (*buffer)[3], uint32_t len){
+    if (!dev || !buffer) return;
+    if (len > dev->num_px) len = dev->num_px;
 
-    for(int i = 0; i < len; i++){
-        dev->pixels[i] = rgb_to_grb(buffer[i][0],buffer[i][1],buffer[i][2]);
+    for(uint32_t i = 0; i < len; i++){
+        dev->rgb[i] = pack_rgb((uint8_t)buffer[i][0], (uint8_t)buffer[i][1], (uint8_t)buffer[i][2]);
+        dev->pixels[i] = render(dev->rgb[i], LED_COLOR_NO_DITHER);
     }
 }
 
-void led_strip_show(const led_strip_t *dev) {
+void led_strip_set_brightness(led_strip_t *dev, uint8_t level) {
+    led_color_set_brightness(level);
+    if (dev) render_all(dev);
+}
+
+void led_strip_set_dither(led_strip_t *dev, bool on) {
     if (!dev) return;
+    dev->dither = on;
+    render_all(dev);
+}
 
-    for (uint i = 0; i < dev->num_px; i++) {
+bool led_strip_show_async(led_strip_t *dev) {
+    if (!dev || dev->busy) return false;
+
+    if (dev->dma_chan < 0) {
+        dev->dma_chan = dma_claim_unused_channel(false);
+        if (dev->dma_chan < 0) return false; //no free channel; led_strip_show still works
+    }
+
+    if (dev->dither) {
+        dev->frame++;
+        render_all(dev);
+    }
+    memcpy(dev->tx, dev->pixels, dev->num_px * sizeof(uint32_t)); //pixels is free for the next frame from here on
+
+    dma_channel_config cfg = dma_channel_get_default_config((uint)dev->dma_chan);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&cfg, true);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_dreq(&cfg, pio_get_dreq(dev->pio, dev->sm, true)); //paced by pio tx fifo space
+
+    dev->busy = true;
+    dma_owner[dev->dma_chan] = dev;
+    __compiler_memory_barrier(); //owner visible to the irq, possibly on the other core, before the channel starts
+    dma_channel_set_irq0_enabled((uint)dev->dma_chan, true);
+    dma_channel_configure((uint)dev->dma_chan, &cfg, &dev->pio->txf[dev->sm], dev->tx, dev->num_px, true);
+    return true;
+}
+
+bool led_strip_ready(const led_strip_t *dev) {
+    return dev && !dev->busy;
+}
+
+void led_strip_show(led_strip_t *dev) {
+    if (!dev) return;
+    while (dev->busy) tight_loop_contents(); //let an async frame finish first
+
+    if (led_strip_show_async(dev)) {
+        while (dev->busy) tight_loop_contents();
+        return;
+    }
+
+    if (dev->dither) {
+        dev->frame++;
+        render_all(dev);
+    }
+
+    for (uint i = 0; i < dev->num_px; i++) { //no dma channel; push by hand
         put_pixel(dev, dev->pixels[i]); // pushes buffer data to hardware
     }
-    sleep_us(80);
+    sleep_us(WS2812_RESET_US);
 }
 
-void led_strip_clear(const led_strip_t *dev) {
+void led_strip_clear(led_strip_t *dev) {
     if (!dev) return;
     for (uint i = 0; i < dev->num_px; i++) {
+        dev->rgb[i] = 0;
         dev->pixels[i] = 0;
     }
 }
\ No newline at end of file
@@ -4,28 +4,52 @@
 #include <stdint.h>
 #include "hardware/pio.h"
 
+#define WS2812_RESET_US 80 //line held low this long latches the frame
+#define WS2812_WORD_US 30 //24 bits at 800 kHz
+
 typedef struct {
     PIO pio;          // pio0 or pio1
     uint32_t sm;          // state machine index 0..3
     uint32_t pin;         // data GPIO
     uint32_t num_px;       // number of LEDs
 
-    uint32_t *pixels; //buffer
+    uint32_t *rgb; //source colors 0x00RRGGBB, kept so brightness changes and dithering can re-render
+    uint32_t *pixels; //rendered buffer; each entry is grb << 8, the word the pio program shifts out
+    bool dither; //re-render with the next temporal dither step on every show
+    uint32_t frame;
+
+    //async show; tx is the frame being streamed so pixels can be changed meanwhile
+    uint32_t *tx;
+    int dma_chan; //-1 until the first async show claims one
+    volatile bool busy; //set until the frame is out and the latch time has passed
 } led_strip_t;
 
-//init using pio program and state machine with given params
+//init using pio program and state machine with given params; the dma completion irq for async shows is
+//enabled on the calling core (core0 in main.c), whichever core later calls led_strip_show_async
 bool led_strip_init(led_strip_t *dev, PIO pio, uint32_t sm, uint32_t pin, uint32_t count); 
 
 //fill strip with one color
-void led_strip_fill_rgb(const led_strip_t *dev, uint8_t r, uint8_t g, uint8_t b);
+void led_strip_fill_rgb(led_strip_t *dev, uint8_t r, uint8_t g, uint8_t b);
 
 //set one pixel's color in buffer
 void led_strip_set_rgb(led_strip_t *dev, uint index, uint8_t r, uint8_t g, uint8_t b);
 
-void led_strip_set_buffer_rgb(const led_strip_t *dev, uint32_t (*buffer)[3], uint32_t len);
+void led_strip_set_buffer_rgb(led_strip_t *dev, uint32_t (*buffer)[3], uint32_t len);
+
+//show current buffer; blocks until the frame is latched
+void led_strip_show(led_strip_t *dev);
+
+//starts streaming the current buffer to the pio over dma and returns; false if the last frame isn't done
+bool led_strip_show_async(led_strip_t *dev);
+
+//true once the last frame is out and latched; a new one can be shown
+bool led_strip_ready(const led_strip_t *dev);
+
+//rebuilds the shared gamma/brightness lut and re-renders this strip; 255 = full
+void led_strip_set_brightness(led_strip_t *dev, uint8_t level);
 
-//show current buffer
-void led_strip_show(const led_strip_t *dev);
+//temporal dithering keeps dim fades from stepping; best with frequent shows
+void led_strip_set_dither(led_strip_t *dev, bool on);
 
 //clear buffer
-void led_strip_clear(const led_strip_t *dev);
\ No newline at end of file
+void led_strip_clear(led_strip_t *dev);
@@ -0,0 +1,174 @@
+#include "ws2812_parallel.h"
+#include "ws2812.h"
+#include "led_color.h"
+#include "ws2812.pio.h"
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+//8x8 bit matrix transpose (hacker's delight 7-3), rows[s] is strip s's byte
+//out[k] gets bit (7 - k) of every strip, strip s in bit s, msb first like the wire
+static inline void transpose8(const uint8_t rows[8], uint32_t *out) {
+    //strip 7 goes in the top byte so strip s lands in bit s of each output byte
+    uint32_t x = ((uint32_t)rows[7] << 24) | ((uint32_t)rows[6] << 16) | ((uint32_t)rows[5] << 8) | rows[4];
+    uint32_t y = ((uint32_t)rows[3] << 24) | ((uint32_t)rows[2] << 16) | ((uint32_t)rows[1] << 8) | rows[0];
+    uint32_t t;
+
+    //swap 1x1 blocks within 2x2, then 2x2 within 4x4, then 4x4 halves
+    t = (x ^ (x >> 7)) & 0x00AA00AA;  x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00AA00AA;  y = y ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC; x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000CCCC; y = y ^ t ^ (t << 14);
+    t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+    y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+    x = t;
+
+    out[0] = x >> 24;
+    out[1] = (x >> 16) & 0xFF;
+    out[2] = (x >> 8) & 0xFF;
+    out[3] = x & 0xFF;
+    out[4] = y >> 24;
+    out[5] = (y >> 16) & 0xFF;
+    out[6] = (y >> 8) & 0xFF;
+    out[7] = y & 0xFF;
+}
+
+//one pixel index across all strips -> 24 words, g then r then b
+static void transpose_pixel(const led_parallel_t *dev, uint32_t index, uint32_t *out) {
+    uint8_t g[8] = {0}, r[8] = {0}, b[8] = {0}; //unused strips stay dark
+
+    for (uint32_t s = 0; s < dev->num_strips; s++) {
+        uint32_t grb = dev->pixels[s * dev->num_px + index];
+        g[s] = (uint8_t)(grb >> 16);
+        r[s] = (uint8_t)(grb >> 8);
+        b[s] = (uint8_t)grb;
+    }
+    transpose8(g, out);
+    transpose8(r, out + 8);
+    transpose8(b, out + 16);
+}
+
+//same scheme as the single strip driver: dma done -> alarm covers fifo drain + reset time
+static led_parallel_t *dma_owner[NUM_DMA_CHANNELS];
+static bool dma_irq_installed = false;
+
+static int64_t led_parallel_latch_done(alarm_id_t id, void *user_data) {
+    led_parallel_t *dev = (led_parallel_t *)user_data;
+    dev->busy = false;
+    return 0;
+}
+
+static void led_parallel_dma_irq_handler(void) {
+    for (uint ch = 0; ch < NUM_DMA_CHANNELS; ch++) {
+        led_parallel_t *dev = dma_owner[ch];
+        if (!dev || !dma_channel_get_irq0_status(ch)) continue;
+
+        dma_channel_acknowledge_irq0(ch);
+        dma_owner[ch] = NULL;
+
+        //each word here is a single bit time, 1/24 of a pixel
+        uint32_t words_left = pio_sm_get_tx_fifo_level(dev->pio, dev->sm) + 1;
+        uint32_t wait_us = (words_left * WS2812_WORD_US + WS2812_PARALLEL_WORDS_PER_PX - 1) / WS2812_PARALLEL_WORDS_PER_PX + WS2812_RESET_US;
+        if (add_alarm_in_us(wait_us, led_parallel_latch_done, dev, true) < 0) {
+            dev->busy = false;
+        }
+    }
+}
+
+bool led_parallel_init(led_parallel_t *dev, PIO pio, uint32_t sm, uint32_t pin_base, uint32_t num_strips, uint32_t num_px) {
+    if (!dev || num_strips == 0 || num_strips > WS2812_PARALLEL_MAX_STRIPS) return false;
+
+    dev->pio = pio;
+    dev->sm = sm;
+    dev->pin_base = pin_base;
+    dev->num_strips = num_strips;
+    dev->num_px = num_px;
+
+    dev->pixels = calloc(num_strips * num_px, sizeof(uint32_t));
+    dev->planes = calloc(num_px * WS2812_PARALLEL_WORDS_PER_PX, sizeof(uint32_t));
+    if (!dev->pixels || !dev->planes) { return false; }
+    dev->dma_chan = -1;
+    dev->busy = false;
+    led_color_init();
+
+    uint32_t offset = pio_add_program(pio, &ws2812_parallel_program);
+    ws2812_parallel_program_init(pio, sm, offset, pin_base, num_strips, 800000);
+
+    //as led_strip_init: irq on this core, once, not from whichever core shows first
+    if (!dma_irq_installed) {
+        irq_add_shared_handler(DMA_IRQ_0, led_parallel_dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_0, true);
+        dma_irq_installed = true;
+    }
+    return true;
+}
+
+void led_parallel_set_rgb(led_parallel_t *dev, uint32_t strip, uint32_t index, uint8_t r, uint8_t g, uint8_t b) {
+    if (!dev || strip >= dev->num_strips || index >= dev->num_px) return;
+    dev->pixels[strip * dev->num_px + index] = led_color_to_grb(r, g, b, LED_COLOR_NO_DITHER);
+}
+
+void led_parallel_fill_rgb(led_parallel_t *dev, uint32_t strip, uint8_t r, uint8_t g, uint8_t b) {
+    if (!dev || strip >= dev->num_strips) return;
+    uint32_t grb = led_color_to_grb(r, g, b, LED_COLOR_NO_DITHER);
+    for (uint32_t i = 0; i < dev->num_px; i++) {
+        dev->pixels[strip * dev->num_px + i] = grb;
+    }
+}
+
+void led_parallel_clear(led_parallel_t *dev) {
+    if (!dev) return;
+    memset(dev->pixels, 0, dev->num_strips * dev->num_px * sizeof(uint32_t));
+}
+
+bool led_parallel_show_async(led_parallel_t *dev) {
+    if (!dev || dev->busy) return false;
+
+    if (dev->dma_chan < 0) {
+        dev->dma_chan = dma_claim_unused_channel(false);
+        if (dev->dma_chan < 0) return false;
+    }
+
+    for (uint32_t i = 0; i < dev->num_px; i++) {
+        transpose_pixel(dev, i, &dev->planes[i * WS2812_PARALLEL_WORDS_PER_PX]);
+    }
+
+    dma_channel_config cfg = dma_channel_get_default_config((uint)dev->dma_chan);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&cfg, true);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_dreq(&cfg, pio_get_dreq(dev->pio, dev->sm, true));
+
+    dev->busy = true;
+    dma_owner[dev->dma_chan] = dev;
+    __compiler_memory_barrier(); //the irq may run on the other core
+    dma_channel_set_irq0_enabled((uint)dev->dma_chan, true);
+    dma_channel_configure((uint)dev->dma_chan, &cfg, &dev->pio->txf[dev->sm], dev->planes,
+                          dev->num_px * WS2812_PARALLEL_WORDS_PER_PX, true);
+    return true;
+}
+
+bool led_parallel_ready(const led_parallel_t *dev) {
+    return dev && !dev->busy;
+}
+
+void led_parallel_show(led_parallel_t *dev) {
+    if (!dev) return;
+    while (dev->busy) tight_loop_contents();
+
+    if (led_parallel_show_async(dev)) {
+        while (dev->busy) tight_loop_contents();
+        return;
+    }
+
+    for (uint32_t i = 0; i < dev->num_px; i++) { //no dma channel; push by hand
+        uint32_t words[WS2812_PARALLEL_WORDS_PER_PX];
+        transpose_pixel(dev, i, words);
+        for (uint32_t k = 0; k < WS2812_PARALLEL_WORDS_PER_PX; k++) {
+            pio_sm_put_blocking(dev->pio, dev->sm, words[k]);
+        }
+    }
+    sleep_us(WS2812_RESET_US);
+}
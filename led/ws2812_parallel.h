@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "hardware/pio.h"
+
+#define WS2812_PARALLEL_MAX_STRIPS 8
+#define WS2812_PARALLEL_WORDS_PER_PX 24 //one pio word per bit time, all strips at once
+
+//up to 8 strips of equal length on consecutive pins, driven by one state machine
+typedef struct {
+    PIO pio;
+    uint32_t sm;
+    uint32_t pin_base;    // strip s is on pin_base + s
+    uint32_t num_strips;
+    uint32_t num_px;      // pixels per strip
+
+    uint32_t *pixels; //num_strips * num_px, strip-major, 0x00GGRRBB
+    uint32_t *planes; //num_px * 24 transposed words; what the dma streams
+
+    int dma_chan; //-1 until the first async show claims one
+    volatile bool busy;
+} led_parallel_t;
+
+//init using the ws2812_parallel pio program; enables the dma completion irq on the calling core
+bool led_parallel_init(led_parallel_t *dev, PIO pio, uint32_t sm, uint32_t pin_base, uint32_t num_strips, uint32_t num_px);
+
+void led_parallel_set_rgb(led_parallel_t *dev, uint32_t strip, uint32_t index, uint8_t r, uint8_t g, uint8_t b);
+
+//fill one strip with one color
+void led_parallel_fill_rgb(led_parallel_t *dev, uint32_t strip, uint8_t r, uint8_t g, uint8_t b);
+
+//clear every strip
+void led_parallel_clear(led_parallel_t *dev);
+
+//transposes the buffer and streams it over dma; false if the last frame isn't done
+bool led_parallel_show_async(led_parallel_t *dev);
+
+//blocks until the frame is latched
+void led_parallel_show(led_parallel_t *dev);
+
+bool led_parallel_ready(const led_parallel_t *dev);
@@ -27,13 +27,32 @@ REMINDERS:
 #include "hardware/gpio.h"
 #include "hardware/pio.h"
 #include "ws2812.h"
+#include "led_anim.h"
 
 //drivers and custom modules
 #include "i2c_bus.h"
+#include "i2c_queue_rp2040.h"
 #include "aht20.h"
 #include "veml7700.h"
 #include "ssd1306.h"
 #include "pec11r.h"
+#include "ui.h"
+#include "font_atlas.h"
+#include "sched.h"
+#include "sched_pico.h"
+#include "readings.h"
+#include "fmt.h"
+#include "tsdb.h"
+#include "flash_rp2040.h"
+#include "flash_log.h"
+#include "telemetry.h"
+#if GREENEYE_BENCH
+#include "bench.h"
+#endif
+#if GREENEYE_DUAL_CORE
+#include "pico/multicore.h"
+#include "pico/flash.h"
+#endif
 
 //default i2c settings
 #define I2C_PORT i2c0
@@ -44,6 +63,16 @@ REMINDERS:
 #define WS2812_PIN 9
 #define WS2812_NUM_PIXELS 8
 #define WS2812_SM 0
+#define LED_FADE_MS 400 //bar graph transition time
+
+//boot; fast boot drops the serial terminal wait and the oled lamp test
+#if GREENEYE_FAST_BOOT
+#define USB_ATTACH_WAIT_MS 0
+#define OLED_FLASH_MS 0
+#else
+#define USB_ATTACH_WAIT_MS 2000 //time to open a serial terminal before the first prints
+#define OLED_FLASH_MS 500 //all-white lamp test
+#endif
 
 //define LED strip used colors
 #define RED {255,0,0}
@@ -59,139 +88,506 @@ static const i2c_bus_t BUS0 = {
     .freq_hz = 100 * 1000
 };
 
+//which of the expected parts answered at boot; absent ones are skipped instead of failing every poll
+typedef struct {
+    bool aht20;
+    bool veml7700;
+    uint8_t oled_addr; //0 if neither 0x3C nor 0x3D answered
+} inventory_t;
+static inventory_t inv;
+
 //declare peripherals
 aht20_t aht;
 veml7700_t veml;
 ssd1306_t oled;
+ui_t ui;
 pec11r_t enc;
 led_strip_t strip;
+led_anim_t anim;
+sched_t sched;
+#if GREENEYE_DUAL_CORE
+sched_t render_sched; //core1's scheduler
+#endif
+
+//task periods; each subsystem runs at its own rate instead of the slowest one's
+#define SENSOR_PERIOD_US (500 * 1000)
+#define DISPLAY_PERIOD_US (250 * 1000)
+#define ENCODER_PERIOD_US (20 * 1000)
+#define LED_PERIOD_US (1000 * 1000)
+#define REPORT_PERIOD_US (10 * 1000 * 1000)
+#define LOG_PERIOD_US (60 * 1000 * 1000)
+#define CONSOLE_PERIOD_US (100 * 1000)
+
+//flash kept for the log; 20-byte records, 11 per page: about a week at one record a minute before the oldest is erased
+#define FLASH_LOG_MAX_BYTES (256 * 1024)
+
+//readings go from sensor_task to the render side through a lock-free snapshot, so either side can run on either core
+static readings_snapshot_t shared_readings;
+static readings_t sensed; //sensor_task's working copy
+static char *plantname = "PLANTNAME";
+
+//every i2c0 transfer goes through this queue: sensor reads at high priority slip in between oled flush chunks
+static i2c_queue_t bus0_queue;
+
+//trend history, appended by sensor_task; core0 only (sensor + report tasks)
+static tsdb_series_t hist_temp, hist_hum, hist_lux;
+
+//persistent history in the spare flash after the image; one record per LOG_PERIOD_US
+static flash_dev_t flash;
+static flash_log_t flog;
+static bool flog_ok = false;
+static uint32_t boot_count; //one more than the newest record's; 0 on a blank log
+
+typedef struct { //flash log record
+    uint32_t boot; //uptime_s restarts at every reset; boot tells the runs apart
+    uint32_t uptime_s;
+    int32_t temp_cc;
+    int32_t humidity_cp;
+    int32_t lux_mlux;
+} log_record_t;
+
+//usb output: text log (default) or binary telemetry frames (tools/telemetry_decode.py); 'b'/'t' on stdin switches
+static volatile bool telemetry_binary = GREENEYE_TELEMETRY_BINARY;
+static telem_t telem;
+
+static int name_label, hum_label, temp_label, lux_label, score_label;
+static int enc_pos = 0;
+
+//polls both sensors without blocking; each keeps its last value while a measurement is in progress
+static void sensor_task(void *ctx){
+    //------- VEML7700 CODE --------
+
+    //autorange reconfigures in one jump and reports SETTLING for one integration time instead of sleeping
+    char logstr[48];
+    fmt_t log;
+    uint32_t now_s = (uint32_t)(time_us_64() / 1000000);
+    bool fresh = false;
+    if (inv.veml7700) { //a part missing at boot stays READING_NONE instead of reporting an error every pass
+        veml7700_ar_status_t lux_status = veml7700_autorange_poll_mlux(&veml, &sensed.lux_mlux);
+        if(lux_status == VEML7700_AR_READY){
+            fmt_init(&log, logstr, sizeof(logstr));
+            fmt_value(&log, sensed.lux_mlux, 3, 1, " lx");
+            if (!telemetry_binary) printf("\nLux: %s", logstr);
+            tsdb_append(&hist_lux, now_s, sensed.lux_mlux / 1000); //whole lux; mlux noise would just cost bytes
+            sensed.lux_state = READING_OK;
+            fresh = true;
+        }
+        else if(lux_status == VEML7700_AR_ERROR){
+            if (!telemetry_binary) printf("\nVEML7700 lux read failed");
+            sensed.lux_state = READING_ERR;
+        }
+    }
 
-int main() {
+    //-----------------------------------
+    
+    
+    //--------- AHT20 CODE ---------
+
+    //measurement was triggered last pass and converted in the background
+    if (inv.aht20) {
+        aht20_status_t aht_status = aht20_poll(&aht);
+        if (aht_status == AHT20_READY && aht20_fetch_fixed(&aht, &sensed.temp_cc, &sensed.humidity_cp)) {
+            fmt_init(&log, logstr, sizeof(logstr));
+            fmt_str(&log, "Temp: ");
+            fmt_value(&log, sensed.temp_cc, 2, 1, " C   RH: ");
+            fmt_value(&log, sensed.humidity_cp, 2, 1, " %");
+            if (!telemetry_binary) printf("\n%s\n", logstr);
+            tsdb_append(&hist_temp, now_s, sensed.temp_cc);
+            tsdb_append(&hist_hum, now_s, sensed.humidity_cp);
+            sensed.climate_state = READING_OK;
+            fresh = true;
+        } else if (aht_status == AHT20_READY || aht_status == AHT20_ERROR) { //bus or crc error
+            if (!telemetry_binary) printf("AHT20 read failed\n");
+            sensed.climate_state = READING_ERR;
+        }
+        if (aht_status != AHT20_BUSY) { //idle (nothing triggered yet) just starts one; no reading is lost
+            aht20_trigger(&aht); //start the next conversion so it is ready by the next run
+        }
+    }
 
-    stdio_init_all();
-    sleep_ms(2000);
+    static bool first_reported = false;
+    if (fresh && !first_reported) { //timer starts at reset, so this is power-on to first valid reading
+        printf("\nboot: first valid reading after %lu ms\n", (unsigned long)(time_us_64() / 1000));
+        first_reported = true;
+    }
 
-    //init i2c
-    i2c_bus_init(&BUS0);
-    int num_devices = i2c_bus_scan(&BUS0); //make sure there's devices on the bus
-    if(num_devices == 0){printf("No devices found"); exit(1);}
+    //-----------------------------------
+    
 
-    //init and config sensors, wifi, screen, encoder
-    aht20_init(&aht, BUS0.port);
+    //-------- CALCULATE SCORE ----------
 
-    veml7700_init(&veml, BUS0.port);
-    if(!veml7700_config(&veml, GAIN_1x, ITIME_100MS)){
-        printf("VEML7700 config failed");
-    }
+    
+    //do some math here with temp, humidity, lux, and plant presets to determine an /10 score
+    
 
-    printf("%d", ssd1306_init(&oled, BUS0.port, SSD1306_ADDR_0x3C));
+    sensed.score = 4; //placeholder value
 
-    if (cyw43_arch_init() != 0) {
-        // WiFi chip init failed -> LED control, bluetooth won't work
-        printf("Wifi chip init failed");
-    }
+    //----------------------------------
 
-    pec11r_init(&enc, 6, 7, 8); //gpios 6,7 for rotary, gpio 8 for switch
-    int enc_pos = 0;
+    readings_publish(&shared_readings, &sensed);
 
-    if(!led_strip_init(&strip, pio0, WS2812_SM, WS2812_PIN, WS2812_NUM_PIXELS)){
-        printf("LED strip (PIO) init failed");
+    if (telemetry_binary && fresh) {
+        telem_sample_t sample = {
+            .uptime_ms = (uint32_t)(time_us_64() / 1000),
+            .temp_cc = sensed.temp_cc,
+            .humidity_cp = sensed.humidity_cp,
+            .lux_mlux = sensed.lux_mlux,
+            .score = (uint8_t)sensed.score,
+            .flags = (uint8_t)(sensed.lux_state | (sensed.climate_state << 2))
+        };
+        telem_push(&telem, &sample); //goes out TELEM_BATCH samples per frame
     }
+}
 
+//formats the latest readings and pushes changed labels to the oled
+static void display_task(void *ctx){
+    if (!inv.oled_addr) return;
+
+    readings_t r;
+    readings_read(&shared_readings, &r);
+
+    //integer formatting straight into the label buffers; no float printf on the render path
+    char luxstr[32], tempstr[32], humstr[32], scorestr[32];
+    fmt_t f;
+    fmt_init(&f, luxstr, sizeof(luxstr));
+    if (r.lux_state == READING_OK) {
 
-    while (true) {
         
-        //--------- MAIN CODE ----------
+        //do some calculations based on plant preset here
+        //determine qualitative test for string
+        
 
-        char *plantname = "PLANTNAME";
+        fmt_str(&f, "Too dark: ");
+        fmt_value(&f, r.lux_mlux, 3, 0, " lx");
+    }
+    else {
+        fmt_str(&f, (r.lux_state == READING_ERR) ? "LUX READ ERR" : "Measuring...");
+    }
 
-        //------- VEML7700 CODE --------
+    fmt_t t, h;
+    fmt_init(&t, tempstr, sizeof(tempstr));
+    fmt_init(&h, humstr, sizeof(humstr));
+    if (r.climate_state == READING_OK) {
 
-        uint16_t raw_counts;
-        char luxstr[32];
-        if(veml7700_read_counts(&veml, &raw_counts)){
-            printf("\nRaw: %u", raw_counts);
-        }
-        else{
-            printf("\nVEML7700 count read failed");
+        
+        //do some calculations based on plant preset here
+        //determine qualitative text for strings
+        
+       
+        fmt_str(&t, "Too cold: ");
+        fmt_value(&t, r.temp_cc, 2, 1, " C");
+        fmt_str(&h, "Too humid: ");
+        fmt_value(&h, r.humidity_cp, 2, 1, "%");
+    }
+    else {
+        const char *msg = (r.climate_state == READING_ERR) ? "HUM/TEMP ERR" : "Measuring...";
+        fmt_str(&t, msg);
+        fmt_str(&h, msg);
+    }
+    fmt_init(&f, scorestr, sizeof(scorestr));
+    fmt_str(&f, "Score: ");
+    fmt_int(&f, r.score, 0);
+    fmt_str(&f, "/10");
+
+    ui_label_set(&ui, name_label, plantname);
+    ui_label_set(&ui, hum_label, humstr);
+    ui_label_set(&ui, temp_label, tempstr);
+    ui_label_set(&ui, lux_label, luxstr);
+    ui_label_set(&ui, score_label, scorestr);
+
+    uint32_t redrawn = ui_render(&ui); //only labels whose text changed get re-rasterized
+    if (redrawn == 0 && oled.dirty_pages == 0) return; //nothing changed and nothing left over from a busy flush
+
+    //only the changed window goes out, in chunks from the i2c irq; a frame still in flight leaves this one dirty for next time
+    bool queued = ssd1306_show_queued(&oled, &bus0_queue, NULL, NULL);
+    if (!telemetry_binary) printf("\nUI redrawn: 0x%02lX, OLED flush %s", (unsigned long)redrawn, queued ? "queued" : "deferred");
+}
+
+//drains encoder events; edges are decoded in the gpio irq, so this can run slowly without losing any
+static void encoder_task(void *ctx){
+    pec11r_event_t evt;
+    while (pec11r_event_pop(&enc, &evt)) {
+        if (evt == PEC11R_EVT_PRESS) {
+            printf("button pressed");
+            continue;
         }
+        enc_pos = pec11r_position(&enc);
+        printf("pos=%d\n", enc_pos);
+    }
+}
 
-        float lux;
-        if(veml7700_read_lux_autorange(&veml, &lux)){
-            printf("\nLux: %f", lux);
+//shows the score as a bar graph: green/yellow/red by score, length by score
+static void led_task(void *ctx){
+    readings_t r;
+    readings_read(&shared_readings, &r);
+    int score = r.score;
 
-            
-            //do some calculations based on plant preset here
-            //determine qualitative test for string
-            
+    const uint8_t bar[3][3] = {RED, YELLOW, GREEN};
+    const uint8_t *color = bar[(score >= 7) ? 2 : (score >= 4) ? 1 : 0];
+    uint32_t lit = (uint32_t)(score * WS2812_NUM_PIXELS + 9) / 10;
 
-            snprintf(luxstr, sizeof(luxstr), "Too dark: %.0f lx", lux);
-        }
-        else{
-            printf("\nVEML7700 lux read failed");
-            snprintf(luxstr, sizeof(luxstr), "LUX READ ERR", lux);
-        }
+    //frames are rendered from the animation timer; this only moves the targets. a bad score breathes
+    led_anim_bar(&anim, lit, color[0], color[1], color[2], LED_FADE_MS, score < 4);
+}
 
-        //-----------------------------------
-        
-        
-        //--------- AHT20 CODE ---------
-
-        float temp, humidity;
-        char tempstr[32], humstr[32];
-
-        if (aht20_read(&aht, &temp, &humidity)) {
-            printf("\nTemp: %.1f C   RH: %.1f %%\n", temp, humidity);
-
-            
-            //do some calculations based on plant preset here
-            //determine qualitative text for strings
-            
-           
-            snprintf(tempstr, sizeof(tempstr), "Too cold: %.1f C", temp);
-            snprintf(humstr, sizeof(humstr), "Too humid: %.1f%%", humidity);
-
-        } else {
-            printf("AHT20 read failed\n");
-            snprintf(tempstr, sizeof(tempstr), "HUM/TEMP ERR");
-            snprintf(humstr, sizeof(humstr), "HUM/TEMP ERR");
+//appends the latest readings to the flash log; a page is programmed every ~13 records
+static void log_task(void *ctx){
+    if (!flog_ok || sensed.climate_state != READING_OK) return;
+
+    log_record_t rec = {
+        .boot = boot_count,
+        .uptime_s = (uint32_t)(time_us_64() / 1000000),
+        .temp_cc = sensed.temp_cc,
+        .humidity_cp = sensed.humidity_cp,
+        .lux_mlux = sensed.lux_mlux
+    };
+    if (!flash_log_append(&flog, &rec, sizeof(rec))) {
+        printf("flash log append failed\n");
+    }
+}
+
+//raw bytes, no crlf translation; binary frames contain 0x0A
+static void usb_write(const uint8_t *buf, uint32_t len, void *ctx){
+    for (uint32_t i = 0; i < len; i++) {
+        putchar_raw(buf[i]);
+    }
+}
+
+//single-key commands from the host: 'b' binary telemetry, 't' text log
+static void console_task(void *ctx){
+    int c;
+    while ((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT) {
+        if (c == 'b') {
+            telemetry_binary = true;
+        } else if (c == 't' && telemetry_binary) {
+            telem_flush(&telem); //don't strand a partial batch
+            telemetry_binary = false;
         }
+    }
+}
 
-        //-----------------------------------
-        
+//periodic timing report for every task
+static void report_task(void *ctx){
+    sched_report(&sched);
+    sched_reset_stats(&sched);
+    i2c_bus_stats_dump(); //display vs sensors: who holds the bus
+    i2c_bus_stats_reset();
+    i2c_queue_report(&bus0_queue); //max wait at high priority = worst sensor latency behind the oled
+    i2c_queue_reset_stats(&bus0_queue);
+    led_anim_report(&anim);
+    led_anim_reset_stats(&anim);
+    tsdb_report(&hist_temp, "temp");
+    tsdb_report(&hist_hum, "hum");
+    tsdb_report(&hist_lux, "lux");
+    if (flog_ok) flash_log_report(&flog);
+#if GREENEYE_DUAL_CORE
+    sched_report(&render_sched); //stats are read without a lock; fine for a report
+    sched_reset_stats(&render_sched);
+#endif
+}
 
-        //-------- CALCULATE SCORE ----------
+#if GREENEYE_DUAL_CORE
+//core1: rendering only; sleeps on the hardware timer between frames like core0
+static void core1_main(void){
+    flash_safe_execute_core_init(); //lets core0 park this core while it erases/programs the flash log
+    if(!led_anim_init(&anim, &strip, LED_ANIM_FPS)){ //frame irq lands on this core, next to the rest of the rendering
+        printf("LED animation timer failed");
+    }
+    sched_init(&render_sched, sched_pico_now, sched_pico_wait_until);
+    sched_add(&render_sched, "display", display_task, NULL, DISPLAY_PERIOD_US, 100 * 1000, 150 * 1000);
+    sched_add(&render_sched, "leds", led_task, NULL, LED_PERIOD_US, 0, 200 * 1000);
 
-        char scorestr[32];
-        int score;
+    while (true) {
+        sched_run_once(&render_sched);
+    }
+}
+#endif
+
+#if GREENEYE_BENCH
+//one-shot driver benchmarks at boot; everything runs single-threaded before the schedulers start
+static void bench_oled_full(void *ctx){ ssd1306_show(&oled); }
+
+static void bench_ui_score(void *ctx){ //one label changes, the usual display_task case
+    static uint32_t n = 0;
+    char s[32];
+    fmt_t f;
+    fmt_init(&f, s, sizeof(s));
+    fmt_str(&f, "Score: ");
+    fmt_int(&f, (int32_t)(n++ % 10), 0);
+    fmt_str(&f, "/10");
+    ui_label_set(&ui, score_label, s);
+    ui_render(&ui);
+}
 
-        
-        //do some math here with temp, humidity, lux, and plant presets to determine an /10 score
-        
+static void bench_oled_dirty(void *ctx){
+    bench_ui_score(ctx);
+    ssd1306_show_dirty(&oled, NULL);
+}
 
-       score = 4; //placeholder value
-       snprintf(scorestr, sizeof(scorestr), "Score: %d/10", score);
+static void bench_oled_queued(void *ctx){
+    bench_ui_score(ctx);
+    ssd1306_show_queued(&oled, &bus0_queue, NULL, NULL);
+    ssd1306_flush_wait(&oled);
+}
 
-       //----------------------------------
+static void bench_veml_read(void *ctx){ int32_t mlux; veml7700_read_mlux(&veml, &mlux); }
+static void bench_aht_read(void *ctx){ int32_t t, h; aht20_read_fixed(&aht, &t, &h); }
+static void bench_led_fill(void *ctx){ led_strip_fill_rgb(&strip, 255, 128, 0); }
+static void bench_led_show(void *ctx){ led_strip_show(&strip); }
+static void bench_fmt(void *ctx){ char s[32]; fmt_t f; fmt_init(&f, s, sizeof(s)); fmt_value(&f, 2347, 2, 1, " C"); }
+static void bench_sensor_task(void *ctx){ sensor_task(ctx); }
+
+static void bench_flash_scan(void *ctx){ //a full pass over the log, which boot no longer does
+    static flash_log_reader_t reader; //page buffer; keep it off the stack
+    log_record_t rec;
+    uint32_t n = 0;
+    flash_log_reader_init(&reader, &flog);
+    while (flash_log_read(&reader, &rec, sizeof(rec))) n++;
+    printf("flash log: %lu records, %lu corrupt pages skipped\n", (unsigned long)n, (unsigned long)reader.corrupt);
+}
+static void bench_display_task(void *ctx){ bench_ui_score(ctx); display_task(ctx); }
+
+//runs one case; traffic is everything the bus layer counted meanwhile, on any device
+static void bench_case(const char *name, bench_fn fn, uint32_t iters){
+    bench_result_t r;
+    i2c_bus_stats_reset();
+    bench_run(&r, name, fn, NULL, iters);
+
+    i2c_bus_stats_t snap;
+    i2c_bus_stats_snapshot(&snap);
+    for (uint8_t i = 0; i < snap.count; i++) {
+        r.transactions += snap.devs[i].transactions;
+        r.bytes += snap.devs[i].bytes;
+    }
+    bench_print(&r, &BUS0);
+}
 
+static void run_benchmarks(void){
+    bench_print_header();
+    if (inv.oled_addr) { //oled was never initialized otherwise
+        bench_case("oled full", bench_oled_full, 20);
+        bench_case("oled 1 label", bench_oled_dirty, 20);
+        bench_case("oled queued", bench_oled_queued, 20);
+    }
+    bench_case("ui render", bench_ui_score, 100);
+    bench_case("veml7700 read", bench_veml_read, 20);
+    bench_case("aht20 read", bench_aht_read, 3);
+    bench_case("led fill", bench_led_fill, 1000);
+    bench_case("led show", bench_led_show, 10);
+    bench_case("fmt value", bench_fmt, 1000);
+    bench_case("sensor_task", bench_sensor_task, 20);
+    bench_case("display_task", bench_display_task, 20);
+    if (flog_ok) bench_case("flash log scan", bench_flash_scan, 1);
+    i2c_bus_stats_reset();
+}
+#endif
 
-        //-------- PRINT TO OLED ---------
+//everything up to the first task release; host/test/bench_loop.c runs this against simulated parts
+static void boot(void) {
 
-        sleep_ms(1000);
-        ssd1306_clear_buffer(&oled);
-        ssd1306_draw_string(&oled, 0, 0, plantname, 2, TRUNCATE);
-        ssd1306_draw_string(&oled, 0,20, humstr, 1, TRUNCATE);
-        ssd1306_draw_string(&oled, 0,30, tempstr, 1, TRUNCATE);
-        ssd1306_draw_string(&oled, 0,40, luxstr, 1, TRUNCATE);
-        ssd1306_draw_string(&oled, 0, 50, scorestr, 1, TRUNCATE);
-        ssd1306_show(&oled);
+    stdio_init_all();
+    if (USB_ATTACH_WAIT_MS) sleep_ms(USB_ATTACH_WAIT_MS);
 
-        //---------------------------------
-        
+    //init i2c
+    i2c_bus_init(&BUS0);
+#if GREENEYE_I2C_SCAN
+    i2c_bus_scan(&BUS0); //wiring diagnostic only; the inventory below is what boot relies on
+#endif
+    //probe just the expected addresses instead of all 112
+    inv.aht20 = i2c_bus_probe(&BUS0, AHT20_ADDR);
+    inv.veml7700 = i2c_bus_probe(&BUS0, VEML7700_ADDR);
+    inv.oled_addr = i2c_bus_probe(&BUS0, SSD1306_ADDR_0x3C) ? SSD1306_ADDR_0x3C
+                  : i2c_bus_probe(&BUS0, SSD1306_ADDR_0x3D) ? SSD1306_ADDR_0x3D : 0;
+    printf("\ni2c: aht20 %s, veml7700 %s, oled %s\n", inv.aht20 ? "ok" : "missing", inv.veml7700 ? "ok" : "missing",
+        inv.oled_addr ? "ok" : "missing");
+    if(!inv.aht20 && !inv.veml7700 && !inv.oled_addr){printf("No devices found"); exit(1);}
+    i2c_queue_rp2040_init(&bus0_queue, BUS0.port); //i2c irq lands on core0, next to the sensors
+    i2c_bus_attach_queue(BUS0.port, &bus0_queue);
+
+    //init sensors, screen, wifi, encoder; nothing sleeps on a sensor, each driver tracks its own settle deadline
+    aht20_init(&aht, BUS0.port);
 
-        //---------------------------------
-        
+    veml7700_init(&veml, BUS0.port);
+    if(inv.veml7700 && !veml7700_config(&veml, GAIN_1x, ITIME_100MS)){ //first integration runs from here on
+        printf("VEML7700 config failed");
+    }
+
+    if(inv.oled_addr && !ssd1306_init(&oled, BUS0.port, inv.oled_addr, OLED_FLASH_MS)){
+        printf("OLED init failed");
+    }
+
+    //after the oled's full-frame clear the aht20's power-up time has usually passed; if not, its first poll sends this
+    if(inv.aht20) aht20_trigger(&aht); //first measurement converts while everything else initializes
+
+    //screen layout; rows sit on page boundaries so redraws are whole-byte copies
+    ui_init(&ui, &oled);
+    name_label = ui_label_add(&ui, 0, 0, &FONT_5X7_X2);
+    hum_label = ui_label_add(&ui, 0, 24, &FONT_5X7);
+    temp_label = ui_label_add(&ui, 0, 32, &FONT_5X7);
+    lux_label = ui_label_add(&ui, 0, 40, &FONT_5X7);
+    score_label = ui_label_add(&ui, 0, 56, &FONT_5X7);
 
+    if (cyw43_arch_init() != 0) {
+        // WiFi chip init failed -> LED control, bluetooth won't work
+        printf("Wifi chip init failed");
+    }
+
+    pec11r_init(&enc, 6, 7, 8); //gpios 6,7 for rotary, gpio 8 for switch
+    if(!pec11r_irq_enable(&enc)){
+        printf("Encoder irq decoding failed");
+    }
+
+    if(!led_strip_init(&strip, pio0, WS2812_SM, WS2812_PIN, WS2812_NUM_PIXELS)){
+        printf("LED strip (PIO) init failed");
+    }
+#if !GREENEYE_DUAL_CORE
+    if(!led_anim_init(&anim, &strip, LED_ANIM_FPS)){
+        printf("LED animation timer failed");
+    }
+#endif
+
+    readings_init(&shared_readings);
+    telem_init(&telem, usb_write, NULL);
+    tsdb_init(&hist_temp);
+    tsdb_init(&hist_hum);
+    tsdb_init(&hist_lux);
+
+    //recovery reads sector headers only; the boot counter comes from the newest record, at most two sectors back
+    flog_ok = flash_rp2040_init(&flash, FLASH_LOG_MAX_BYTES) && flash_log_init(&flog, &flash);
+    if (flog_ok) {
+        log_record_t last;
+        if (flash_log_last(&flog, &last, sizeof(last)) == sizeof(last)) boot_count = last.boot + 1;
+        printf("flash log: boot %lu\n", (unsigned long)boot_count);
+        flash_log_report(&flog);
+    } else {
+        printf("flash log init failed");
+    }
+#if GREENEYE_BENCH
+    run_benchmarks();
+#endif
+
+    printf("boot: init done after %lu ms\n", (unsigned long)(time_us_64() / 1000));
+
+    //tasks; offsets spread first releases so they don't all land on the same tick
+    sched_init(&sched, sched_pico_now, sched_pico_wait_until);
+    sched_add(&sched, "encoder", encoder_task, NULL, ENCODER_PERIOD_US, 0, 0);
+    sched_add(&sched, "sensors", sensor_task, NULL, SENSOR_PERIOD_US, 50 * 1000, 100 * 1000); //aht20 needs ~80 ms after the trigger above
+#if GREENEYE_DUAL_CORE
+    multicore_launch_core1(core1_main); //display + leds render on core1, so an oled flush never delays a sensor poll
+#else
+    sched_add(&sched, "display", display_task, NULL, DISPLAY_PERIOD_US, 100 * 1000, 150 * 1000);
+    sched_add(&sched, "leds", led_task, NULL, LED_PERIOD_US, 0, 200 * 1000);
+#endif
+    sched_add(&sched, "console", console_task, NULL, CONSOLE_PERIOD_US, 0, 0);
+    sched_add(&sched, "log", log_task, NULL, LOG_PERIOD_US, 0, LOG_PERIOD_US);
+    sched_add(&sched, "report", report_task, NULL, REPORT_PERIOD_US, 0, REPORT_PERIOD_US);
+}
+
+int main() {
+    boot();
+
+    while (true) {
+        sched_run_once(&sched); //sleeps on the hardware timer until the next task is due
     }
 }
 
@@ -0,0 +1,23 @@
+#include "font.h"
+#include <stddef.h>
+
+const uint8_t *font_glyph(const font_t *font, char c, uint8_t *width){
+    unsigned idx = (unsigned)(unsigned char)c - font->first;
+    if (idx >= font->count || font->widths[idx] == 0) { //not in this font
+        idx = (unsigned)font->fallback - font->first;
+    }
+    *width = font->widths[idx];
+    return &font->data[font->offsets[idx]];
+}
+
+int font_text_width(const font_t *font, const char *s){
+    if (!font || !s || !*s) return 0;
+
+    int w = 0;
+    for (const char *p = s; *p; p++) {
+        uint8_t gw;
+        font_glyph(font, *p, &gw);
+        w += gw + font->spacing;
+    }
+    return w - font->spacing;
+}
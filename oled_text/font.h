@@ -0,0 +1,25 @@
+#pragma once
+#include <stdint.h>
+
+/*
+  Bitmap font as emitted by gen_font_atlas.py (see oled_text/fonts/).
+  - Glyphs are stored page-major like ssd1306_t::buffer: (height+7)/8 pages of width bytes, bit 0 on top
+  - Each scale is its own font_t, so nothing is scaled at runtime
+*/
+typedef struct {
+    uint8_t first; //character code of glyph 0
+    uint8_t count; //number of glyphs in the table
+    uint8_t height; //pixel rows per glyph
+    uint8_t spacing; //blank columns after each glyph
+    uint8_t fallback; //character drawn for codes outside the table or missing from it
+
+    const uint8_t *widths; //pixel columns per glyph; 0 = not in this font
+    const uint16_t *offsets; //start of each glyph in data
+    const uint8_t *data; //all glyph bitmaps back to back
+} font_t;
+
+//returns the bitmap for c (or the fallback glyph) and its width in pixels
+const uint8_t *font_glyph(const font_t *font, char c, uint8_t *width);
+
+//pixel width of s when drawn with font, spacing included between glyphs but not after the last
+int font_text_width(const font_t *font, const char *s);
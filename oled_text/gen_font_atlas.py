@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+"""
+Font atlas generator (run by CMake at build time).
+
+Reads one or more ASCII-art font sources from oled_text/fonts/ and writes
+font_atlas.c/.h with every requested variant already scaled and laid out in
+the SSD1306's page-major format: each glyph is (height+7)/8 pages of
+<width> bytes, bit 0 of a byte = top row of that page. Drawing a glyph is
+then a straight ssd1306_blit of these bytes, no per-pixel work at runtime.
+
+usage: gen_font_atlas.py --out-dir DIR font.txt [font.txt ...]
+"""
+import argparse
+import os
+import sys
+
+
+def parse_font(path):
+    font = {"path": path, "height": None, "spacing": 1, "fallback": 0x20,
+            "variants": [], "glyphs": {}}
+    with open(path) as f:
+        lines = [l.rstrip("\n") for l in f]
+
+    i = 0
+    while i < len(lines):
+        line = lines[i].strip()
+        i += 1
+        if not line or line.startswith("#"):
+            continue
+        key, *args = line.split()
+        if key == "height":
+            font["height"] = int(args[0])
+        elif key == "spacing":
+            font["spacing"] = int(args[0])
+        elif key == "fallback":
+            font["fallback"] = int(args[0], 0)
+        elif key == "variant":
+            name, kind, *scales = args
+            if kind not in ("fixed", "proportional"):
+                sys.exit(f"{path}: unknown variant kind '{kind}'")
+            font["variants"].append((name, kind == "proportional", [int(s) for s in scales]))
+        elif key == "char":
+            if font["height"] is None:
+                sys.exit(f"{path}: 'height' must come before the first glyph")
+            code = int(args[0], 0)
+            rows = [lines[i + r].strip() for r in range(font["height"])]
+            i += font["height"]
+            if len({len(r) for r in rows}) != 1 or any(set(r) - set("#.") for r in rows):
+                sys.exit(f"{path}: glyph 0x{code:02X} rows must be equal length and only use '#' and '.'")
+            font["glyphs"][code] = rows
+        else:
+            sys.exit(f"{path}: unknown key '{key}'")
+
+    if not font["glyphs"] or not font["variants"]:
+        sys.exit(f"{path}: needs at least one glyph and one variant")
+    if font["fallback"] not in font["glyphs"]:
+        sys.exit(f"{path}: fallback glyph 0x{font['fallback']:02X} is not defined")
+    return font
+
+
+def trim(rows):
+    """Drop blank columns on both sides; blank glyphs (space) keep half their width."""
+    w = len(rows[0])
+    lit = [x for x in range(w) if any(r[x] == "#" for r in rows)]
+    if not lit:
+        return [r[:max(1, (w + 1) // 2)] for r in rows]
+    return [r[lit[0]:lit[-1] + 1] for r in rows]
+
+
+def to_pages(rows, scale):
+    """Scale a glyph and pack it page-major: one byte per column per 8-row page."""
+    h = len(rows) * scale
+    w = len(rows[0]) * scale
+    out = []
+    for page in range((h + 7) // 8):
+        for x in range(w):
+            b = 0
+            for bit in range(8):
+                y = page * 8 + bit
+                if y < h and rows[y // scale][x // scale] == "#":
+                    b |= 1 << bit
+            out.append(b)
+    return w, out
+
+
+def emit_variant(name, font, proportional, scale):
+    first = min(font["glyphs"])
+    last = max(font["glyphs"])
+    widths, offsets, data = [], [], []
+    for code in range(first, last + 1):
+        rows = font["glyphs"].get(code)
+        if rows is None:  # gap in the table; font_glyph() maps width 0 to the fallback glyph
+            widths.append(0)
+            offsets.append(0)
+            continue
+        if proportional:
+            rows = trim(rows)
+        w, bytes_ = to_pages(rows, scale)
+        widths.append(w)
+        offsets.append(len(data))
+        data.extend(bytes_)
+
+    if len(data) > 0xFFFF:
+        sys.exit(f"{name}: glyph data exceeds 16-bit offsets")
+
+    def table(ctype, values, per_line=16):
+        body = ",\n".join("    " + ", ".join(v for v in values[i:i + per_line])
+                          for i in range(0, len(values), per_line))
+        return f"{ctype}[{len(values)}] = {{\n{body}\n}};\n"
+
+    c = []
+    c.append(f"//{name}: {'proportional' if proportional else 'fixed'}, scale {scale}, "
+             f"{len(font['glyphs'][first]) * scale} px tall, {len(data)} bytes\n")
+    c.append(table(f"static const uint8_t {name}_data", [f"0x{b:02X}" for b in data]))
+    c.append(table(f"static const uint16_t {name}_offsets", [str(o) for o in offsets], 12))
+    c.append(table(f"static const uint8_t {name}_widths", [str(w) for w in widths]))
+    c.append(f"const font_t {name} = {{\n"
+             f"    .first = 0x{first:02X},\n"
+             f"    .count = {last - first + 1},\n"
+             f"    .height = {font['height'] * scale},\n"
+             f"    .spacing = {font['spacing'] * scale},\n"
+             f"    .fallback = 0x{font['fallback']:02X},\n"
+             f"    .widths = {name}_widths,\n"
+             f"    .offsets = {name}_offsets,\n"
+             f"    .data = {name}_data\n"
+             f"}};\n")
+    return "\n".join(c)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--out-dir", required=True)
+    ap.add_argument("fonts", nargs="+")
+    args = ap.parse_args()
+
+    names, bodies = [], []
+    for path in args.fonts:
+        font = parse_font(path)
+        for base, proportional, scales in font["variants"]:
+            for scale in scales:
+                name = base if scale == 1 else f"{base}_X{scale}"
+                names.append(name)
+                bodies.append(emit_variant(name, font, proportional, scale))
+
+    sources = ", ".join(os.path.basename(p) for p in args.fonts)
+    banner = f"//generated by gen_font_atlas.py from {sources}; do not edit\n"
+
+    os.makedirs(args.out_dir, exist_ok=True)
+    with open(os.path.join(args.out_dir, "font_atlas.h"), "w") as f:
+        f.write(banner + "#pragma once\n#include \"font.h\"\n\n")
+        f.write("".join(f"extern const font_t {n};\n" for n in names))
+    with open(os.path.join(args.out_dir, "font_atlas.c"), "w") as f:
+        f.write(banner + "#include \"font_atlas.h\"\n\n")
+        f.write("\n".join(bodies))
+
+
+if __name__ == "__main__":
+    main()
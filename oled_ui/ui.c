@@ -0,0 +1,64 @@
+#include "ui.h"
+#include <string.h>
+#include "ssd1306_gfx.h"
+
+void ui_init(ui_t *ui, ssd1306_t *oled){
+    ui->oled = oled;
+    ui->count = 0;
+    ui->redrawn = 0;
+}
+
+int ui_label_add(ui_t *ui, int x, int y, const font_t *font){
+    if (!ui || !font || ui->count >= UI_MAX_LABELS) return -1;
+
+    ui_label_t *label = &ui->labels[ui->count];
+    label->x = (int16_t)x;
+    label->y = (int16_t)y;
+    label->font = font;
+    label->text[0] = '\0';
+    label->drawn_w = 0;
+    label->changed = false; //empty label over an empty area; nothing to draw yet
+    return ui->count++;
+}
+
+bool ui_label_set(ui_t *ui, int id, const char *text){
+    if (!ui || id < 0 || id >= ui->count || !text) return false;
+
+    ui_label_t *label = &ui->labels[id];
+    if (strncmp(label->text, text, UI_LABEL_LEN - 1) == 0) return false; //same text, nothing to redraw
+
+    strncpy(label->text, text, UI_LABEL_LEN - 1);
+    label->text[UI_LABEL_LEN - 1] = '\0';
+    label->changed = true;
+    return true;
+}
+
+void ui_invalidate(ui_t *ui){
+    if (!ui) return;
+    for (int i = 0; i < ui->count; i++) {
+        ui->labels[i].drawn_w = 0; //buffer was wiped, nothing of the old text left to erase
+        ui->labels[i].changed = true;
+    }
+}
+
+uint32_t ui_render(ui_t *ui){
+    if (!ui) return 0;
+
+    ui->redrawn = 0;
+    for (int i = 0; i < ui->count; i++) {
+        ui_label_t *label = &ui->labels[i];
+        if (!label->changed) continue;
+
+        //copy mode overwrites the old glyphs, so only the tail past the new text needs clearing
+        int end = ssd1306_draw_text(ui->oled, label->x, label->y, label->text, label->font, GFX_COPY);
+        int w = (label->text[0]) ? end - label->x - label->font->spacing : 0;
+        if (w < label->drawn_w) {
+            ssd1306_fill_rect(ui->oled, label->x + w, label->y, label->drawn_w - w, label->font->height, false);
+        }
+
+        label->drawn_w = (uint8_t)((w > DISPLAY_WIDTH) ? DISPLAY_WIDTH : w);
+        label->changed = false;
+        ui->redrawn |= 1u << i;
+    }
+    return ui->redrawn;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include "ssd1306.h"
+#include "font.h"
+
+/*
+  Retained-mode text labels on top of the ssd1306 framebuffer.
+  - Register each label once with a position and font (font choice sets the scale)
+  - ui_label_set only stores text; nothing is drawn unless the text actually changed
+  - ui_render re-rasterizes changed labels in place and leaves the rest of the buffer alone,
+    so the dirty tracking in ssd1306_show_dirty only picks up what changed
+*/
+
+#define UI_MAX_LABELS 16 //bit per label in ui_t::redrawn, so at most 32
+#define UI_LABEL_LEN 32 //max text length per label, including terminator
+
+typedef struct {
+    int16_t x;
+    int16_t y;
+    const font_t *font;
+
+    char text[UI_LABEL_LEN]; //text the label should show
+    uint8_t drawn_w; //pixel width currently on screen; used to erase leftovers when text gets shorter
+    bool changed; //text differs from what is on screen
+} ui_label_t;
+
+typedef struct {
+    ssd1306_t *oled;
+
+    ui_label_t labels[UI_MAX_LABELS];
+    uint8_t count;
+
+    uint32_t redrawn; //bit n set = label n was redrawn by the last ui_render
+} ui_t;
+
+//binds the ui to a display; starts with no labels
+void ui_init(ui_t *ui, ssd1306_t *oled);
+
+//registers a label with its top left corner at x,y; returns its id or -1 if full
+int ui_label_add(ui_t *ui, int x, int y, const font_t *font);
+
+//sets a label's text; returns true if it differs from the current text (label will be redrawn)
+bool ui_label_set(ui_t *ui, int id, const char *text);
+
+//forces every label to be redrawn next render (e.g. after clearing the buffer)
+void ui_invalidate(ui_t *ui);
+
+//redraws changed labels into the framebuffer; returns the ui_t::redrawn bitmask
+uint32_t ui_render(ui_t *ui);
@@ -0,0 +1,29 @@
+#include "readings.h"
+#include <string.h>
+
+void readings_init(readings_snapshot_t *snap){
+    atomic_init(&snap->seq, 0);
+    memset(&snap->data, 0, sizeof(snap->data));
+}
+
+void readings_publish(readings_snapshot_t *snap, readings_t *r){
+    uint_fast32_t seq = atomic_load_explicit(&snap->seq, memory_order_relaxed);
+    r->sample_no++;
+
+    atomic_store_explicit(&snap->seq, seq + 1, memory_order_relaxed); //odd: readers will retry
+    atomic_thread_fence(memory_order_release); //odd sequence is visible before any data changes
+    memcpy(&snap->data, r, sizeof(*r));
+    atomic_store_explicit(&snap->seq, seq + 2, memory_order_release); //even again, data complete
+}
+
+void readings_read(readings_snapshot_t *snap, readings_t *out){
+    uint_fast32_t before, after;
+    do {
+        before = atomic_load_explicit(&snap->seq, memory_order_acquire);
+        if (before & 1u) continue; //publish in progress
+
+        memcpy(out, &snap->data, sizeof(*out));
+        atomic_thread_fence(memory_order_acquire); //copy completes before the sequence is re-read
+        after = atomic_load_explicit(&snap->seq, memory_order_relaxed);
+    } while ((before & 1u) || before != after);
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/*
+  Latest sensor readings, handed from the acquisition side to the rendering side.
+  - One writer (sensor task), any number of readers; no locks, readers never block the writer
+  - Seqlock: sequence is odd while a publish is in progress; readers retry if it was odd
+    or changed while they copied
+  - Only C11 atomics, so the same code runs core0/core1 on the Pico or two pthreads on a host
+*/
+
+typedef enum {
+    READING_NONE = 0, //nothing measured yet
+    READING_OK = 1,
+    READING_ERR = 2 //last attempt failed
+} reading_state_t;
+
+typedef struct {
+    int32_t lux_mlux; //milli-lux
+    int32_t temp_cc; //centi-degrees C
+    int32_t humidity_cp; //centi-percent RH
+    int score; //0-10
+
+    uint8_t lux_state; //reading_state_t
+    uint8_t climate_state; //reading_state_t, temp + humidity
+
+    uint32_t sample_no; //incremented on every publish
+} readings_t;
+
+typedef struct {
+    atomic_uint_fast32_t seq;
+    readings_t data;
+} readings_snapshot_t;
+
+//zeroes the snapshot; call before either side starts
+void readings_init(readings_snapshot_t *snap);
+
+//writer side; copies r in and bumps its sample_no (single writer only)
+void readings_publish(readings_snapshot_t *snap, readings_t *r);
+
+//reader side; copies a consistent snapshot into out, retrying while a publish is in progress
+void readings_read(readings_snapshot_t *snap, readings_t *out);
@@ -0,0 +1,100 @@
+#include "sched.h"
+#include <stdio.h>
+
+void sched_init(sched_t *s, sched_clock_fn now, sched_wait_fn wait_until){
+    s->count = 0;
+    s->now = now;
+    s->wait_until = wait_until;
+    s->idle_us = 0;
+    s->stats_since_us = now();
+}
+
+int sched_add(sched_t *s, const char *name, sched_task_fn fn, void *ctx, uint32_t period_us, uint32_t deadline_us, uint32_t offset_us){
+    if (!s || !fn || period_us == 0 || s->count >= SCHED_MAX_TASKS) return -1;
+
+    sched_task_t *t = &s->tasks[s->count];
+    *t = (sched_task_t){0};
+    t->name = name;
+    t->fn = fn;
+    t->ctx = ctx;
+    t->period_us = period_us;
+    t->deadline_us = deadline_us ? deadline_us : period_us;
+    t->release_us = s->now() + offset_us;
+    return s->count++;
+}
+
+//helper; ready task with the earliest absolute deadline, or NULL (next_release gets the earliest future release)
+static sched_task_t *sched_pick(sched_t *s, uint64_t now, uint64_t *next_release){
+    sched_task_t *best = NULL;
+    *next_release = UINT64_MAX;
+
+    for (int i = 0; i < s->count; i++) {
+        sched_task_t *t = &s->tasks[i];
+        if (t->release_us > now) {
+            if (t->release_us < *next_release) *next_release = t->release_us;
+            continue;
+        }
+        if (!best || t->release_us + t->deadline_us < best->release_us + best->deadline_us) best = t;
+    }
+    return best;
+}
+
+void sched_run_once(sched_t *s){
+    uint64_t now = s->now();
+    uint64_t next_release;
+    sched_task_t *t = sched_pick(s, now, &next_release);
+
+    if (!t) { //nothing due; idle until the next release
+        if (next_release == UINT64_MAX) return;
+        s->wait_until(next_release);
+        s->idle_us += s->now() - now;
+        return;
+    }
+
+    uint64_t start = now;
+    t->fn(t->ctx);
+    uint64_t end = s->now();
+
+    uint32_t run = (uint32_t)(end - start);
+    uint32_t late = (uint32_t)(start - t->release_us);
+    t->runs++;
+    t->last_run_us = run;
+    t->total_run_us += run;
+    if (run > t->max_run_us) t->max_run_us = run;
+    if (late > t->max_late_us) t->max_late_us = late;
+    if (end > t->release_us + t->deadline_us) t->missed++;
+
+    //next release stays on the period grid; periods already over are dropped rather than run back to back
+    t->release_us += t->period_us;
+    if (t->release_us <= end) {
+        uint64_t behind = (end - t->release_us) / t->period_us + 1;
+        t->skipped += (uint32_t)behind;
+        t->release_us += behind * t->period_us;
+    }
+}
+
+void sched_reset_stats(sched_t *s){
+    for (int i = 0; i < s->count; i++) {
+        sched_task_t *t = &s->tasks[i];
+        t->runs = t->missed = t->skipped = 0;
+        t->last_run_us = t->max_run_us = t->max_late_us = 0;
+        t->total_run_us = 0;
+    }
+    s->idle_us = 0;
+    s->stats_since_us = s->now();
+}
+
+void sched_report(const sched_t *s){
+    uint64_t window = s->now() - s->stats_since_us;
+    printf("\n%-10s %8s %8s %8s %8s %6s %6s\n", "task", "runs", "avg_us", "max_us", "late_us", "miss", "skip");
+    for (int i = 0; i < s->count; i++) {
+        const sched_task_t *t = &s->tasks[i];
+        unsigned long avg = t->runs ? (unsigned long)(t->total_run_us / t->runs) : 0;
+        printf("%-10s %8lu %8lu %8lu %8lu %6lu %6lu\n", t->name ? t->name : "?",
+            (unsigned long)t->runs, avg, (unsigned long)t->max_run_us, (unsigned long)t->max_late_us,
+            (unsigned long)t->missed, (unsigned long)t->skipped);
+    }
+    if (window) {
+        printf("idle %lu%% of %lu ms\n", (unsigned long)(s->idle_us * 100 / window), (unsigned long)(window / 1000));
+    }
+}
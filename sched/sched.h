@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+  Cooperative deadline scheduler.
+  - Each task has its own period and relative deadline; the ready task with the earliest
+    absolute deadline runs first, to completion (tasks must not block)
+  - Time comes from a clock function and idle time goes to a wait function, so the same code runs
+    on the Pico (sched_pico.h, hardware timer) or on a host with a simulated clock
+  - Per task it records run time, start lateness and missed deadlines
+*/
+
+#define SCHED_MAX_TASKS 8
+
+typedef uint64_t (*sched_clock_fn)(void); //current time in microseconds
+typedef void (*sched_wait_fn)(uint64_t until_us); //idle until the given time (may return early)
+typedef void (*sched_task_fn)(void *ctx);
+
+typedef struct {
+    const char *name;
+    sched_task_fn fn;
+    void *ctx;
+
+    uint32_t period_us; //release interval
+    uint32_t deadline_us; //must finish this long after release
+    uint64_t release_us; //next release time
+
+    //stats
+    uint32_t runs;
+    uint32_t missed; //finished after release + deadline
+    uint32_t skipped; //whole periods dropped because the task fell behind
+    uint32_t last_run_us;
+    uint32_t max_run_us;
+    uint64_t total_run_us;
+    uint32_t max_late_us; //worst start time after release
+} sched_task_t;
+
+typedef struct {
+    sched_task_t tasks[SCHED_MAX_TASKS];
+    uint8_t count;
+
+    sched_clock_fn now;
+    sched_wait_fn wait_until;
+
+    uint64_t idle_us; //time handed to wait_until since the last stats reset
+    uint64_t stats_since_us;
+} sched_t;
+
+//empties the task list and sets the time source
+void sched_init(sched_t *s, sched_clock_fn now, sched_wait_fn wait_until);
+
+//adds a task, first released offset_us from now; deadline 0 means deadline = period; returns its index or -1
+int sched_add(sched_t *s, const char *name, sched_task_fn fn, void *ctx, uint32_t period_us, uint32_t deadline_us, uint32_t offset_us);
+
+//waits for the next release if nothing is due, then runs one task
+void sched_run_once(sched_t *s);
+
+//zeroes every task's stats and the idle counter
+void sched_reset_stats(sched_t *s);
+
+//prints a per-task stats table to stdout
+void sched_report(const sched_t *s);
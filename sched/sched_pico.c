@@ -0,0 +1,10 @@
+#include "sched_pico.h"
+#include "pico/stdlib.h"
+
+uint64_t sched_pico_now(void){
+    return time_us_64();
+}
+
+void sched_pico_wait_until(uint64_t until_us){
+    sleep_until(from_us_since_boot(until_us)); //alarm pool alarm + __wfe, so the core idles instead of spinning
+}
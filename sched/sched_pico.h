@@ -0,0 +1,8 @@
+#pragma once
+#include <stdint.h>
+
+//sched_t time source backed by the RP2040 64-bit hardware timer
+uint64_t sched_pico_now(void);
+
+//sleeps the core (WFE) until a hardware timer alarm at until_us wakes it
+void sched_pico_wait_until(uint64_t until_us);
@@ -0,0 +1,25 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+  Raw NOR flash region, addressed from 0.
+  - Program works on whole erased pages; erase works on whole sectors
+  - Function pointers so the log above it can run on the Pico (flash_rp2040.h) or against
+    a file-backed image on a host
+*/
+
+#define FLASH_DEV_PAGE 256u
+#define FLASH_DEV_SECTOR 4096u
+
+typedef bool (*flash_read_fn)(void *ctx, uint32_t off, void *buf, uint32_t len);
+typedef bool (*flash_prog_fn)(void *ctx, uint32_t off, const void *buf, uint32_t len); //page aligned, len a multiple of pages
+typedef bool (*flash_erase_fn)(void *ctx, uint32_t off); //one sector, sector aligned
+
+typedef struct {
+    uint32_t size; //bytes, a multiple of FLASH_DEV_SECTOR
+    flash_read_fn read;
+    flash_prog_fn prog;
+    flash_erase_fn erase;
+    void *ctx;
+} flash_dev_t;
@@ -0,0 +1,244 @@
+#include "flash_log.h"
+#include <stdio.h>
+#include <string.h>
+#include "crc16.h"
+
+#define LOG_MAGIC 0x474C4547u //"GELG"
+#define HEADER_BYTES 10 //magic, seq, crc16
+#define ERASED 0xFF
+
+static inline void put_u32(uint8_t *p, uint32_t v){
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+static inline uint32_t get_u32(const uint8_t *p){
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+//reads a sector header; false if erased, torn or not ours
+static bool read_header(const flash_log_t *log, uint32_t sector, uint32_t *seq){
+    uint8_t h[HEADER_BYTES];
+    if (!log->dev->read(log->dev->ctx, sector * FLASH_DEV_SECTOR, h, sizeof(h))) return false;
+    if (get_u32(h) != LOG_MAGIC) return false;
+    if (crc16_ccitt(h, 8) != (uint16_t)(h[8] | (h[9] << 8))) return false;
+    *seq = get_u32(h + 4);
+    return true;
+}
+
+static bool page_erased(const uint8_t *page){
+    for (uint32_t i = 0; i < FLASH_DEV_PAGE; i++) {
+        if (page[i] != ERASED) return false;
+    }
+    return true;
+}
+
+bool flash_log_init(flash_log_t *log, const flash_dev_t *dev){
+    memset(log, 0, sizeof(*log));
+    memset(log->buf, ERASED, sizeof(log->buf));
+    log->dev = dev;
+    log->nsectors = dev->size / FLASH_DEV_SECTOR;
+    log->sector = FLASH_LOG_NO_SECTOR;
+    if (log->nsectors < 2) return false;
+
+    //newest sector = highest sequence number; only the headers are read
+    for (uint32_t s = 0; s < log->nsectors; s++) {
+        uint32_t seq;
+        if (!read_header(log, s, &seq)) continue;
+        if (log->sector == FLASH_LOG_NO_SECTOR || seq > log->seq) {
+            log->sector = s;
+            log->seq = seq;
+        }
+    }
+    if (log->sector == FLASH_LOG_NO_SECTOR) return true; //blank; first flush opens sector 0
+
+    //resume after the last programmed page; a torn page is not erased, so it is never reused
+    uint8_t page[FLASH_DEV_PAGE];
+    log->page = FLASH_LOG_PAGES_PER_SECTOR; //full unless an erased page turns up
+    for (uint32_t p = 1; p < FLASH_LOG_PAGES_PER_SECTOR; p++) {
+        if (!dev->read(dev->ctx, log->sector * FLASH_DEV_SECTOR + p * FLASH_DEV_PAGE, page, sizeof(page))) return false;
+        if (page_erased(page)) {
+            log->page = p;
+            break;
+        }
+    }
+    return true;
+}
+
+//erases the next sector round robin and stamps its header
+static bool open_next_sector(flash_log_t *log){
+    uint32_t next = (log->sector == FLASH_LOG_NO_SECTOR) ? 0 : (log->sector + 1) % log->nsectors;
+    uint32_t seq = (log->sector == FLASH_LOG_NO_SECTOR) ? 1 : log->seq + 1;
+
+    uint8_t h[FLASH_DEV_PAGE];
+    uint32_t old_seq;
+    if (read_header(log, next, &old_seq)) {
+        //an erase cut short by power loss can leave the old header over half-erased pages, which would read as
+        //a valid sector with a hole in it; zeroing the header first (program only clears bits) retires it
+        memset(h, ERASED, sizeof(h));
+        memset(h, 0x00, HEADER_BYTES);
+        if (!log->dev->prog(log->dev->ctx, next * FLASH_DEV_SECTOR, h, sizeof(h))) return false;
+    }
+    if (!log->dev->erase(log->dev->ctx, next * FLASH_DEV_SECTOR)) return false;
+    log->sectors_erased++;
+
+    memset(h, ERASED, sizeof(h));
+    put_u32(h, LOG_MAGIC);
+    put_u32(h + 4, seq);
+    uint16_t crc = crc16_ccitt(h, 8);
+    h[8] = (uint8_t)crc;
+    h[9] = (uint8_t)(crc >> 8);
+    if (!log->dev->prog(log->dev->ctx, next * FLASH_DEV_SECTOR, h, sizeof(h))) return false;
+
+    log->sector = next;
+    log->seq = seq;
+    log->page = 1;
+    return true;
+}
+
+bool flash_log_flush(flash_log_t *log){
+    if (log->buf_len == 0) return true;
+
+    if (log->sector == FLASH_LOG_NO_SECTOR || log->page >= FLASH_LOG_PAGES_PER_SECTOR) {
+        if (!open_next_sector(log)) return false;
+    }
+    //unused tail is already 0xFF, which reads back as end of page
+    if (!log->dev->prog(log->dev->ctx, log->sector * FLASH_DEV_SECTOR + log->page * FLASH_DEV_PAGE, log->buf, FLASH_DEV_PAGE)) {
+        return false;
+    }
+    log->page++;
+    log->pages_written++;
+    log->buf_len = 0;
+    memset(log->buf, ERASED, sizeof(log->buf));
+    return true;
+}
+
+bool flash_log_append(flash_log_t *log, const void *rec, uint32_t len){
+    if (len == 0 || len > FLASH_LOG_MAX_RECORD) return false;
+
+    uint32_t need = len + 3;
+    if (log->buf_len + need > FLASH_DEV_PAGE && !flash_log_flush(log)) {
+        log->dropped++;
+        return false;
+    }
+
+    uint8_t *p = &log->buf[log->buf_len];
+    p[0] = (uint8_t)len;
+    memcpy(p + 1, rec, len);
+    uint16_t crc = crc16_ccitt(p, len + 1); //covers the length too
+    p[len + 1] = (uint8_t)crc;
+    p[len + 2] = (uint8_t)(crc >> 8);
+    log->buf_len += need;
+    log->records++;
+    return true;
+}
+
+void flash_log_reader_init(flash_log_reader_t *r, const flash_log_t *log){
+    memset(r, 0, sizeof(*r));
+    r->log = log;
+    r->start = (log->sector == FLASH_LOG_NO_SECTOR) ? 0 : (log->sector + 1) % log->nsectors;
+    r->off = FLASH_DEV_PAGE; //nothing loaded; the first read pulls a page
+}
+
+//loads the next page to parse: data pages of valid sectors oldest first, then the RAM buffer
+static bool reader_next_page(flash_log_reader_t *r){
+    const flash_log_t *log = r->log;
+    r->off = 0;
+
+    while (true) {
+        if (r->sector_valid && r->page + 1 < FLASH_LOG_PAGES_PER_SECTOR) {
+            r->page++;
+            return log->dev->read(log->dev->ctx, r->sector * FLASH_DEV_SECTOR + r->page * FLASH_DEV_PAGE, r->page_buf, FLASH_DEV_PAGE);
+        }
+        if (r->steps == log->nsectors) {
+            if (r->in_ram) return false;
+            r->in_ram = true;
+            r->sector_valid = false;
+            memcpy(r->page_buf, log->buf, FLASH_DEV_PAGE); //unused tail is 0xFF
+            return true;
+        }
+
+        r->sector = (r->start + r->steps) % log->nsectors;
+        r->steps++;
+        uint32_t seq;
+        //sequence must keep rising, so a slot overwritten since the reader started is not read out of order
+        r->sector_valid = read_header(log, r->sector, &seq) && (r->last_seq == 0 || seq > r->last_seq);
+        if (r->sector_valid) r->last_seq = seq;
+        r->page = 0;
+    }
+}
+
+//helper; length of the intact record at off in page, 0 if torn or not a record
+static uint32_t record_at(const uint8_t *page, uint32_t off){
+    const uint8_t *p = &page[off];
+    uint32_t len = p[0];
+    if (len == 0 || off + len + 3 > FLASH_DEV_PAGE ||
+        crc16_ccitt(p, len + 1) != (uint16_t)(p[len + 1] | (p[len + 2] << 8))) {
+        return 0;
+    }
+    return len;
+}
+
+uint32_t flash_log_read(flash_log_reader_t *r, void *buf, uint32_t cap){
+    while (true) {
+        if (r->off + 3 > FLASH_DEV_PAGE || r->page_buf[r->off] == ERASED) { //page used up
+            if (!reader_next_page(r)) return 0;
+            continue;
+        }
+
+        const uint8_t *p = &r->page_buf[r->off];
+        uint32_t len = record_at(r->page_buf, r->off);
+        if (len == 0) {
+            r->corrupt++; //can't trust the length any more; drop the rest of this page
+            r->off = FLASH_DEV_PAGE;
+            continue;
+        }
+
+        memcpy(buf, p + 1, (len < cap) ? len : cap);
+        r->off += len + 3;
+        return len;
+    }
+}
+
+//helper; copies the last intact record of a page into buf; returns its length, 0 if the page has none
+static uint32_t last_in_page(const uint8_t *page, void *buf, uint32_t cap){
+    uint32_t off = 0, found = 0;
+    uint32_t len;
+    while (off + 3 <= FLASH_DEV_PAGE && page[off] != ERASED && (len = record_at(page, off)) != 0) {
+        memcpy(buf, &page[off + 1], (len < cap) ? len : cap);
+        found = len;
+        off += len + 3;
+    }
+    return found;
+}
+
+//helper; newest record in data pages 1..pages-1 of a sector, walking back from the end
+static uint32_t last_in_sector(const flash_log_t *log, uint32_t sector, uint32_t pages, void *buf, uint32_t cap){
+    uint8_t page[FLASH_DEV_PAGE];
+    for (uint32_t p = pages; p-- > 1;) {
+        if (!log->dev->read(log->dev->ctx, sector * FLASH_DEV_SECTOR + p * FLASH_DEV_PAGE, page, sizeof(page))) return 0;
+        uint32_t len = last_in_page(page, buf, cap);
+        if (len) return len;
+    }
+    return 0;
+}
+
+uint32_t flash_log_last(const flash_log_t *log, void *buf, uint32_t cap){
+    uint32_t len = last_in_page(log->buf, buf, cap);
+    if (len || log->sector == FLASH_LOG_NO_SECTOR) return len;
+
+    len = last_in_sector(log, log->sector, log->page, buf, cap);
+    if (len) return len;
+
+    //newest sector was opened but holds nothing yet; the tail is in the one before it
+    uint32_t prev = (log->sector + log->nsectors - 1) % log->nsectors;
+    uint32_t seq;
+    if (!read_header(log, prev, &seq) || seq + 1 != log->seq) return 0;
+    return last_in_sector(log, prev, FLASH_LOG_PAGES_PER_SECTOR, buf, cap);
+}
+
+void flash_log_report(const flash_log_t *log){
+    printf("flash log: %lu sectors, sector %ld seq %lu page %lu, %lu records, %lu pages, %lu erases, %lu dropped\n",
+        (unsigned long)log->nsectors, (log->sector == FLASH_LOG_NO_SECTOR) ? -1L : (long)log->sector,
+        (unsigned long)log->seq, (unsigned long)log->page, (unsigned long)log->records,
+        (unsigned long)log->pages_written, (unsigned long)log->sectors_erased, (unsigned long)log->dropped);
+}
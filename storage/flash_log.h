@@ -0,0 +1,73 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "flash_dev.h"
+
+/*
+  Append-only record log on a flash_dev_t.
+  - Records are batched in a RAM page and programmed one page at a time
+  - Sectors are used round robin, so every sector sees the same number of erases; the oldest
+    sector is erased when the log wraps
+  - Page 0 of a sector is a header (magic, sequence number, crc); recovery only reads headers,
+    plus the pages of the newest sector to find the first erased one
+  - Each record is [len][payload][crc16]; a torn page write fails the crc and the rest of that
+    page is skipped, everything before it is kept
+*/
+
+#define FLASH_LOG_PAGES_PER_SECTOR (FLASH_DEV_SECTOR / FLASH_DEV_PAGE)
+#define FLASH_LOG_MAX_RECORD (FLASH_DEV_PAGE - 3) //len byte + crc16
+#define FLASH_LOG_NO_SECTOR 0xFFFFFFFFu
+
+typedef struct {
+    const flash_dev_t *dev;
+    uint32_t nsectors;
+
+    uint32_t sector; //sector being filled, FLASH_LOG_NO_SECTOR if the log is empty
+    uint32_t seq; //its sequence number
+    uint32_t page; //next page to program in it
+
+    uint8_t buf[FLASH_DEV_PAGE]; //records not programmed yet
+    uint32_t buf_len;
+
+    //stats
+    uint32_t records;
+    uint32_t dropped; //append failed (flash error)
+    uint32_t pages_written;
+    uint32_t sectors_erased;
+} flash_log_t;
+
+//streaming reader; oldest record first, ends with the ones still in RAM
+typedef struct {
+    const flash_log_t *log;
+    uint32_t start; //oldest sector slot
+    uint32_t steps; //sectors entered so far
+    uint32_t sector;
+    uint32_t page;
+    bool sector_valid;
+    bool in_ram;
+    uint32_t last_seq;
+    uint32_t off;
+    uint8_t page_buf[FLASH_DEV_PAGE];
+
+    uint32_t corrupt; //pages cut short by a bad crc
+} flash_log_reader_t;
+
+//recovers the write position from the sector headers; false if the device is too small
+bool flash_log_init(flash_log_t *log, const flash_dev_t *dev);
+
+//queues one record (1..FLASH_LOG_MAX_RECORD bytes); programs the page buffer when it fills
+bool flash_log_append(flash_log_t *log, const void *rec, uint32_t len);
+
+//programs a partly filled page buffer now (e.g. before a planned power-off); the rest of that page is left unused
+bool flash_log_flush(flash_log_t *log);
+
+void flash_log_reader_init(flash_log_reader_t *r, const flash_log_t *log);
+
+//copies the next record into buf (truncated to cap); returns its length, or 0 at the end
+uint32_t flash_log_read(flash_log_reader_t *r, void *buf, uint32_t cap);
+
+//copies the newest record (RAM buffer included) into buf (truncated to cap); returns its length, 0 if the log is empty.
+//reads at most two sectors, so it is cheap enough for boot, unlike a full pass with the reader
+uint32_t flash_log_last(const flash_log_t *log, void *buf, uint32_t cap);
+
+void flash_log_report(const flash_log_t *log);
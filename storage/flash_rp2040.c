@@ -0,0 +1,59 @@
+#include "flash_rp2040.h"
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/flash.h"
+#include "hardware/flash.h"
+
+#define SAFE_TIMEOUT_MS 100 //waiting for the other core to park
+
+extern char __flash_binary_end; //linker symbol; first byte after the image in the xip window
+
+static uint32_t region_base; //flash offset of our offset 0
+
+typedef struct {
+    uint32_t off;
+    const void *buf;
+    uint32_t len;
+} flash_op_t;
+
+//run with the other core parked and interrupts off; nothing may execute from flash meanwhile
+static void do_prog(void *param){
+    const flash_op_t *op = (const flash_op_t *)param;
+    flash_range_program(op->off, (const uint8_t *)op->buf, op->len);
+}
+
+static void do_erase(void *param){
+    const flash_op_t *op = (const flash_op_t *)param;
+    flash_range_erase(op->off, FLASH_SECTOR_SIZE);
+}
+
+static bool rp2040_read(void *ctx, uint32_t off, void *buf, uint32_t len){
+    memcpy(buf, (const void *)(uintptr_t)(XIP_BASE + region_base + off), len); //memory mapped
+    return true;
+}
+
+static bool rp2040_prog(void *ctx, uint32_t off, const void *buf, uint32_t len){
+    flash_op_t op = {region_base + off, buf, len};
+    return flash_safe_execute(do_prog, &op, SAFE_TIMEOUT_MS) == PICO_OK;
+}
+
+static bool rp2040_erase(void *ctx, uint32_t off){
+    flash_op_t op = {region_base + off, NULL, 0};
+    return flash_safe_execute(do_erase, &op, SAFE_TIMEOUT_MS) == PICO_OK;
+}
+
+bool flash_rp2040_init(flash_dev_t *dev, uint32_t max_bytes){
+    uint32_t image_end = (uint32_t)((uintptr_t)&__flash_binary_end - XIP_BASE);
+    region_base = (image_end + FLASH_SECTOR_SIZE - 1) & ~(FLASH_SECTOR_SIZE - 1);
+    if(region_base >= PICO_FLASH_SIZE_BYTES){ return false; }
+
+    uint32_t size = PICO_FLASH_SIZE_BYTES - region_base;
+    if(max_bytes && size > max_bytes){ size = max_bytes & ~(FLASH_SECTOR_SIZE - 1); }
+
+    dev->size = size;
+    dev->read = rp2040_read;
+    dev->prog = rp2040_prog;
+    dev->erase = rp2040_erase;
+    dev->ctx = NULL;
+    return size > 0;
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "flash_dev.h"
+
+//spare qspi flash after the firmware image, up to max_bytes (0 = all of it); false if there is none
+//erase/program go through flash_safe_execute, so core1 must have called flash_safe_execute_core_init()
+bool flash_rp2040_init(flash_dev_t *dev, uint32_t max_bytes);
@@ -0,0 +1,81 @@
+#include "telemetry.h"
+#include "crc16.h"
+
+static inline uint8_t *put_u16(uint8_t *p, uint16_t v){
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static inline uint8_t *put_u32(uint8_t *p, uint32_t v){
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+uint32_t cobs_encode(const uint8_t *in, uint32_t len, uint8_t *out){
+    uint32_t code_at = 0, o = 1;
+    uint8_t code = 1;
+    for (uint32_t i = 0; i < len; i++) {
+        if (in[i] == 0) { //close the block; its code byte says where this zero was
+            out[code_at] = code;
+            code_at = o++;
+            code = 1;
+            continue;
+        }
+        out[o++] = in[i];
+        if (++code == 0xFF) { //254 non-zero bytes; block ends without an implied zero
+            out[code_at] = code;
+            code_at = o++;
+            code = 1;
+        }
+    }
+    out[code_at] = code;
+    return o;
+}
+
+void telem_init(telem_t *t, telem_write_fn write, void *ctx){
+    t->write = write;
+    t->ctx = ctx;
+    t->count = 0;
+    t->seq = 0;
+    t->frames = 0;
+    t->bytes = 0;
+}
+
+void telem_flush(telem_t *t){
+    if (t->count == 0) return;
+
+    uint8_t payload[TELEM_PAYLOAD_MAX];
+    uint8_t *p = payload;
+    *p++ = TELEM_VERSION;
+    *p++ = TELEM_TYPE_SAMPLES;
+    p = put_u16(p, t->seq);
+    *p++ = t->count;
+    for (uint8_t i = 0; i < t->count; i++) {
+        const telem_sample_t *s = &t->batch[i];
+        p = put_u32(p, s->uptime_ms);
+        p = put_u32(p, (uint32_t)s->temp_cc);
+        p = put_u32(p, (uint32_t)s->humidity_cp);
+        p = put_u32(p, (uint32_t)s->lux_mlux);
+        *p++ = s->score;
+        *p++ = s->flags;
+    }
+    uint32_t len = (uint32_t)(p - payload);
+    p = put_u16(p, crc16_ccitt(payload, len));
+    len += 2;
+
+    uint8_t frame[TELEM_FRAME_MAX];
+    frame[0] = 0x00; //ends whatever came before, so this frame decodes cleanly
+    uint32_t n = 1 + cobs_encode(payload, len, frame + 1);
+    frame[n++] = 0x00;
+
+    t->write(frame, n, t->ctx);
+    t->frames++;
+    t->bytes += n;
+    t->seq++;
+    t->count = 0;
+}
+
+void telem_push(telem_t *t, const telem_sample_t *s){
+    t->batch[t->count++] = *s;
+    if (t->count == TELEM_BATCH) telem_flush(t);
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+  Binary telemetry frames, the machine-readable alternative to the printf log.
+  - Fixed little-endian layout: version, type, frame seq, sample count, samples, crc16
+  - COBS framed with a 0x00 before and after, so a decoder resyncs on the next frame after any
+    garbage (e.g. a stray text line) and never has to guess lengths
+  - Samples are batched TELEM_BATCH per frame so one frame fills most of a 64-byte USB packet
+  - Decoder: tools/telemetry_decode.py
+*/
+
+#define TELEM_VERSION 1
+#define TELEM_TYPE_SAMPLES 1
+#define TELEM_BATCH 3
+#define TELEM_HEADER_BYTES 5 //version, type, seq (2), count
+#define TELEM_SAMPLE_BYTES 18
+#define TELEM_PAYLOAD_MAX (TELEM_HEADER_BYTES + TELEM_BATCH * TELEM_SAMPLE_BYTES + 2)
+#define TELEM_FRAME_MAX (TELEM_PAYLOAD_MAX + TELEM_PAYLOAD_MAX / 254 + 1 + 2) //cobs overhead + both delimiters
+
+typedef void (*telem_write_fn)(const uint8_t *buf, uint32_t len, void *ctx);
+
+typedef struct {
+    uint32_t uptime_ms;
+    int32_t temp_cc; //centi-degrees C
+    int32_t humidity_cp; //centi-percent RH
+    int32_t lux_mlux; //milli-lux
+    uint8_t score;
+    uint8_t flags; //bits 0-1 lux reading_state_t, bits 2-3 climate reading_state_t
+} telem_sample_t;
+
+typedef struct {
+    telem_write_fn write;
+    void *ctx;
+
+    telem_sample_t batch[TELEM_BATCH];
+    uint8_t count;
+    uint16_t seq; //per frame; gaps on the host side mean lost frames
+
+    uint32_t frames;
+    uint32_t bytes;
+} telem_t;
+
+void telem_init(telem_t *t, telem_write_fn write, void *ctx);
+
+//queues a sample; a frame goes out when the batch is full
+void telem_push(telem_t *t, const telem_sample_t *s);
+
+//sends a partial batch now
+void telem_flush(telem_t *t);
+
+//cobs encodes len bytes from in into out (len + len / 254 + 1 bytes max); returns encoded length
+uint32_t cobs_encode(const uint8_t *in, uint32_t len, uint8_t *out);
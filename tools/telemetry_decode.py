@@ -0,0 +1,205 @@
+#!/usr/bin/env python3
+"""
+Decoder for greeneye binary telemetry (telemetry/telemetry.h).
+
+Frames are COBS encoded and delimited by 0x00:
+    version u8 | type u8 | seq u16 | count u8 | count x sample | crc16 u16
+    sample = uptime_ms u32, temp_cc i32, humidity_cp i32, lux_mlux i32, score u8, flags u8
+All little-endian; crc16-ccitt-false (0x1021, init 0xFFFF) over everything before it.
+
+usage:
+    telemetry_decode.py /dev/ttyACM0            # live, one CSV line per sample
+    telemetry_decode.py capture.bin             # a saved capture
+    telemetry_decode.py --bench 200000          # decode throughput on synthetic frames
+"""
+import argparse
+import os
+import random
+import struct
+import sys
+import time
+
+VERSION = 1
+TYPE_SAMPLES = 1
+HEADER = struct.Struct("<BBHB")
+SAMPLE = struct.Struct("<IiiiBB")
+CRC = struct.Struct("<H")
+STATES = ("none", "ok", "err")
+
+
+def _crc_table():
+    table = []
+    for i in range(256):
+        crc = i << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+        table.append(crc & 0xFFFF)
+    return table
+
+
+CRC_TABLE = _crc_table()
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for b in data:
+        crc = ((crc << 8) & 0xFFFF) ^ CRC_TABLE[(crc >> 8) ^ b]
+    return crc
+
+
+def cobs_decode(frame):
+    out = bytearray()
+    i, n = 0, len(frame)
+    while i < n:
+        code = frame[i]
+        if code == 0 or i + code > n:
+            raise ValueError("bad cobs code")
+        out += frame[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < n:
+            out.append(0)
+    return bytes(out)
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code_at, code = 0, 1
+    for b in data:
+        if b == 0:
+            out[code_at] = code
+            code_at, code = len(out), 1
+            out.append(0)
+            continue
+        out.append(b)
+        code += 1
+        if code == 0xFF:
+            out[code_at] = code
+            code_at, code = len(out), 1
+            out.append(0)
+    out[code_at] = code
+    return bytes(out)
+
+
+class Decoder:
+    """Feed raw bytes, get sample dicts back; counts bad frames and sequence gaps."""
+
+    def __init__(self):
+        self.pending = b""
+        self.frames = 0
+        self.samples = 0
+        self.bad = 0
+        self.lost = 0
+        self.last_seq = None
+
+    def feed(self, data):
+        chunks = (self.pending + data).split(b"\x00")
+        self.pending = chunks.pop()  # no delimiter yet; wait for the rest
+        out = []
+        for chunk in chunks:
+            if chunk:
+                self._frame(chunk, out)
+        return out
+
+    def _frame(self, chunk, out):
+        try:
+            payload = cobs_decode(chunk)
+        except ValueError:
+            self.bad += 1
+            return
+        if len(payload) < HEADER.size + CRC.size or crc16(payload[:-2]) != CRC.unpack_from(payload, len(payload) - 2)[0]:
+            self.bad += 1  # also where stray text lands
+            return
+        version, ftype, seq, count = HEADER.unpack_from(payload)
+        if version != VERSION or ftype != TYPE_SAMPLES or len(payload) != HEADER.size + count * SAMPLE.size + CRC.size:
+            self.bad += 1
+            return
+
+        if self.last_seq is not None:
+            self.lost += (seq - self.last_seq - 1) & 0xFFFF
+        self.last_seq = seq
+        self.frames += 1
+        self.samples += count
+
+        for i in range(count):
+            up, t, h, lux, score, flags = SAMPLE.unpack_from(payload, HEADER.size + i * SAMPLE.size)
+            out.append({
+                "uptime_ms": up, "temp_c": t / 100, "humidity": h / 100, "lux": lux / 1000, "score": score,
+                "lux_state": STATES[flags & 3] if flags & 3 < 3 else "?",
+                "climate_state": STATES[(flags >> 2) & 3] if (flags >> 2) & 3 < 3 else "?",
+            })
+
+
+def encode_frame(seq, samples):
+    payload = HEADER.pack(VERSION, TYPE_SAMPLES, seq & 0xFFFF, len(samples))
+    payload += b"".join(SAMPLE.pack(*s) for s in samples)
+    payload += CRC.pack(crc16(payload))
+    return b"\x00" + cobs_encode(payload) + b"\x00"
+
+
+def bench(nframes, batch=3):
+    rng = random.Random(1)
+    frames = []
+    for seq in range(nframes):
+        samples = [(seq * 1500 + i * 500, rng.randint(1500, 3000), rng.randint(2000, 8000),
+                    rng.randint(0, 100000000), rng.randint(0, 10), 5) for i in range(batch)]
+        frames.append(encode_frame(seq, samples))
+    stream = b"".join(frames)
+
+    dec = Decoder()
+    start = time.perf_counter()
+    for off in range(0, len(stream), 4096):  # roughly how reads arrive from a tty
+        dec.feed(stream[off:off + 4096])
+    elapsed = time.perf_counter() - start
+
+    assert dec.frames == nframes and dec.bad == 0 and dec.lost == 0, "round trip failed"
+    per_device = 1 / 0.5  # firmware samples every 500 ms
+    rate = dec.samples / elapsed
+    print(f"{nframes} frames, {len(stream)} bytes in {elapsed:.3f} s")
+    print(f"{len(stream) / elapsed / 1e6:.2f} MB/s, {dec.frames / elapsed:.0f} frames/s, {rate:.0f} samples/s")
+    print(f"~{rate / per_device:.0f} devices in real time per decoder process")
+
+
+def open_source(path):
+    if path == "-":
+        return sys.stdin.buffer
+    try:
+        import serial  # pyserial; puts the tty in raw mode
+        if os.path.exists(path) and not os.path.isfile(path):
+            return serial.Serial(path, timeout=0.1)
+    except ImportError:
+        pass
+    return open(path, "rb", buffering=0)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("source", nargs="?", help="serial port, capture file, or - for stdin")
+    ap.add_argument("--bench", type=int, metavar="FRAMES", help="measure decode throughput and exit")
+    args = ap.parse_args()
+
+    if args.bench:
+        bench(args.bench)
+        return
+    if not args.source:
+        ap.error("source is required unless --bench is given")
+
+    src = open_source(args.source)
+    dec = Decoder()
+    print("uptime_ms,temp_c,humidity,lux,score,lux_state,climate_state")
+    try:
+        while True:
+            data = src.read(4096)
+            if not data:
+                if os.path.isfile(args.source) or args.source == "-":
+                    break  # end of capture
+                continue
+            for s in dec.feed(data):
+                print(f"{s['uptime_ms']},{s['temp_c']:.2f},{s['humidity']:.2f},{s['lux']:.3f},{s['score']},"
+                      f"{s['lux_state']},{s['climate_state']}", flush=True)
+    except KeyboardInterrupt:
+        pass
+    print(f"# {dec.frames} frames, {dec.samples} samples, {dec.bad} bad, {dec.lost} lost", file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
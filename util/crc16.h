@@ -0,0 +1,5 @@
+#pragma once
+#include <stdint.h>
+
+//crc16-ccitt-false: poly 0x1021, init 0xFFFF, no reflection, no final xor
+uint16_t crc16_ccitt(const uint8_t *data, uint32_t len);